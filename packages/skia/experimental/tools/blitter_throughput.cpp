@@ -0,0 +1,212 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how fast the specialized N32 blitters (see SkCreateSpecializedN32Blitter()) fill next to
+// the raster pipeline and SkVM blitters they stand in for, for solid colors and for images sampled
+// nearest and bilinear with clamping, in src and srcover.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/blitter_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o blitter_throughput
+//  ./blitter_throughput [SIZE] [LOOPS]
+//
+// Each blitter fills a SIZExSIZE (default 512) 8888 destination three ways: blitRect (full
+// coverage), blitAntiH with a different coverage per pixel, and blitMask with an A8 mask. It
+// prints the best time over LOOPS fills (default 5) in nanoseconds per pixel, or n/a for a blitter
+// that is not built (SkVM without SK_ENABLE_SKVM) or does not take the paint. After each fill's
+// times, "diff" is the largest difference, in 8-bit steps, of any channel of any pixel between one
+// specialized fill and one pipeline fill of the same destination; the specialized blitters are
+// meant to match the lowp pipeline exactly, so it should be 0. They only take paints where the
+// raster pipeline would run lowp, so they are all n/a in builds without lowp stages (e.g. not
+// compiled by Clang).
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkBlendMode.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkShader.h"
+#include "include/core/SkSurfaceProps.h"
+#include "include/core/SkTileMode.h"
+#include "src/base/SkArenaAlloc.h"
+#include "src/core/SkBlitter.h"
+#include "src/core/SkCoreBlitters.h"
+#include "src/core/SkMask.h"
+#include "src/core/SkVMBlitter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+static sk_sp<SkImage> make_image(bool opaque) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(256, 256, opaque);
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x) {
+            *bitmap.getAddr32(x, y) =
+                    SkPreMultiplyARGB(opaque ? 255 : (x + y) / 2, x, y, (x * y) >> 8);
+        }
+    }
+    return bitmap.asImage();
+}
+
+// Returns the fastest of |loops| runs of |fill|, in nanoseconds per pixel of a |size|x|size| fill.
+static double best_ns_per_px(int size, int loops, const std::function<void()>& fill) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fill();
+        const std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best / (size * (double)size);
+}
+
+// Returns the largest difference of any channel of any pixel between |a| and |b|.
+static int max_diff(const SkBitmap& a, const SkBitmap& b) {
+    int diff = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            const uint32_t pa = *a.getAddr32(x, y),
+                           pb = *b.getAddr32(x, y);
+            for (int shift = 0; shift < 32; shift += 8) {
+                diff = std::max(diff, std::abs((int)((pa >> shift) & 0xFF) -
+                                               (int)((pb >> shift) & 0xFF)));
+            }
+        }
+    }
+    return diff;
+}
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::max(2, atoi(argv[1])) : 512;
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+    SkGraphics::Init();
+
+    const SkColor background = SkColorSetARGB(0xC0, 0x20, 0x80, 0x40);
+    SkBitmap dst, specialDst, pipelineDst;
+    dst.allocN32Pixels(size, size);
+    dst.eraseColor(background);
+    specialDst.allocN32Pixels(size, size);
+    pipelineDst.allocN32Pixels(size, size);
+
+    // The same coverage for blitAntiH (one run per pixel) and the A8 mask.
+    std::vector<SkAlpha> coverage(size * size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            coverage[y * size + x] = (SkAlpha)((x * 7 + y * 3) & 0xFF);
+        }
+    }
+    std::vector<SkAlpha> aa(size);
+    std::vector<int16_t> runs(size + 1);
+
+    const auto fillRect = [&](SkBlitter* blitter) {
+        blitter->blitRect(0, 0, size, size);
+    };
+    const auto fillAntiH = [&](SkBlitter* blitter) {
+        for (int y = 0; y < size; ++y) {
+            // blitAntiH may consume the runs, so they are rebuilt for every row.
+            std::copy_n(coverage.data() + y * size, size, aa.data());
+            std::fill_n(runs.data(), size, 1);
+            runs[size] = 0;
+            blitter->blitAntiH(0, y, aa.data(), runs.data());
+        }
+    };
+    const auto fillMask = [&](SkBlitter* blitter) {
+        SkMask mask;
+        mask.fImage = coverage.data();
+        mask.fBounds = SkIRect::MakeWH(size, size);
+        mask.fRowBytes = size;
+        mask.fFormat = SkMask::kA8_Format;
+        blitter->blitMask(mask, mask.fBounds);
+    };
+
+    const sk_sp<SkImage> opaqueImage = make_image(true),
+                         image = make_image(false);
+    // A little over 2x, so that the bilinear samples fall between the pixels.
+    const SkMatrix lm = SkMatrix::Scale(size / 250.f, size / 230.f);
+    auto imagePaint = [&](const sk_sp<SkImage>& img, SkFilterMode filter) {
+        SkPaint paint;
+        paint.setShader(img->makeShader(SkTileMode::kClamp, SkTileMode::kClamp,
+                                        SkSamplingOptions(filter), &lm));
+        return paint;
+    };
+    SkPaint opaqueColor, translucentColor;
+    opaqueColor.setColor(SkColorSetARGB(0xFF, 0xC0, 0x40, 0x10));
+    translucentColor.setColor(SkColorSetARGB(0x80, 0xC0, 0x40, 0x10));
+
+    const struct {
+        const char* fName;
+        SkPaint     fPaint;
+    } paints[] = {
+        {"opaque color",     opaqueColor},
+        {"color",            translucentColor},
+        {"opaque nearest",   imagePaint(opaqueImage, SkFilterMode::kNearest)},
+        {"nearest",          imagePaint(image, SkFilterMode::kNearest)},
+        {"opaque bilinear",  imagePaint(opaqueImage, SkFilterMode::kLinear)},
+        {"bilinear",         imagePaint(image, SkFilterMode::kLinear)},
+    };
+
+    const SkSurfaceProps props;
+    printf("%dx%d, ns/px%36s%36s%36s\n", size, size, "rect", "antiH", "A8 mask");
+    printf("%-26s", "");
+    for (int i = 0; i < 3; ++i) {
+        printf("%10s%10s%10s%6s", "special", "pipeline", "skvm", "diff");
+    }
+    printf("\n");
+    for (SkBlendMode mode : {SkBlendMode::kSrcOver, SkBlendMode::kSrc}) {
+        for (const auto& [name, basePaint] : paints) {
+            SkPaint paint = basePaint;
+            paint.setBlendMode(mode);
+
+            SkSTArenaAlloc<4096> alloc;
+            SkBlitter* blitters[] = {
+                SkCreateSpecializedN32Blitter(dst.pixmap(), paint, SkMatrix::I(), &alloc, props),
+                SkCreateRasterPipelineBlitter(dst.pixmap(), paint, SkMatrix::I(), &alloc,
+                                              nullptr, props),
+                SkVMBlitter::Make(dst.pixmap(), paint, SkMatrix::I(), &alloc, nullptr),
+            };
+
+            printf("%-8s %-17s", mode == SkBlendMode::kSrc ? "src" : "srcover", name);
+            for (const auto& fill : {std::function<void(SkBlitter*)>(fillRect),
+                                     std::function<void(SkBlitter*)>(fillAntiH),
+                                     std::function<void(SkBlitter*)>(fillMask)}) {
+                for (SkBlitter* blitter : blitters) {
+                    if (!blitter) {
+                        printf("%10s", "n/a");
+                        continue;
+                    }
+                    printf("%10.2f", best_ns_per_px(size, loops, [&] { fill(blitter); }));
+                }
+
+                specialDst.eraseColor(background);
+                pipelineDst.eraseColor(background);
+                SkSTArenaAlloc<4096> diffAlloc;
+                SkBlitter* special = SkCreateSpecializedN32Blitter(
+                        specialDst.pixmap(), paint, SkMatrix::I(), &diffAlloc, props);
+                SkBlitter* pipeline = SkCreateRasterPipelineBlitter(
+                        pipelineDst.pixmap(), paint, SkMatrix::I(), &diffAlloc, nullptr, props);
+                if (!special || !pipeline) {
+                    printf("%6s", "n/a");
+                    continue;
+                }
+                fill(special);
+                fill(pipeline);
+                printf("%6d", max_diff(specialDst, pipelineDst));
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
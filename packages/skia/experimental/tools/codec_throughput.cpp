@@ -0,0 +1,289 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how fast each codec decodes the images in a corpus directory, for each way of
+// decoding: full, scanline, incremental, sampled, subset and color-converted.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/codec_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o codec_throughput
+//  ./codec_throughput CORPUS_DIR_OR_FILE [LOOPS]
+//
+// For each image and mode it prints the best time over LOOPS decodes (default 5), the throughput
+// in megapixels of the source image (or of the subset) per second, and the peak memory the mode
+// needed beyond what the process held before it, including its destination pixels. Each mode runs
+// in a child process of its own, so that one's peak does not hide the next one's. Modes a codec
+// does not implement (e.g. scanline decoding of PNG) print n/a.
+//
+// The codecs do not time their own phases, so the split between entropy decoding, swizzling and
+// color transforming is estimated by difference:
+//   decode  = a full decode to the codec's own color type and color space,
+//   swizzle = the extra time to decode to the other 8888 byte order and to premultiply,
+//   xform   = the extra time to decode to Display P3 rather than the image's own color space.
+
+#include "include/codec/SkAndroidCodec.h"
+#include "include/codec/SkCodec.h"
+#include "include/codec/SkEncodedImageFormat.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkData.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkString.h"
+#include "src/base/SkAutoMalloc.h"
+#include "src/core/SkOSFile.h"
+#include "src/utils/SkOSPath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static const char* format_name(SkEncodedImageFormat format) {
+    switch (format) {
+        case SkEncodedImageFormat::kBMP:     return "bmp";
+        case SkEncodedImageFormat::kGIF:     return "gif";
+        case SkEncodedImageFormat::kICO:     return "ico";
+        case SkEncodedImageFormat::kJPEG:    return "jpeg";
+        case SkEncodedImageFormat::kPNG:     return "png";
+        case SkEncodedImageFormat::kWBMP:    return "wbmp";
+        case SkEncodedImageFormat::kWEBP:    return "webp";
+        case SkEncodedImageFormat::kPKM:     return "pkm";
+        case SkEncodedImageFormat::kKTX:     return "ktx";
+        case SkEncodedImageFormat::kASTC:    return "astc";
+        case SkEncodedImageFormat::kDNG:     return "dng";
+        case SkEncodedImageFormat::kHEIF:    return "heif";
+        case SkEncodedImageFormat::kAVIF:    return "avif";
+        case SkEncodedImageFormat::kJPEGXL:  return "jpegxl";
+    }
+    return "?";
+}
+
+// Peak resident set size of the process, in megabytes, or 0 if unknown.
+static double peak_rss_mb() {
+#if defined(_WIN32)
+    return 0;
+#elif defined(__APPLE__)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / (1024.0 * 1024.0) : 0;
+#else
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / 1024.0 : 0;
+#endif
+}
+
+// Runs |run| in a child process, so that the peak memory it reports is its own, and returns what
+// it returns. A forked child starts out with the parent's resident pages as its peak, so that is
+// subtracted. Runs inline where there is no fork().
+static double isolated(const std::function<double(double baselineMB)>& run) {
+#if !defined(_WIN32)
+    int fds[2];
+    if (pipe(fds) == 0) {
+        fflush(stdout);
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            const double result = run(peak_rss_mb());
+            fflush(stdout);
+            const bool sent = write(fds[1], &result, sizeof(result)) == sizeof(result);
+            _exit(sent ? 0 : 1);
+        }
+        close(fds[1]);
+        if (pid > 0) {
+            double result;
+            if (read(fds[0], &result, sizeof(result)) != sizeof(result)) {
+                result = -1;
+            }
+            close(fds[0]);
+            int status;
+            waitpid(pid, &status, 0);
+            return result;
+        }
+        close(fds[0]);
+    }
+#endif
+    return run(peak_rss_mb());
+}
+
+// Runs |decode| |loops| times and returns the fastest, in milliseconds, or -1 if it ever fails.
+static double best_ms(int loops, const std::function<bool()>& decode) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!decode()) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static bool decoded(SkCodec::Result result) {
+    // Truncated or corrupt files still exercise the decoder up to where they stop.
+    return result == SkCodec::kSuccess || result == SkCodec::kIncompleteInput ||
+           result == SkCodec::kErrorInInput;
+}
+
+static void report(const char* mode, double ms, double megapixels, double baselineMB) {
+    if (ms < 0) {
+        printf("  %-12s %10s\n", mode, "n/a");
+        return;
+    }
+    printf("  %-12s %8.2fms %9.1fMP/s %8.1fMB peak\n", mode, ms,
+           ms > 0 ? megapixels / (ms / 1000) : 0, std::max(0.0, peak_rss_mb() - baselineMB));
+}
+
+static void bench(const SkString& path, int loops) {
+    sk_sp<SkData> data = SkData::MakeFromFileName(path.c_str());
+    std::unique_ptr<SkCodec> probe = data ? SkCodec::MakeFromData(data) : nullptr;
+    if (!probe) {
+        return;
+    }
+
+    const SkImageInfo nativeInfo = probe->getInfo();
+    const SkImageInfo n32Info = nativeInfo.makeColorType(kN32_SkColorType).makeAlphaType(
+            nativeInfo.isOpaque() ? kOpaque_SkAlphaType : kPremul_SkAlphaType);
+    const SkColorType swappedCT = kN32_SkColorType == kRGBA_8888_SkColorType
+                                          ? kBGRA_8888_SkColorType
+                                          : kRGBA_8888_SkColorType;
+    const SkImageInfo swizzledInfo = n32Info.makeColorType(swappedCT);
+    const SkImageInfo xformInfo = n32Info.makeColorSpace(
+            SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, SkNamedGamut::kDisplayP3));
+    const double megapixels = nativeInfo.width() * (double)nativeInfo.height() / 1e6;
+    const size_t pixelBytes = std::max(nativeInfo.computeMinByteSize(),
+                                       n32Info.computeMinByteSize());
+
+    printf("%s: %s %dx%d\n", path.c_str(), format_name(probe->getEncodedFormat()),
+           nativeInfo.width(), nativeInfo.height());
+    probe.reset();
+
+    // Times |decode| with a codec and destination of its own, in a child process, and prints it
+    // as |mode| unless that is null.
+    auto measure = [&](const char* mode, double mp,
+                       const std::function<bool(SkCodec*, void* pixels)>& decode) {
+        return isolated([&](double baselineMB) {
+            std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+            SkAutoMalloc pixels(pixelBytes);
+            const double ms = best_ms(loops, [&] { return decode(codec.get(), pixels.get()); });
+            if (mode) {
+                report(mode, ms, mp, baselineMB);
+            }
+            return ms;
+        });
+    };
+    auto getPixels = [&](const SkImageInfo& info) {
+        return [info](SkCodec* codec, void* pixels) {
+            return decoded(codec->getPixels(info, pixels, info.minRowBytes()));
+        };
+    };
+
+    const double native  = measure(nullptr, megapixels, getPixels(nativeInfo));
+    const double swapped = measure(nullptr, megapixels, getPixels(swizzledInfo));
+    const double full    = measure("full", megapixels, getPixels(n32Info));
+
+    measure("scanline", megapixels, [&](SkCodec* codec, void* pixels) {
+        if (codec->startScanlineDecode(n32Info) != SkCodec::kSuccess) {
+            return false;
+        }
+        // Like decoded(), a truncated image counts as decoded up to where it stops, so this
+        // only fails if no row decoded at all.
+        return codec->getScanlines(pixels, n32Info.height(), n32Info.minRowBytes()) > 0;
+    });
+
+    measure("incremental", megapixels, [&](SkCodec* codec, void* pixels) {
+        if (codec->startIncrementalDecode(n32Info, pixels, n32Info.minRowBytes()) !=
+            SkCodec::kSuccess) {
+            return false;
+        }
+        return decoded(codec->incrementalDecode());
+    });
+
+    const double xform = measure("color xform", megapixels, getPixels(xformInfo));
+
+    if (std::unique_ptr<SkAndroidCodec> androidProbe = SkAndroidCodec::MakeFromData(data)) {
+        // Like measure(), but with an SkAndroidCodec.
+        auto measureAndroid = [&](const char* mode, double mp, const SkImageInfo& info,
+                                  const SkAndroidCodec::AndroidOptions& options) {
+            isolated([&](double baselineMB) {
+                std::unique_ptr<SkAndroidCodec> codec = SkAndroidCodec::MakeFromData(data);
+                SkAutoMalloc pixels(pixelBytes);
+                const double ms = best_ms(loops, [&] {
+                    return decoded(codec->getAndroidPixels(info, pixels.get(), info.minRowBytes(),
+                                                           &options));
+                });
+                report(mode, ms, mp, baselineMB);
+                return ms;
+            });
+        };
+
+        for (int sampleSize : {2, 4, 8}) {
+            SkAndroidCodec::AndroidOptions options;
+            options.fSampleSize = sampleSize;
+            const SkImageInfo sampledInfo =
+                    n32Info.makeDimensions(androidProbe->getSampledDimensions(sampleSize));
+            SkString mode = SkStringPrintf("sampled /%d", sampleSize);
+            measureAndroid(mode.c_str(), megapixels, sampledInfo, options);
+        }
+
+        // The middle quarter of the image, as adjusted to what the codec supports.
+        SkIRect subset = SkIRect::MakeXYWH(nativeInfo.width() / 4, nativeInfo.height() / 4,
+                                           nativeInfo.width() / 2, nativeInfo.height() / 2);
+        if (!subset.isEmpty() && androidProbe->getSupportedSubset(&subset)) {
+            SkAndroidCodec::AndroidOptions options;
+            options.fSubset = &subset;
+            measureAndroid("subset", subset.width() * (double)subset.height() / 1e6,
+                           n32Info.makeDimensions(subset.size()), options);
+        } else {
+            report("subset", -1, 0, 0);
+        }
+    }
+
+    if (native >= 0 && full >= 0 && xform >= 0) {
+        const double swizzle = std::max(0.0, std::max(full, swapped) - native);
+        printf("  split        decode %.2fms, swizzle %.2fms, xform %.2fms\n",
+               native, swizzle, std::max(0.0, xform - full));
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s CORPUS_DIR_OR_FILE [LOOPS]\n", argv[0]);
+        return 1;
+    }
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+    SkGraphics::Init();
+
+    std::vector<SkString> paths;
+    if (sk_isdir(argv[1])) {
+        SkOSFile::Iter iter(argv[1]);
+        for (SkString name; iter.next(&name);) {
+            paths.push_back(SkOSPath::Join(argv[1], name.c_str()));
+        }
+        std::sort(paths.begin(), paths.end(), [](const SkString& a, const SkString& b) {
+            return strcmp(a.c_str(), b.c_str()) < 0;
+        });
+    } else {
+        paths.emplace_back(argv[1]);
+    }
+
+    for (const SkString& path : paths) {
+        bench(path, loops);
+    }
+    return 0;
+}
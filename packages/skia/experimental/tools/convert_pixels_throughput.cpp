@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how fast SkPixmap::readPixels() (SkConvertPixels) converts between common color types,
+// without a color space conversion, so that the SkOpts swizzlers and the raster pipeline fallback
+// can be compared side by side.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/convert_pixels_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o convert_pixels_throughput
+//  ./convert_pixels_throughput [SIZE] [LOOPS]
+//
+// It converts a SIZExSIZE (default 2048) image from each source (row) to each destination
+// (column) and prints the best of LOOPS conversions (default 10) in GB/s of source and
+// destination bytes together, or "-" where readPixels() does not convert.
+
+#include "include/core/SkAlphaType.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkColorType.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::max(16, atoi(argv[1])) : 2048;
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 10;
+
+    SkGraphics::Init();
+
+    const struct {
+        const char* fName;
+        SkColorType fColorType;
+        SkAlphaType fAlphaType;
+    } kinds[] = {
+        {"RGBA",          kRGBA_8888_SkColorType, kPremul_SkAlphaType},
+        {"RGBA unpremul", kRGBA_8888_SkColorType, kUnpremul_SkAlphaType},
+        {"BGRA",          kBGRA_8888_SkColorType, kPremul_SkAlphaType},
+        {"F16",           kRGBA_F16_SkColorType,  kPremul_SkAlphaType},
+        {"565",           kRGB_565_SkColorType,   kOpaque_SkAlphaType},
+        {"Gray8",         kGray_8_SkColorType,    kOpaque_SkAlphaType},
+        {"A8",            kAlpha_8_SkColorType,   kPremul_SkAlphaType},
+    };
+    const sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+
+    printf("%dx%d, GB/s %-5s", size, size, "from");
+    for (const auto& dst : kinds) {
+        printf("%14s", dst.fName);
+    }
+    printf("\n");
+
+    for (const auto& src : kinds) {
+        SkBitmap srcBitmap;
+        srcBitmap.allocPixels(SkImageInfo::Make(size, size, src.fColorType, src.fAlphaType, srgb));
+        srcBitmap.eraseColor(0xC0806040);
+        printf("  %-19s", src.fName);
+        for (const auto& dst : kinds) {
+            SkBitmap dstBitmap;
+            dstBitmap.allocPixels(
+                    SkImageInfo::Make(size, size, dst.fColorType, dst.fAlphaType, srgb));
+            double best = -1;
+            for (int i = 0; i < loops; ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                if (!srcBitmap.pixmap().readPixels(dstBitmap.pixmap())) {
+                    best = -1;
+                    break;
+                }
+                const std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+                best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+            }
+            if (best <= 0) {
+                printf("%14s", "-");
+            } else {
+                const double bytes = srcBitmap.computeByteSize() + dstBitmap.computeByteSize();
+                printf("%14.2f", bytes / best / 1e9);
+            }
+        }
+        printf("\n");
+    }
+    return 0;
+}
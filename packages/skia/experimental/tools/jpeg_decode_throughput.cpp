@@ -0,0 +1,142 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how long large JPEGs take to decode on one thread and split into restart-interval bands
+// on a thread pool (see SkCodec::Options::fExecutor).
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/jpeg_decode_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o jpeg_decode_throughput
+//  ./jpeg_decode_throughput [JPEG ...] [--loops N] [--threads N]
+//
+// Without files it encodes 12, 24 and 50 megapixel photo-like images, with the restart markers
+// that SkJpegEncoder writes when it encodes on an executor. For each image it prints the best
+// time over LOOPS decodes (default 3) with and without a pool of THREADS threads (default the
+// number of cores), and whether the two decodes are identical. Images without restart markers
+// that line up with MCU rows decode serially either way.
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorPriv.h"
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkString.h"
+#include "include/encode/SkJpegEncoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// A smooth gradient with some texture, which compresses about like a photo.
+static sk_sp<SkData> make_jpeg(int width, int height, SkExecutor* executor) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(width, height, /*isOpaque=*/true);
+    uint32_t seed = 1;
+    for (int y = 0; y < height; ++y) {
+        uint32_t* row = bitmap.getAddr32(0, y);
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525 + 1013904223;
+            const int noise = (int)(seed >> 28);
+            const int r = (int)(128 + 100 * std::sin(x * 0.003f + y * 0.001f)) + noise,
+                      g = (x * 255 / width + noise) & 0xFF,
+                      b = (y * 255 / height + noise) & 0xFF;
+            row[x] = SkPackARGB32(0xFF, std::min(r, 255), g, b);
+        }
+    }
+    SkJpegEncoder::Options options;
+    options.fQuality = 90;
+    options.fExecutor = executor;
+    SkDynamicMemoryWStream stream;
+    return SkJpegEncoder::Encode(&stream, bitmap.pixmap(), options) ? stream.detachAsData()
+                                                                    : nullptr;
+}
+
+// Returns the fastest of |loops| runs of |decode|, in milliseconds, or -1 if it ever fails.
+static double best_ms(int loops, const std::function<bool()>& decode) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!decode()) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static void bench(const char* name, const sk_sp<SkData>& data, SkExecutor* executor, int loops) {
+    std::unique_ptr<SkCodec> codec = data ? SkCodec::MakeFromData(data) : nullptr;
+    if (!codec) {
+        printf("%-24s could not be decoded\n", name);
+        return;
+    }
+    const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType);
+
+    SkBitmap serial, parallel;
+    serial.allocPixels(info);
+    parallel.allocPixels(info);
+
+    SkCodec::Options options;
+    const double serialMs = best_ms(loops, [&] {
+        return codec->getPixels(serial.pixmap(), &options) == SkCodec::kSuccess;
+    });
+    options.fExecutor = executor;
+    const double parallelMs = best_ms(loops, [&] {
+        return codec->getPixels(parallel.pixmap(), &options) == SkCodec::kSuccess;
+    });
+
+    bool identical = serialMs >= 0 && parallelMs >= 0;
+    for (int y = 0; identical && y < info.height(); ++y) {
+        identical = !memcmp(serial.getAddr(0, y), parallel.getAddr(0, y), info.minRowBytes());
+    }
+    const double megapixels = info.width() * (double)info.height() / 1e6;
+    printf("%-24s %5.1fMP  serial %8.1fms  parallel %8.1fms  %5.2fx  %s\n",
+           name, megapixels, serialMs, parallelMs,
+           parallelMs > 0 ? serialMs / parallelMs : 0, identical ? "identical" : "DIFFERENT");
+}
+
+int main(int argc, char** argv) {
+    int loops = 3;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+            loops = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    SkGraphics::Init();
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(threads);
+    printf("%d thread%s\n", threads, threads == 1 ? "" : "s");
+
+    if (paths.empty()) {
+        // 4:3 images of about 12, 24 and 50 megapixels.
+        for (int width : {4000, 5664, 8160}) {
+            const int height = width * 3 / 4;
+            SkString name = SkStringPrintf("synthetic %dx%d", width, height);
+            bench(name.c_str(), make_jpeg(width, height, executor.get()), executor.get(), loops);
+        }
+    }
+    for (const char* path : paths) {
+        bench(path, SkData::MakeFromFileName(path), executor.get(), loops);
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how fast the raster lighting image filters (feDiffuseLighting and feSpecularLighting)
+// run with each kind of light, next to a Gaussian blur of the same image for scale.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/lighting_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o lighting_throughput
+//  ./lighting_throughput [SIZE] [LOOPS] [THREADS]
+//
+// The source is a SIZExSIZE (default 1024) image of soft shapes, like the alpha of the content an
+// SVG filter lights. For each filter it prints the best time over LOOPS runs (default 5), the
+// throughput in megapixels per second and how much slower than the blur it is. With THREADS > 1
+// the filters are evaluated on a thread pool of that many threads (see SkImageFilters::Parallel).
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPoint3.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkSurface.h"
+#include "include/effects/SkImageFilters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+static sk_sp<SkImage> make_source(int size) {
+    sk_sp<SkSurface> surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(size, size));
+    SkCanvas* canvas = surface->getCanvas();
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setImageFilter(SkImageFilters::Blur(size / 64.f, size / 64.f, nullptr));
+    for (int i = 0; i < 16; ++i) {
+        paint.setColor(SkColorSetARGB(64 + 12 * i, 255, 128, 0));
+        canvas->drawCircle(size * ((i * 37) % 16) / 16.f, size * ((i * 11) % 16) / 16.f,
+                           size / 6.f, paint);
+    }
+    return surface->makeImageSnapshot();
+}
+
+// Returns the fastest of |loops| runs of |filter| over |source|, in milliseconds, or -1 if the
+// filter fails.
+static double best_ms(const sk_sp<SkImage>& source, const sk_sp<SkImageFilter>& filter,
+                      int loops) {
+    const SkIRect bounds = SkIRect::MakeWH(source->width(), source->height());
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        SkIRect outSubset;
+        SkIPoint offset;
+        const auto start = std::chrono::steady_clock::now();
+        if (!source->makeWithFilter(nullptr, filter.get(), bounds, bounds, &outSubset, &offset)) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::max(2, atoi(argv[1])) : 1024;
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+    const int threads = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
+
+    SkGraphics::Init();
+
+    std::unique_ptr<SkExecutor> executor =
+            threads > 1 ? SkExecutor::MakeFIFOThreadPool(threads) : nullptr;
+    auto parallel = [&](sk_sp<SkImageFilter> filter) {
+        return executor ? SkImageFilters::Parallel(executor.get(), std::move(filter)) : filter;
+    };
+
+    const sk_sp<SkImage> source = make_source(size);
+    const double megapixels = size * (double)size / 1e6;
+
+    const SkPoint3 direction = SkPoint3::Make(1, -1, 1);
+    const SkPoint3 location = SkPoint3::Make(size / 3.f, size / 4.f, size / 2.f);
+    const SkPoint3 target = SkPoint3::Make(size / 2.f, size / 2.f, 0);
+    const SkColor color = SkColorSetRGB(255, 240, 200);
+    const float surfaceScale = 4, kd = 1, ks = 1, shininess = 20;
+
+    struct {
+        const char*          fName;
+        sk_sp<SkImageFilter> fFilter;
+    } filters[] = {
+        {"blur",
+         SkImageFilters::Blur(3, 3, nullptr)},
+        {"distant diffuse",
+         SkImageFilters::DistantLitDiffuse(direction, color, surfaceScale, kd, nullptr)},
+        {"point diffuse",
+         SkImageFilters::PointLitDiffuse(location, color, surfaceScale, kd, nullptr)},
+        {"spot diffuse",
+         SkImageFilters::SpotLitDiffuse(location, target, 2, 30, color, surfaceScale, kd,
+                                        nullptr)},
+        {"distant specular",
+         SkImageFilters::DistantLitSpecular(direction, color, surfaceScale, ks, shininess,
+                                            nullptr)},
+        {"point specular",
+         SkImageFilters::PointLitSpecular(location, color, surfaceScale, ks, shininess, nullptr)},
+        {"spot specular",
+         SkImageFilters::SpotLitSpecular(location, target, 2, 30, color, surfaceScale, ks,
+                                         shininess, nullptr)},
+    };
+
+    printf("%dx%d, %d thread%s\n", size, size, threads, threads == 1 ? "" : "s");
+    double blurMs = -1;
+    for (const auto& [name, filter] : filters) {
+        const double ms = best_ms(source, parallel(filter), loops);
+        if (ms < 0) {
+            printf("  %-18s %10s\n", name, "failed");
+            continue;
+        }
+        if (blurMs < 0) {
+            blurMs = ms;
+        }
+        printf("  %-18s %8.2fms %9.1fMP/s %6.1fx blur\n",
+               name, ms, ms > 0 ? megapixels / (ms / 1000) : 0, blurMs > 0 ? ms / blurMs : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how long SkMipmap takes to build every level of a large image, on one thread and with
+// the rows of large levels split over a thread pool, and how long a lazy mipmap takes to produce
+// only the level a draw at 1/4 scale samples.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/mipmap_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o mipmap_throughput
+//  ./mipmap_throughput [SIZE] [LOOPS] [THREADS]
+//
+// For SIZExSIZE (default 4096) 8888, F16, A8 and 565 images it prints the best time over LOOPS
+// builds (default 5) in milliseconds and in source megapixels per second, with and without a pool
+// of THREADS threads (default the number of cores), and whether the two build the same levels.
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkSize.h"
+#include "src/core/SkMipmap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+
+static SkBitmap make_image(int size, SkColorType colorType) {
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::Make(size, size, colorType, kPremul_SkAlphaType));
+    uint32_t seed = 1;
+    uint8_t* bytes = static_cast<uint8_t*>(bitmap.getPixels());
+    for (size_t i = 0; i < bitmap.computeByteSize(); ++i) {
+        seed = seed * 1664525 + 1013904223;
+        bytes[i] = (uint8_t)(seed >> 24);
+    }
+    if (colorType == kRGBA_F16_SkColorType) {
+        // Random bits make NaNs and infinities; use gray levels in [0, 1] instead.
+        bitmap.eraseColor(0xFF808080);
+    }
+    return bitmap;
+}
+
+// Returns the fastest of |loops| runs of |run|, in milliseconds.
+static double best_ms(int loops, const std::function<void()>& run) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static bool same_levels(const SkMipmap& a, const SkMipmap& b) {
+    for (int i = 0; i < a.countLevels(); ++i) {
+        SkMipmap::Level la, lb;
+        if (!a.getLevel(i, &la) || !b.getLevel(i, &lb)) {
+            return false;
+        }
+        for (int y = 0; y < la.fPixmap.height(); ++y) {
+            if (memcmp(la.fPixmap.addr(0, y), lb.fPixmap.addr(0, y),
+                       la.fPixmap.info().minRowBytes())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::max(2, atoi(argv[1])) : 4096;
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+    const int threads = argc > 3 ? std::max(1, atoi(argv[3]))
+                                 : std::max(1u, std::thread::hardware_concurrency());
+
+    SkGraphics::Init();
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(threads);
+    printf("%dx%d, %d thread%s\n", size, size, threads, threads == 1 ? "" : "s");
+
+    const struct {
+        const char* fName;
+        SkColorType fColorType;
+    } kinds[] = {
+        {"8888", kN32_SkColorType},
+        {"F16",  kRGBA_F16_SkColorType},
+        {"A8",   kAlpha_8_SkColorType},
+        {"565",  kRGB_565_SkColorType},
+    };
+    const double megapixels = size * (double)size / 1e6;
+    for (const auto& [name, colorType] : kinds) {
+        const SkBitmap src = make_image(size, colorType);
+
+        sk_sp<SkMipmap> serial, parallel;
+        SkMipmap::BuildOptions options;
+        const double serialMs = best_ms(loops, [&] {
+            serial.reset(SkMipmap::Build(src, nullptr, options));
+        });
+        options.fExecutor = executor.get();
+        const double parallelMs = best_ms(loops, [&] {
+            parallel.reset(SkMipmap::Build(src, nullptr, options));
+        });
+
+        // A lazy build, then the level a draw at 1/4 scale samples (level 2, which is 1/4 size).
+        options.fLazy = true;
+        const double lazyMs = best_ms(loops, [&] {
+            sk_sp<SkMipmap> lazy(SkMipmap::Build(src, nullptr, options));
+            SkMipmap::Level level;
+            lazy->extractLevel(SkSize::Make(0.25f, 0.25f), &level);
+        });
+
+        const bool same = serial && parallel && same_levels(*serial, *parallel);
+        printf("  %-5s serial %8.1fms %7.0fMP/s  parallel %8.1fms %7.0fMP/s  %5.2fx  "
+               "lazy to 1/4 %7.1fms  %s\n",
+               name, serialMs, megapixels * 1000 / serialMs, parallelMs,
+               megapixels * 1000 / parallelMs, serialMs / parallelMs, lazyMs,
+               same ? "identical" : "DIFFERENT");
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how fast SkPngCodec decodes each kind of PNG, with and without a color transform.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/png_decode_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o png_decode_throughput
+//  ./png_decode_throughput [SIZE] [LOOPS]
+//
+// It writes SIZExSIZE (default 2048) RGBA8, RGB8, 16-bit RGBA, palette, gray and gray+alpha PNGs
+// with libpng, and decodes each to premultiplied N32 in its own (sRGB) color space and in Display
+// P3. For each it prints the best time over LOOPS decodes (default 5) in nanoseconds per pixel, and
+// what the color transform adds.
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkData.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+
+#include <png.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+static void append(png_structp png, png_bytep bytes, png_size_t size) {
+    auto* out = static_cast<std::vector<uint8_t>*>(png_get_io_ptr(png));
+    out->insert(out->end(), bytes, bytes + size);
+}
+
+// Writes a SIZExSIZE PNG of |colorType| (PNG_COLOR_TYPE_*) and |bitDepth| with libpng, so that
+// the kinds SkPngEncoder does not write (palette, gray+alpha) can be measured too.
+static sk_sp<SkData> make_png(int size, int colorType, int bitDepth) {
+    std::vector<uint8_t> out;
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        return nullptr;
+    }
+    png_set_write_fn(png, &out, append, nullptr);
+    png_set_IHDR(png, info, size, size, bitDepth, colorType, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_set_sRGB(png, info, PNG_sRGB_INTENT_PERCEPTUAL);
+
+    if (colorType == PNG_COLOR_TYPE_PALETTE) {
+        png_color palette[256];
+        png_byte alphas[256];
+        for (int i = 0; i < 256; ++i) {
+            palette[i] = {(png_byte)i, (png_byte)(255 - i), (png_byte)(i * 7)};
+            alphas[i] = (png_byte)(i < 16 ? i * 16 : 255);
+        }
+        png_set_PLTE(png, info, palette, 256);
+        png_set_tRNS(png, info, alphas, 256, nullptr);
+    }
+    png_write_info(png, info);
+    if (bitDepth == 16) {
+        png_set_swap(png);  // The rows below are written little-endian.
+    }
+
+    const int channels = png_get_channels(png, info);
+    const int bytesPerSample = bitDepth / 8;
+    std::vector<uint8_t> row(size * channels * bytesPerSample);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                // Smooth in x and y, so the image compresses like real content; the last channel
+                // of an image with alpha varies from opaque to transparent.
+                const bool alpha = c == channels - 1 && (colorType & PNG_COLOR_MASK_ALPHA);
+                const double v = alpha ? 1 - 0.5 * x / size
+                                       : 0.5 + 0.5 * std::sin(x * 0.01 * (c + 1) + y * 0.003);
+                const int sample = (int)(v * ((1 << bitDepth) - 1));
+                uint8_t* dst = row.data() + (x * channels + c) * bytesPerSample;
+                dst[0] = (uint8_t)sample;
+                if (bytesPerSample == 2) {
+                    dst[1] = (uint8_t)(sample >> 8);
+                }
+            }
+        }
+        png_write_row(png, row.data());
+    }
+    png_write_end(png, info);
+    png_destroy_write_struct(&png, &info);
+    return SkData::MakeWithCopy(out.data(), out.size());
+}
+
+// Returns the fastest of |loops| decodes of |data| into |info|, in nanoseconds per pixel, or -1 if
+// any fails.
+static double best_ns_per_px(const sk_sp<SkData>& data, const SkImageInfo& info, int loops) {
+    SkBitmap bitmap;
+    bitmap.allocPixels(info);
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+        const auto start = std::chrono::steady_clock::now();
+        if (!codec || codec->getPixels(bitmap.pixmap()) != SkCodec::kSuccess) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best / (info.width() * (double)info.height());
+}
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::max(16, atoi(argv[1])) : 2048;
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+    SkGraphics::Init();
+
+    const sk_sp<SkColorSpace> p3 =
+            SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, SkNamedGamut::kDisplayP3);
+    const struct {
+        const char* fName;
+        int         fColorType;
+        int         fBitDepth;
+    } kinds[] = {
+        {"RGBA8",       PNG_COLOR_TYPE_RGB_ALPHA,  8},
+        {"RGB8",        PNG_COLOR_TYPE_RGB,        8},
+        {"RGBA16",      PNG_COLOR_TYPE_RGB_ALPHA, 16},
+        {"RGB16",       PNG_COLOR_TYPE_RGB,       16},
+        {"palette",     PNG_COLOR_TYPE_PALETTE,    8},
+        {"gray8",       PNG_COLOR_TYPE_GRAY,       8},
+        {"gray+alpha8", PNG_COLOR_TYPE_GRAY_ALPHA, 8},
+    };
+
+    printf("%dx%d, ns/px%17s%12s%12s\n", size, size, "sRGB", "P3", "xform");
+    for (const auto& [name, colorType, bitDepth] : kinds) {
+        const sk_sp<SkData> data = make_png(size, colorType, bitDepth);
+        const SkImageInfo info = SkImageInfo::MakeN32Premul(size, size, SkColorSpace::MakeSRGB());
+        const double srgb = best_ns_per_px(data, info, loops),
+                     xform = best_ns_per_px(data, info.makeColorSpace(p3), loops);
+        printf("  %-20s", name);
+        for (double ns : {srgb, xform}) {
+            if (ns < 0) {
+                printf("%12s", "failed");
+            } else {
+                printf("%12.2f", ns);
+            }
+        }
+        printf("%+12.2f\n", srgb >= 0 && xform >= 0 ? xform - srgb : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how long large PNGs take to encode on one thread and split into bands on a thread pool
+// (see SkPngEncoder::Options::fExecutor), and what the bands cost in compression.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/png_encode_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o png_encode_throughput
+//  ./png_encode_throughput [IMAGE ...] [--loops N] [--threads N]
+//
+// Without images it encodes a 4096x4096 photo-like image and a screenshot-like one, which has
+// long runs that deflate finds across band boundaries. For each image and zlib level 1, 6 and 9
+// it prints the best time over LOOPS encodes (default 3) with and without a pool of THREADS
+// threads (default the number of cores), the size of each PNG, and whether both decode to the
+// same pixels.
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorPriv.h"
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkStream.h"
+#include "include/encode/SkPngEncoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static SkBitmap make_photo(int size) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(size, size, /*isOpaque=*/true);
+    uint32_t seed = 1;
+    for (int y = 0; y < size; ++y) {
+        uint32_t* row = bitmap.getAddr32(0, y);
+        for (int x = 0; x < size; ++x) {
+            seed = seed * 1664525 + 1013904223;
+            const int noise = (int)(seed >> 29);
+            const int r = (int)(128 + 100 * std::sin(x * 0.003f + y * 0.001f)) + noise;
+            row[x] = SkPackARGB32(0xFF, std::min(r, 255), (x * 255 / size + noise) & 0xFF,
+                                  (y * 255 / size + noise) & 0xFF);
+        }
+    }
+    return bitmap;
+}
+
+static SkBitmap make_screenshot(int size) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(size, size, /*isOpaque=*/true);
+    for (int y = 0; y < size; ++y) {
+        uint32_t* row = bitmap.getAddr32(0, y);
+        for (int x = 0; x < size; ++x) {
+            // Flat panels with lines of "text" in them.
+            const bool text = (y % 24) < 12 && (x % 400) > 20 && ((x * 7 + y * 3) % 11) < 4;
+            const int panel = (x / 400 + y / 300) % 3;
+            row[x] = text ? SkPackARGB32(0xFF, 32, 32, 32)
+                          : SkPackARGB32(0xFF, 255 - panel * 20, 255 - panel * 10, 255);
+        }
+    }
+    return bitmap;
+}
+
+// Returns the fastest of |loops| runs of |encode|, in milliseconds, or -1 if it ever fails.
+static double best_ms(int loops, const std::function<bool()>& encode) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!encode()) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static bool decode(const sk_sp<SkData>& png, SkBitmap* bitmap) {
+    std::unique_ptr<SkCodec> codec = png ? SkCodec::MakeFromData(png) : nullptr;
+    return codec && bitmap->tryAllocPixels(codec->getInfo().makeColorType(kN32_SkColorType)) &&
+           codec->getPixels(bitmap->pixmap()) == SkCodec::kSuccess;
+}
+
+static void bench(const char* name, const SkPixmap& src, SkExecutor* executor, int loops) {
+    printf("%s %dx%d\n", name, src.width(), src.height());
+    for (int level : {1, 6, 9}) {
+        SkPngEncoder::Options options;
+        options.fZLibLevel = level;
+        sk_sp<SkData> serial, parallel;
+        const double serialMs = best_ms(loops, [&] {
+            SkDynamicMemoryWStream stream;
+            serial = SkPngEncoder::Encode(&stream, src, options) ? stream.detachAsData() : nullptr;
+            return serial != nullptr;
+        });
+        options.fExecutor = executor;
+        const double parallelMs = best_ms(loops, [&] {
+            SkDynamicMemoryWStream stream;
+            parallel = SkPngEncoder::Encode(&stream, src, options) ? stream.detachAsData()
+                                                                   : nullptr;
+            return parallel != nullptr;
+        });
+
+        SkBitmap a, b;
+        bool identical = decode(serial, &a) && decode(parallel, &b);
+        for (int y = 0; identical && y < src.height(); ++y) {
+            identical = !memcmp(a.getAddr(0, y), b.getAddr(0, y), a.info().minRowBytes());
+        }
+        const double rawBytes = src.computeByteSize();
+        printf("  level %d  serial %8.1fms %6.2f%%  parallel %8.1fms %6.2f%%  %5.2fx  %+.2f%% size"
+               "  %s\n",
+               level,
+               serialMs, serial ? 100 * serial->size() / rawBytes : 0,
+               parallelMs, parallel ? 100 * parallel->size() / rawBytes : 0,
+               parallelMs > 0 ? serialMs / parallelMs : 0,
+               serial && parallel ? 100.0 * parallel->size() / serial->size() - 100 : 0,
+               identical ? "identical" : "DIFFERENT");
+    }
+}
+
+int main(int argc, char** argv) {
+    int loops = 3;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+            loops = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    SkGraphics::Init();
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(threads);
+    printf("%d thread%s; sizes are %% of the raw pixels\n", threads, threads == 1 ? "" : "s");
+
+    if (paths.empty()) {
+        bench("synthetic photo", make_photo(4096).pixmap(), executor.get(), loops);
+        bench("synthetic screenshot", make_screenshot(4096).pixmap(), executor.get(), loops);
+    }
+    for (const char* path : paths) {
+        SkBitmap bitmap;
+        if (!decode(SkData::MakeFromFileName(path), &bitmap)) {
+            printf("%s could not be decoded\n", path);
+            continue;
+        }
+        bench(path, bitmap.pixmap(), executor.get(), loops);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Stresses the global SkResourceCache from several threads at once, the way raster threads drawing
+// many images use it through SkBitmapCache and the mipmap cache: each thread looks up random keys
+// and adds a Rec for every miss, over a working set larger than the budget, so that adds evict.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/resource_cache_stress.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o resource_cache_stress
+//  ./resource_cache_stress [--ops N] [--pinned PERCENT]
+//
+// Each thread does OPS (default 200000) lookups. PERCENT (default 0) of the Recs stay in use, as
+// locked bitmaps do, so that evictions have to skip them. For 1, 2, 4, 8 and 16 threads it prints
+// the lookups per second over all threads, the hit rate, and whether the cache ended within its
+// budget with its totals matching what it holds.
+
+#include "include/core/SkGraphics.h"
+#include "src/core/SkResourceCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kRecBytes = 16 * 1024;
+constexpr size_t kBudget = 32 * 1024 * 1024;
+constexpr uint32_t kKeys = 4 * kBudget / kRecBytes;  // Four times what fits.
+
+int gNamespace;
+
+struct StressKey : public SkResourceCache::Key {
+    explicit StressKey(uint32_t id) : fID(id) {
+        this->init(&gNamespace, 0, sizeof(fID));
+    }
+    uint32_t fID;
+};
+
+struct StressRec : public SkResourceCache::Rec {
+    StressRec(uint32_t id, bool pinned) : fKey(id), fPinned(pinned) {}
+
+    const Key& getKey() const override { return fKey; }
+    size_t bytesUsed() const override { return sizeof(*this) + kRecBytes; }
+    bool canBePurged() override { return !fPinned; }
+    const char* getCategory() const override { return "stress"; }
+
+    static bool Visitor(const SkResourceCache::Rec&, void*) { return true; }
+
+    StressKey  fKey;
+    const bool fPinned;
+};
+
+struct Result {
+    double fLookupsPerSecond;
+    double fHitRate;
+};
+
+Result run(int threadCount, int ops, int pinnedPercent) {
+    SkResourceCache::PurgeAll();
+    std::atomic<int> hits{0};
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            uint32_t seed = 1 + t;
+            int localHits = 0;
+            for (int i = 0; i < ops; ++i) {
+                seed = seed * 1664525 + 1013904223;
+                // Skewed toward low keys, so that some are hot.
+                const uint32_t r = seed >> 8;
+                const uint32_t id = (r % kKeys) * (r % kKeys) / kKeys;
+                if (SkResourceCache::Find(StressKey(id), StressRec::Visitor, nullptr)) {
+                    ++localHits;
+                } else {
+                    SkResourceCache::Add(new StressRec(id, (int)(id % 100) < pinnedPercent));
+                }
+            }
+            hits.fetch_add(localHits);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double lookups = (double)threadCount * ops;
+    return {lookups / elapsed.count(), hits.load() / lookups};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int ops = 200000;
+    int pinnedPercent = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--ops") && i + 1 < argc) {
+            ops = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--pinned") && i + 1 < argc) {
+            pinnedPercent = std::clamp(atoi(argv[++i]), 0, 100);
+        }
+    }
+
+    SkGraphics::Init();
+    SkResourceCache::SetTotalByteLimit(kBudget);
+    printf("%u keys of %zuKB, %zuMB budget, %d%% pinned\n",
+           kKeys, kRecBytes / 1024, kBudget / (1024 * 1024), pinnedPercent);
+
+    for (int threads : {1, 2, 4, 8, 16}) {
+        const Result result = run(threads, ops, pinnedPercent);
+
+        size_t held = 0;
+        SkResourceCache::VisitAll([](const SkResourceCache::Rec& rec, void* context) {
+            *static_cast<size_t*>(context) += rec.bytesUsed();
+        }, &held);
+        const size_t used = SkResourceCache::GetTotalBytesUsed();
+        // Pinned Recs cannot be evicted, so they may hold the cache over its budget.
+        const bool ok = held == used && (pinnedPercent > 0 || used <= kBudget);
+        printf("  %2d thread%s %10.0f lookups/s  %5.1f%% hits  %6.1fMB held  %s\n",
+               threads, threads == 1 ? " " : "s", result.fLookupsPerSecond,
+               100 * result.fHitRate, used / (1024.0 * 1024.0), ok ? "ok" : "MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures the time and memory it takes to make a thumbnail of a large image, three ways:
+//   decode+scale  decode at full size, then SkPixmap::scalePixels() with mipmaps,
+//   sampled       decode with SkAndroidCodec's sample size, which point samples rows and columns
+//                 after any native scaling and only reaches sizes the sample size allows,
+//   area average  decode with AndroidOptions::fAreaAverage, straight to the thumbnail size.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/thumbnail_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o thumbnail_throughput
+//  ./thumbnail_throughput [IMAGE ...] [--size N] [--loops N]
+//
+// Without images it makes a 24 megapixel JPEG and PNG. The thumbnails fit in NxN (default 256).
+// For each image and way it prints the best time over LOOPS runs (default 3), the thumbnail size,
+// and the peak memory the run needed beyond what the process held before it. Each way runs in a
+// child process of its own, so that one's peak does not hide the next one's.
+
+#include "include/codec/SkAndroidCodec.h"
+#include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorPriv.h"
+#include "include/core/SkData.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkString.h"
+#include "include/encode/SkJpegEncoder.h"
+#include "include/encode/SkPngEncoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Peak resident set size of the process, in megabytes, or 0 if unknown.
+static double peak_rss_mb() {
+#if defined(_WIN32)
+    return 0;
+#elif defined(__APPLE__)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / (1024.0 * 1024.0) : 0;
+#else
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / 1024.0 : 0;
+#endif
+}
+
+// Runs |run| in a child process, so that the peak memory it reports is its own. A forked child
+// starts out with the parent's resident pages as its peak, so that is subtracted. Runs inline
+// where there is no fork().
+static void isolated(const std::function<void(double baselineMB)>& run) {
+#if defined(_WIN32)
+    run(peak_rss_mb());
+#else
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        run(peak_rss_mb());
+        fflush(stdout);
+        _exit(0);
+    }
+    if (pid > 0) {
+        int status;
+        waitpid(pid, &status, 0);
+    } else {
+        run(peak_rss_mb());
+    }
+#endif
+}
+
+static SkBitmap make_photo(int width, int height) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(width, height, /*isOpaque=*/true);
+    for (int y = 0; y < height; ++y) {
+        uint32_t* row = bitmap.getAddr32(0, y);
+        for (int x = 0; x < width; ++x) {
+            // Fine stripes, which point sampling aliases and averaging does not.
+            const int stripes = ((x / 3 + y / 5) & 1) * 60;
+            row[x] = SkPackARGB32(0xFF, (x * 255 / width + stripes) & 0xFF,
+                                  (y * 255 / height + stripes) & 0xFF, 128 + stripes);
+        }
+    }
+    return bitmap;
+}
+
+// Returns the fastest of |loops| runs of |decode|, in milliseconds, or -1 if it ever fails.
+static double best_ms(int loops, const std::function<bool()>& decode) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!decode()) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static void report(const char* mode, double ms, SkISize size, double baselineMB) {
+    if (ms < 0) {
+        printf("  %-14s %10s\n", mode, "failed");
+        return;
+    }
+    printf("  %-14s %8.1fms %5dx%-5d %8.1fMB peak\n",
+           mode, ms, size.width(), size.height(), std::max(0.0, peak_rss_mb() - baselineMB));
+}
+
+static void bench(const char* name, const sk_sp<SkData>& data, int thumbnail, int loops) {
+    std::unique_ptr<SkAndroidCodec> probe = data ? SkAndroidCodec::MakeFromData(data) : nullptr;
+    if (!probe) {
+        printf("%s could not be decoded\n", name);
+        return;
+    }
+    const SkISize full = probe->getInfo().dimensions();
+    const float scale = std::min(1.0f, (float)thumbnail / std::max(full.width(), full.height()));
+    const SkISize size = {std::max(1, (int)std::round(full.width()  * scale)),
+                          std::max(1, (int)std::round(full.height() * scale))};
+    printf("%s %dx%d\n", name, full.width(), full.height());
+
+    const SkImageInfo thumbInfo = SkImageInfo::MakeN32Premul(size.width(), size.height());
+
+    isolated([&](double baselineMB) {
+        SkBitmap decoded, thumb;
+        const double ms = best_ms(loops, [&] {
+            std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+            decoded.allocPixels(SkImageInfo::MakeN32Premul(full.width(), full.height()));
+            thumb.allocPixels(thumbInfo);
+            const SkCodec::Result result = codec->getPixels(decoded.pixmap());
+            const bool ok = result == SkCodec::kSuccess &&
+                            decoded.pixmap().scalePixels(thumb.pixmap(),
+                                                         SkSamplingOptions(SkFilterMode::kLinear,
+                                                                           SkMipmapMode::kLinear));
+            decoded.reset();
+            return ok;
+        });
+        report("decode+scale", ms, size, baselineMB);
+    });
+
+    isolated([&](double baselineMB) {
+        SkBitmap thumb;
+        SkISize sampled;
+        const double ms = best_ms(loops, [&] {
+            std::unique_ptr<SkAndroidCodec> codec = SkAndroidCodec::MakeFromData(data);
+            SkAndroidCodec::AndroidOptions options;
+            sampled = size;
+            options.fSampleSize = codec->computeSampleSize(&sampled);
+            sampled = codec->getSampledDimensions(options.fSampleSize);
+            thumb.allocPixels(thumbInfo.makeDimensions(sampled));
+            return codec->getAndroidPixels(thumb.info(), thumb.getPixels(), thumb.rowBytes(),
+                                           &options) == SkCodec::kSuccess;
+        });
+        report("sampled", ms, sampled, baselineMB);
+    });
+
+    isolated([&](double baselineMB) {
+        SkBitmap thumb;
+        const double ms = best_ms(loops, [&] {
+            std::unique_ptr<SkAndroidCodec> codec = SkAndroidCodec::MakeFromData(data);
+            SkAndroidCodec::AndroidOptions options;
+            options.fAreaAverage = true;
+            thumb.allocPixels(thumbInfo);
+            return codec->getAndroidPixels(thumb.info(), thumb.getPixels(), thumb.rowBytes(),
+                                           &options) == SkCodec::kSuccess;
+        });
+        report("area average", ms, size, baselineMB);
+    });
+}
+
+int main(int argc, char** argv) {
+    int thumbnail = 256;
+    int loops = 3;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+            thumbnail = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+            loops = std::max(1, atoi(argv[++i]));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    SkGraphics::Init();
+
+    if (paths.empty()) {
+        sk_sp<SkData> jpeg, png;
+        {
+            // Encoded, and the pixels freed, before any child is forked.
+            const SkBitmap photo = make_photo(5664, 4248);
+            SkDynamicMemoryWStream jpegStream, pngStream;
+            if (SkJpegEncoder::Encode(&jpegStream, photo.pixmap(), {})) {
+                jpeg = jpegStream.detachAsData();
+            }
+            SkPngEncoder::Options pngOptions;
+            pngOptions.fZLibLevel = 1;
+            if (SkPngEncoder::Encode(&pngStream, photo.pixmap(), pngOptions)) {
+                png = pngStream.detachAsData();
+            }
+        }
+        bench("synthetic jpeg", jpeg, thumbnail, loops);
+        bench("synthetic png", png, thumbnail, loops);
+    }
+    for (const char* path : paths) {
+        bench(path, SkData::MakeFromFileName(path), thumbnail, loops);
+    }
+    return 0;
+}
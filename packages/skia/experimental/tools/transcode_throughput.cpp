@@ -0,0 +1,214 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures the time and memory it takes to convert a large image to a JPEG, three ways:
+//   decode+encode  decode to a full SkBitmap, then SkJpegEncoder::Encode() it,
+//   transcode      SkTranscoder::Transcode() into an SkJpegEncoder, a band of rows at a time,
+//   transcode 1/2  the same, at half the width and height.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/transcode_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o transcode_throughput
+//  ./transcode_throughput [IMAGE ...] [--loops N]
+//
+// Without images it makes a 50 megapixel JPEG and PNG. For each image and way it prints the best
+// time over LOOPS runs (default 3), the size of the JPEG written, and the peak memory the run
+// needed beyond what the process held before it. Each way runs in a child process of its own, so
+// that one's peak does not hide the next one's. Codecs that cannot decode scanlines top-down are
+// decoded whole by Transcode() too, and show no saving. SkJpegEncoder optimizes its Huffman
+// tables, for which libjpeg keeps the DCT coefficients of the whole image (about 2.5 bytes a
+// pixel at 4:2:0), so that is the floor for a full-size transcode to JPEG.
+
+#include "include/codec/SkCodec.h"
+#include "include/codec/SkTranscoder.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorPriv.h"
+#include "include/core/SkData.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkStream.h"
+#include "include/encode/SkEncoder.h"
+#include "include/encode/SkJpegEncoder.h"
+#include "include/encode/SkPngEncoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Peak resident set size of the process, in megabytes, or 0 if unknown.
+static double peak_rss_mb() {
+#if defined(_WIN32)
+    return 0;
+#elif defined(__APPLE__)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / (1024.0 * 1024.0) : 0;
+#else
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / 1024.0 : 0;
+#endif
+}
+
+// Runs |run| in a child process, so that the peak memory it reports is its own. A forked child
+// starts out with the parent's resident pages as its peak, so that is subtracted. Runs inline
+// where there is no fork().
+static void isolated(const std::function<void(double baselineMB)>& run) {
+#if defined(_WIN32)
+    run(peak_rss_mb());
+#else
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        run(peak_rss_mb());
+        fflush(stdout);
+        _exit(0);
+    }
+    if (pid > 0) {
+        int status;
+        waitpid(pid, &status, 0);
+    } else {
+        run(peak_rss_mb());
+    }
+#endif
+}
+
+static SkBitmap make_photo(int width, int height) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(width, height, /*isOpaque=*/true);
+    for (int y = 0; y < height; ++y) {
+        uint32_t* row = bitmap.getAddr32(0, y);
+        for (int x = 0; x < width; ++x) {
+            const int texture = ((x / 7 + y / 5) & 3) * 8;
+            row[x] = SkPackARGB32(0xFF, (x * 255 / width + texture) & 0xFF,
+                                  (y * 255 / height + texture) & 0xFF, 128 + texture);
+        }
+    }
+    return bitmap;
+}
+
+// Returns the fastest of |loops| runs of |convert|, in milliseconds, or -1 if it ever fails.
+static double best_ms(int loops, const std::function<bool()>& convert) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!convert()) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static void report(const char* mode, double ms, size_t bytes, double baselineMB) {
+    if (ms < 0) {
+        printf("  %-14s %10s\n", mode, "failed");
+        return;
+    }
+    printf("  %-14s %8.1fms %8.2fMB jpeg %8.1fMB peak\n",
+           mode, ms, bytes / (1024.0 * 1024.0), std::max(0.0, peak_rss_mb() - baselineMB));
+}
+
+static void bench(const char* name, const sk_sp<SkData>& data, int loops) {
+    std::unique_ptr<SkCodec> probe = data ? SkCodec::MakeFromData(data) : nullptr;
+    if (!probe) {
+        printf("%s could not be decoded\n", name);
+        return;
+    }
+    const SkISize full = probe->getInfo().dimensions();
+    printf("%s %dx%d\n", name, full.width(), full.height());
+    probe.reset();
+
+    SkJpegEncoder::Options jpegOptions;
+    jpegOptions.fQuality = 90;
+
+    isolated([&](double baselineMB) {
+        size_t bytes = 0;
+        const double ms = best_ms(loops, [&] {
+            std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+            SkBitmap decoded;
+            decoded.allocPixels(codec->getInfo().makeColorType(kN32_SkColorType)
+                                                .makeAlphaType(kPremul_SkAlphaType));
+            SkDynamicMemoryWStream stream;
+            if (codec->getPixels(decoded.pixmap()) != SkCodec::kSuccess ||
+                !SkJpegEncoder::Encode(&stream, decoded.pixmap(), jpegOptions)) {
+                return false;
+            }
+            bytes = stream.bytesWritten();
+            return true;
+        });
+        report("decode+encode", ms, bytes, baselineMB);
+    });
+
+    for (int divisor : {1, 2}) {
+        isolated([&](double baselineMB) {
+            size_t bytes = 0;
+            const double ms = best_ms(loops, [&] {
+                std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(data);
+                SkDynamicMemoryWStream stream;
+                SkTranscoder::Options options;
+                options.fDimensions = {full.width() / divisor, full.height() / divisor};
+                const SkCodec::Result result = SkTranscoder::Transcode(
+                        codec.get(),
+                        [&](const SkPixmap& src) -> std::unique_ptr<SkEncoder> {
+                            return SkJpegEncoder::Make(&stream, src, jpegOptions);
+                        },
+                        options);
+                bytes = stream.bytesWritten();
+                return result == SkCodec::kSuccess;
+            });
+            report(divisor == 1 ? "transcode" : "transcode 1/2", ms, bytes, baselineMB);
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    int loops = 3;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+            loops = std::max(1, atoi(argv[++i]));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    SkGraphics::Init();
+
+    if (paths.empty()) {
+        sk_sp<SkData> jpeg, png;
+        {
+            // Encoded, and the pixels freed, before any child is forked.
+            const SkBitmap photo = make_photo(8160, 6120);
+            SkDynamicMemoryWStream jpegStream, pngStream;
+            if (SkJpegEncoder::Encode(&jpegStream, photo.pixmap(), {})) {
+                jpeg = jpegStream.detachAsData();
+            }
+            SkPngEncoder::Options pngOptions;
+            pngOptions.fZLibLevel = 1;
+            if (SkPngEncoder::Encode(&pngStream, photo.pixmap(), pngOptions)) {
+                png = pngStream.detachAsData();
+            }
+        }
+        bench("synthetic jpeg", jpeg, loops);
+        bench("synthetic png", png, loops);
+    }
+    for (const char* path : paths) {
+        bench(path, SkData::MakeFromFileName(path), loops);
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Measures how fast the raster backend draws Perlin noise (feTurbulence) and displaces an image by
+// it (feDisplacementMap), next to a Gaussian blur of the same image for scale.
+//
+//  c++ -std=c++17 -O2 -I. experimental/tools/turbulence_throughput.cpp <path to libskia.a>
+//      -ljpeg -lpng -lz -lpthread -ldl -o turbulence_throughput
+//  ./turbulence_throughput [SIZE] [LOOPS] [THREADS]
+//
+// Everything is SIZExSIZE (default 1024). For each case it prints the best time over LOOPS runs
+// (default 5), the throughput in megapixels per second and how much slower than the blur it is.
+// With THREADS > 1 the image filters are evaluated on a thread pool of that many threads (see
+// SkImageFilters::Parallel); the noise is drawn on the calling thread either way.
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkSize.h"
+#include "include/core/SkSurface.h"
+#include "include/effects/SkImageFilters.h"
+#include "include/effects/SkPerlinNoiseShader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+// Returns the fastest of |loops| runs of |run|, in milliseconds, or -1 if it ever fails.
+static double best_ms(int loops, const std::function<bool()>& run) {
+    double best = -1;
+    for (int i = 0; i < loops; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!run()) {
+            return -1;
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = best < 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::max(2, atoi(argv[1])) : 1024;
+    const int loops = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+    const int threads = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
+
+    SkGraphics::Init();
+
+    std::unique_ptr<SkExecutor> executor =
+            threads > 1 ? SkExecutor::MakeFIFOThreadPool(threads) : nullptr;
+    auto parallel = [&](sk_sp<SkImageFilter> filter) {
+        return executor ? SkImageFilters::Parallel(executor.get(), std::move(filter)) : filter;
+    };
+
+    const SkISize tile = SkISize::Make(size, size);
+    const float frequency = 4.f / size;
+    struct {
+        const char*     fName;
+        sk_sp<SkShader> fNoise;
+    } noises[] = {
+        {"fractal",
+         SkPerlinNoiseShader::MakeFractalNoise(frequency, frequency, 4, 0, nullptr)},
+        {"fractal stitched",
+         SkPerlinNoiseShader::MakeFractalNoise(frequency, frequency, 4, 0, &tile)},
+        {"turbulence",
+         SkPerlinNoiseShader::MakeTurbulence(frequency, frequency, 4, 0, nullptr)},
+        {"turbulence stitched",
+         SkPerlinNoiseShader::MakeTurbulence(frequency, frequency, 4, 0, &tile)},
+    };
+
+    sk_sp<SkSurface> surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(size, size));
+    const double megapixels = size * (double)size / 1e6;
+
+    // The noise doubles as the image that is blurred and displaced.
+    SkPaint noisePaint;
+    noisePaint.setShader(noises[0].fNoise);
+    surface->getCanvas()->drawPaint(noisePaint);
+    const sk_sp<SkImage> source = surface->makeImageSnapshot();
+    const SkIRect bounds = SkIRect::MakeWH(size, size);
+
+    auto filter = [&](const sk_sp<SkImageFilter>& imageFilter) {
+        return [&, imageFilter = parallel(imageFilter)] {
+            SkIRect outSubset;
+            SkIPoint offset;
+            return SkToBool(source->makeWithFilter(nullptr, imageFilter.get(), bounds, bounds,
+                                                   &outSubset, &offset));
+        };
+    };
+    auto draw = [&](const sk_sp<SkShader>& noise) {
+        return [&, noise] {
+            SkPaint paint;
+            paint.setShader(noise);
+            surface->getCanvas()->drawPaint(paint);
+            return true;
+        };
+    };
+
+    struct {
+        const char*           fName;
+        std::function<bool()> fRun;
+    } cases[] = {
+        {"blur", filter(SkImageFilters::Blur(3, 3, nullptr))},
+        {noises[0].fName, draw(noises[0].fNoise)},
+        {noises[1].fName, draw(noises[1].fNoise)},
+        {noises[2].fName, draw(noises[2].fNoise)},
+        {noises[3].fName, draw(noises[3].fNoise)},
+        {"displacement", filter(SkImageFilters::DisplacementMap(SkColorChannel::kR,
+                                                                SkColorChannel::kG, size / 16.f,
+                                                                nullptr, nullptr))},
+    };
+
+    printf("%dx%d, %d thread%s\n", size, size, threads, threads == 1 ? "" : "s");
+    double blurMs = -1;
+    for (const auto& [name, run] : cases) {
+        const double ms = best_ms(loops, run);
+        if (ms < 0) {
+            printf("  %-20s %10s\n", name, "failed");
+            continue;
+        }
+        if (blurMs < 0) {
+            blurMs = ms;
+        }
+        printf("  %-20s %8.2fms %9.1fMP/s %6.1fx blur\n",
+               name, ms, ms > 0 ? megapixels / (ms / 1000) : 0, blurMs > 0 ? ms / blurMs : 0);
+    }
+    return 0;
+}
@@ -206,6 +206,7 @@ public:
         AndroidOptions()
             : SkCodec::Options()
             , fSampleSize(1)
+            , fAreaAverage(false)
         {}
 
         /**
@@ -216,6 +217,19 @@ public:
          *  The default is 1, representing no downscaling.
          */
         int fSampleSize;
+
+        /**
+         *  If true, the destination may be any size no larger than the image (or
+         *  fSubset), and whatever downscaling the codec cannot do natively is done
+         *  by averaging each destination pixel over the source pixels it covers,
+         *  rather than by sampling. fSampleSize is ignored.
+         *
+         *  This is supported for kRGBA_8888, kBGRA_8888, kGray_8 and kAlpha_8
+         *  destinations, and only for the first frame.
+         *
+         *  The default is false.
+         */
+        bool fAreaAverage;
     };
 
     /**
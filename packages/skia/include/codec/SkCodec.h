@@ -28,6 +28,7 @@
 #include <vector>
 
 class SkData;
+class SkExecutor;
 class SkFrameHolder;
 class SkImage;
 class SkPngChunkReader;
@@ -298,6 +299,7 @@ public:
             , fSubset(nullptr)
             , fFrameIndex(0)
             , fPriorFrame(kNoFrame)
+            , fExecutor(nullptr)
         {}
 
         ZeroInitialized            fZeroInitialized;
@@ -341,6 +343,17 @@ public:
          *  If set to kNoFrame, the codec will decode any necessary required frame(s) first.
          */
         int                        fPriorFrame;
+
+        /**
+         *  If not NULL, codecs that support it may split getPixels() into independent pieces
+         *  and decode them in parallel on this executor. The call still blocks until the whole
+         *  image is decoded. Decoding falls back to a single thread when the image cannot be
+         *  split.
+         *
+         *  Currently only used by JPEG, for sequential images with restart markers that line up
+         *  with MCU rows.
+         */
+        SkExecutor*                fExecutor;
     };
 
     /**
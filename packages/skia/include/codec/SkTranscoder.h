@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTranscoder_DEFINED
+#define SkTranscoder_DEFINED
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSize.h"
+#include "include/private/base/SkAPI.h"
+
+#include <functional>
+#include <memory>
+
+class SkEncoder;
+class SkPixmap;
+
+namespace SkTranscoder {
+
+struct Options {
+    /**
+     *  The size of the encoded image. This may not be larger than the image being decoded in
+     *  either dimension. Downscaling is done by the codec where it can, and by area averaging
+     *  otherwise, which supports 8-bit RGBA, BGRA, gray and alpha color types.
+     *
+     *  The default (empty) keeps the decoded size.
+     */
+    SkISize fDimensions = {0, 0};
+
+    /**
+     *  The color type rows are decoded to and handed to the encoder in.
+     */
+    SkColorType fColorType = kN32_SkColorType;
+
+    /**
+     *  The color space to convert to while decoding. The default (nullptr) keeps the color space
+     *  of the encoded image.
+     */
+    sk_sp<SkColorSpace> fColorSpace;
+
+    /**
+     *  How many rows are decoded before they are passed on to the encoder. Memory use is
+     *  proportional to this and to the image width, not to the image height.
+     */
+    int fBufferRows = 16;
+};
+
+/**
+ *  Creates the encoder for the transcoded image. |src| describes the image to be encoded, but
+ *  its pixels are only a buffer for a few rows: every row is supplied through
+ *  SkEncoder::encodeRows(const SkPixmap&). For example:
+ *
+ *      [&](const SkPixmap& src) { return SkJpegEncoder::Make(&stream, src, jpegOptions); }
+ *
+ *  |src| remains valid for the lifetime of the encoder.
+ */
+using EncoderFactory = std::function<std::unique_ptr<SkEncoder>(const SkPixmap& src)>;
+
+/**
+ *  Decodes the first frame of |codec| and encodes it with the encoder made by |makeEncoder|,
+ *  a band of rows at a time, so that the image is never held in memory all at once.
+ *
+ *  Codecs that cannot decode scanlines top-down (GIF, bottom-up BMP and WebP, for example) are
+ *  decoded whole before being encoded.
+ *
+ *  Returns kSuccess, or kIncompleteInput or kErrorInInput if only some of the image could be
+ *  decoded; the rest is filled as SkCodec::getPixels() would fill it, and the encoded image is
+ *  complete. Returns kInvalidConversion if the encoder could not be created, and kInternalError
+ *  if encoding failed.
+ */
+SK_API SkCodec::Result Transcode(SkCodec* codec, const EncoderFactory& makeEncoder,
+                                 const Options& options);
+
+}  // namespace SkTranscoder
+
+#endif  // SkTranscoder_DEFINED
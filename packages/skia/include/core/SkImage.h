@@ -35,6 +35,7 @@ class SkPicture;
 class SkPixmap;
 class SkShader;
 class SkSurfaceProps;
+class SkYUVAPixmaps;
 enum SkColorType : int;
 enum class SkTextureCompressionType;
 enum class SkTileMode;
@@ -229,6 +230,17 @@ SK_API sk_sp<SkImage> RasterFromData(const SkImageInfo& info,
                                      sk_sp<SkData> pixels,
                                      size_t rowBytes);
 
+/** Creates a CPU-backed SkImage from YUVA planes. The planes are shared if yuvaPixmaps owns its
+    storage and copied otherwise. When drawn to a raster canvas the planes are sampled directly,
+    without first converting the whole image to RGBA.
+
+    @param yuvaPixmaps       Y, U, V (and A) planes and how to convert them to RGB
+    @param imageColorSpace   range of colors of the resulting image; may be nullptr
+    @return                  SkImage, or nullptr if yuvaPixmaps is not valid
+*/
+SK_API sk_sp<SkImage> RasterFromYUVAPixmaps(const SkYUVAPixmaps& yuvaPixmaps,
+                                            sk_sp<SkColorSpace> imageColorSpace);
+
 }  // namespace SkImages
 
 /** \class SkImage
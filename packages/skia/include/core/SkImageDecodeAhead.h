@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkImageDecodeAhead_DEFINED
+#define SkImageDecodeAhead_DEFINED
+
+#include "include/core/SkRefCnt.h"
+#include "include/private/base/SkAPI.h"
+
+#include <memory>
+
+class SkExecutor;
+class SkImage;
+class SkPicture;
+
+/**
+ *  Decodes lazy images (those made from encoded data, a generator or a picture) on an
+ *  SkExecutor before they are drawn, e.g. the images of a picture that is about to be played
+ *  back, or those a scroll is predicted to reveal. The decoded pixels go to the same cache a
+ *  draw would put them in, so the draw finds them there instead of stalling on the decode.
+ *
+ *  Queuing an image that is already decoded, or already being decoded, does nothing, and a draw
+ *  of an image while it is being decoded ahead waits for that decode rather than starting its
+ *  own.
+ *
+ *  The methods of this class may be called from any thread.
+ */
+class SK_API SkImageDecodeAhead {
+public:
+    /**
+     *  Decodes on |executor|, which must outlive this object.
+     */
+    explicit SkImageDecodeAhead(SkExecutor* executor);
+
+    /**
+     *  Waits for the queued decodes to finish.
+     */
+    ~SkImageDecodeAhead();
+
+    /**
+     *  Queues a decode of |image|. Returns false if |image| is not a lazy raster image, or if it
+     *  is already decoded or being decoded.
+     */
+    bool queue(sk_sp<SkImage> image);
+
+    /**
+     *  Queues decodes of the images |picture| draws with drawImage(), drawImageRect(),
+     *  drawImageLattice(), drawAtlas() and image sets, within its cull rect, including those in
+     *  nested pictures. Returns the number of decodes queued.
+     */
+    int queue(const SkPicture* picture);
+
+    /**
+     *  Blocks until every decode queued so far has finished.
+     */
+    void wait();
+
+    struct Stats {
+        /** The number of images decoded ahead. */
+        int fDecoded = 0;
+
+        /** The number of images queued that turned out to be decoded already. */
+        int fAlreadyDecoded = 0;
+
+        /** The number of images queued that failed to decode. */
+        int fFailed = 0;
+
+        /** The number of images decoded ahead whose pixels were then found in the cache. */
+        int fHits = 0;
+
+        /**
+         *  The number of images decoded ahead whose pixels were purged from the cache, or which
+         *  were deleted, before they were ever drawn.
+         */
+        int fWasted = 0;
+    };
+
+    /**
+     *  Returns the counts so far. Images that are decoded ahead but not yet drawn (or purged) are
+     *  counted in neither fHits nor fWasted.
+     */
+    Stats stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> fImpl;
+};
+
+#endif  // SkImageDecodeAhead_DEFINED
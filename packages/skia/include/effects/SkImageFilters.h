@@ -22,6 +22,7 @@
 
 class SkBlender;
 class SkColorFilter;
+class SkExecutor;
 class SkPaint;
 class SkRegion;
 
@@ -336,6 +337,17 @@ public:
     static sk_sp<SkImageFilter> Offset(SkScalar dx, SkScalar dy, sk_sp<SkImageFilter> input,
                                        const CropRect& cropRect = {});
 
+    /**
+     *  Create a filter that produces the same output as 'input', but lets the filters within it
+     *  that have several inputs (merge, blend, arithmetic, displacement map and runtime shader)
+     *  evaluate those inputs concurrently on 'executor' when filtering on the CPU. This does not
+     *  change how the filter is evaluated on the GPU. The executor is not serialized.
+     *  @param executor The executor to run inputs on; it must outlive the filter. If null,
+     *                  'input' is returned.
+     *  @param input    The filter DAG to evaluate. If null, null is returned.
+     */
+    static sk_sp<SkImageFilter> Parallel(SkExecutor* executor, sk_sp<SkImageFilter> input);
+
     /**
      *  Create a filter that produces the SkPicture as its output, clipped to both 'targetRect' and
      *  the picture's internal cull rect.
@@ -460,6 +472,34 @@ public:
     static sk_sp<SkImageFilter> Tile(const SkRect& src, const SkRect& dst,
                                      sk_sp<SkImageFilter> input);
 
+    /**
+     *  Create a filter that produces the same output as 'input', but evaluates it on the CPU one
+     *  tile of the output at a time, so the intermediate images of the DAG are no larger than a
+     *  tile and the margin each filter needs around it. Peak memory is then the output image plus
+     *  the intermediates of the tiles in flight, rather than a layer-sized image per intermediate.
+     *  This does not change how the filter is evaluated on the GPU. The executor is not
+     *  serialized.
+     *
+     *  With TileReuse::kYes, the filter keeps its last output and source in the image filter
+     *  cache. When it is next drawn with the same matrix and bounds (e.g. the next frame of an
+     *  animation), only the tiles whose required input overlaps a change to the source are
+     *  filtered again; the others are copied from the last output. This only happens when every
+     *  filter in 'input' reports which input pixels each output pixel depends on: color filters,
+     *  offsets, matrix transforms, merges, crops and decal blurs do.
+     *  @param tileSize The size of the tiles, in layer pixels. If empty, 'input' is returned.
+     *  @param executor If not null, tiles (and the inputs within them, see Parallel()) are
+     *                  evaluated concurrently on it; it must outlive the filter.
+     *  @param input    The filter DAG to evaluate. If null, null is returned.
+     *  @param reuse    Whether to reuse the tiles of the last output that are still valid.
+     */
+    enum class TileReuse : bool {
+        kNo = false,
+        kYes = true
+    };
+    static sk_sp<SkImageFilter> Tiled(const SkISize& tileSize, SkExecutor* executor,
+                                      sk_sp<SkImageFilter> input,
+                                      TileReuse reuse = TileReuse::kNo);
+
     // Morphology filter effects
 
     /**
@@ -43,6 +43,16 @@ public:
      */
     bool encodeRows(int numRows);
 
+    /**
+     *  Encode the rows of |rows| as the next rows of input, instead of reading them from the
+     *  src.  |rows| must have the src's width, color type and alpha type.
+     *
+     *  This allows an image to be encoded without ever being resident in memory all at once:
+     *  if every row is supplied this way, the src only describes the image, and its pixels are
+     *  never read.  Not supported by encoders created from YUVA pixmaps.
+     */
+    bool encodeRows(const SkPixmap& rows);
+
     virtual ~SkEncoder() {}
 
 protected:
@@ -55,9 +65,28 @@ protected:
         , fStorage(storageBytes)
     {}
 
+    /**
+     *  The address and row bytes of row |y| of the input, which may have been supplied by
+     *  encodeRows(const SkPixmap&) rather than fSrc.
+     */
+    const void* srcRowAddr(int y) const {
+        return fRows ? fRows->addr(0, y - fRowsTop) : fSrc.addr(0, y);
+    }
+    size_t srcRowBytes() const { return fRows ? fRows->rowBytes() : fSrc.rowBytes(); }
+
+    /**
+     *  True while encoding rows supplied by encodeRows(const SkPixmap&). Encoders that read their
+     *  input from somewhere other than fSrc must fail rather than ignore them.
+     */
+    bool encodingSuppliedRows() const { return fRows != nullptr; }
+
     const SkPixmap&        fSrc;
     int                    fCurrRow;
     skia_private::AutoTMalloc<uint8_t> fStorage;
+
+private:
+    const SkPixmap*        fRows = nullptr;
+    int                    fRowsTop = 0;
 };
 
 #endif
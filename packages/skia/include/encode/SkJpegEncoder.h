@@ -16,6 +16,7 @@
 class SkColorSpace;
 class SkData;
 class SkEncoder;
+class SkExecutor;
 class SkPixmap;
 class SkWStream;
 class SkImage;
@@ -86,6 +87,20 @@ struct Options {
      */
     const skcms_ICCProfile* fICCProfile = nullptr;
     const char* fICCProfileDescription = nullptr;
+
+    /**
+     *  If not null, Encode() splits large images into horizontal bands that are encoded in
+     *  parallel on this executor, and joins them into a single baseline jpeg with a restart
+     *  marker at the start of each band.  The call still blocks until the whole image is
+     *  written.
+     *
+     *  Since the bands must share their Huffman tables, a jpeg encoded this way uses the
+     *  standard tables instead of ones optimized for the image, and is typically a few percent
+     *  larger.
+     *
+     *  Ignored by Make(), and when encoding an SkYUVAPixmaps.
+     */
+    SkExecutor* fExecutor = nullptr;
 };
 
 /**
@@ -12,16 +12,48 @@
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSize.h"
+#include "include/private/base/SkMutex.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
+class SkExecutor;
 class SkImage;
+class SkTaskGroup;
 
 class SkAnimCodecPlayer {
 public:
     SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec);
+
+    struct PrefetchOptions {
+        /**
+         *  If not null, the frames after the current one are decoded ahead on this executor, which
+         *  must outlive the player. Otherwise frames are only decoded when getFrame() needs them.
+         */
+        SkExecutor* fExecutor = nullptr;
+
+        /**
+         *  How many frames after the current one to decode ahead and keep.
+         */
+        int fFramesAhead = 2;
+
+        /**
+         *  Roughly how many bytes of decoded frames to keep. The current frame and the frames
+         *  ahead of it are always kept; within what is left, frames that others can be decoded
+         *  from are kept as checkpoints for seeking, spread over the animation. Zero keeps every
+         *  frame that is decoded.
+         */
+        size_t fMemoryBudget = 0;
+    };
+
+    /**
+     *  Plays |codec| with frames decoded ahead and kept as |options| specifies. Long animations
+     *  should set a memory budget, since by default every frame decoded is kept.
+     */
+    SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec, const PrefetchOptions& options);
+
     ~SkAnimCodecPlayer();
 
     /**
@@ -53,6 +85,11 @@ public:
 
 
 private:
+    // fDecodeMutex serializes decoding with the codec. fMutex guards the decoded frames and the
+    // current index, which the prefetch task also uses, and is never held while decoding. Where
+    // both are held, fDecodeMutex is taken first.
+    SkMutex                         fDecodeMutex;
+    SkMutex                         fMutex;
     std::unique_ptr<SkCodec>        fCodec;
     SkImageInfo                     fImageInfo;
     std::vector<SkCodec::FrameInfo> fFrameInfos;
@@ -60,7 +97,24 @@ private:
     int                             fCurrIndex = 0;
     uint32_t                        fTotalDuration;
 
+    // Only used with PrefetchOptions.
+    bool                            fKeepRequiredFrames = false;
+    int                             fFramesAhead = 0;
+    size_t                          fMaxFrames = 0;      // 0 keeps every frame.
+    std::vector<bool>               fCheckpoints;        // Per frame, or empty.
+    size_t                          fCachedFrames = 0;
+    uint64_t                        fUseCount = 0;
+    std::vector<uint64_t>           fLastUse;            // Per frame, for evicting.
+    int                             fPrefetchGeneration = 0;
+    int                             fPrefetchedFrom = -1;
+    std::unique_ptr<SkTaskGroup>    fPrefetchTasks;
+
     sk_sp<SkImage> getFrameAt(int index);
+    sk_sp<SkImage> decodeFrame(int index, sk_sp<SkImage> requiredImage);
+    void cacheFrame(int index, sk_sp<SkImage> image);
+    bool isAhead(int index) const;
+    bool isCheckpoint(int index) const;
+    void prefetch();
 };
 
 #endif
@@ -633,7 +633,6 @@ SIN Vec<N,float>  ceil(const Vec<N,float>& x) { return map( ceilf, x); }
 SIN Vec<N,float> floor(const Vec<N,float>& x) { return map(floorf, x); }
 SIN Vec<N,float> trunc(const Vec<N,float>& x) { return map(truncf, x); }
 SIN Vec<N,float> round(const Vec<N,float>& x) { return map(roundf, x); }
-SIN Vec<N,float>  sqrt(const Vec<N,float>& x) { return map( sqrtf, x); }
 SIN Vec<N,float>   abs(const Vec<N,float>& x) { return map( fabsf, x); }
 SIN Vec<N,float>   fma(const Vec<N,float>& x,
                        const Vec<N,float>& y,
@@ -661,6 +660,30 @@ SIN Vec<N,int> lrint(const Vec<N,float>& x) {
                 lrint(x.hi));
 }
 
+SI Vec<1,float> sqrt(const Vec<1,float>& x) {
+    return sqrtf(x.val);
+}
+SIN Vec<N,float> sqrt(const Vec<N,float>& x) {
+    // sqrt is correctly rounded, so these give the same results as sqrtf() on each lane.
+#if SKVX_USE_SIMD && defined(__AVX__)
+    if constexpr (N == 8) {
+        return bit_pun<Vec<N,float>>(_mm256_sqrt_ps(bit_pun<__m256>(x)));
+    }
+#endif
+#if SKVX_USE_SIMD && defined(__SSE__)
+    if constexpr (N == 4) {
+        return bit_pun<Vec<N,float>>(_mm_sqrt_ps(bit_pun<__m128>(x)));
+    }
+#endif
+#if SKVX_USE_SIMD && defined(__aarch64__)
+    if constexpr (N == 4) {
+        return bit_pun<Vec<N,float>>(vsqrtq_f32(bit_pun<float32x4_t>(x)));
+    }
+#endif
+    return join(sqrt(x.lo),
+                sqrt(x.hi));
+}
+
 SIN Vec<N,float> fract(const Vec<N,float>& x) { return x - floor(x); }
 
 // Assumes inputs are finite and treat/flush denorm half floats as/to zero.
@@ -6,9 +6,11 @@
  */
 
 #include "src/codec/SkAndroidCodecAdapter.h"
+
+#include "include/core/SkRect.h"
+#include "src/codec/SkAreaResampler.h"
 #include "src/codec/SkCodecPriv.h"
 
-struct SkIRect;
 struct SkImageInfo;
 
 SkAndroidCodecAdapter::SkAndroidCodecAdapter(SkCodec* codec)
@@ -26,5 +28,14 @@ bool SkAndroidCodecAdapter::onGetSupportedSubset(SkIRect* desiredSubset) const {
 
 SkCodec::Result SkAndroidCodecAdapter::onGetAndroidPixels(const SkImageInfo& info, void* pixels,
         size_t rowBytes, const AndroidOptions& options) {
-    return this->codec()->getPixels(info, pixels, rowBytes, &options);
+    const SkCodec::Result result = this->codec()->getPixels(info, pixels, rowBytes, &options);
+    if (SkCodec::kInvalidScale == result && options.fAreaAverage) {
+        // The codecs wrapped here either scale natively to any size (and average as they do), or
+        // not at all.
+        const SkIRect subset = options.fSubset ? *options.fSubset
+                                               : SkIRect::MakeSize(this->codec()->dimensions());
+        return SkAreaResampler::DecodeThenResample(this->codec(), info, pixels, rowBytes, subset,
+                                                   options);
+    }
+    return result;
 }
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkAreaResampler.h"
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkRect.h"
+#include "include/private/base/SkTemplates.h"
+#include "src/base/SkVx.h"
+
+#include <algorithm>
+
+std::unique_ptr<SkAreaResampler> SkAreaResampler::Make(const SkImageInfo& dstInfo, void* dst,
+                                                       size_t dstRowBytes, SkISize srcSize) {
+    switch (dstInfo.colorType()) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+        case kGray_8_SkColorType:
+        case kAlpha_8_SkColorType:
+            break;
+        default:
+            return nullptr;
+    }
+    if (!dst || dstInfo.isEmpty() || dstRowBytes < dstInfo.minRowBytes() ||
+        dstInfo.width() > srcSize.width() || dstInfo.height() > srcSize.height()) {
+        return nullptr;
+    }
+    return std::unique_ptr<SkAreaResampler>(
+            new SkAreaResampler(dstInfo, dst, dstRowBytes, srcSize));
+}
+
+SkAreaResampler::SkAreaResampler(const SkImageInfo& dstInfo, void* dst, size_t dstRowBytes,
+                                 SkISize srcSize)
+    : fDstInfo(dstInfo)
+    , fSrcRowInfo(dstInfo.makeWH(srcSize.width(), 1))
+    , fDst(dst)
+    , fDstRowBytes(dstRowBytes)
+    , fSrcWidth(srcSize.width())
+    , fSrcHeight(srcSize.height())
+    , fChannels(dstInfo.bytesPerPixel())
+    , fUnpremul(dstInfo.alphaType() == kUnpremul_SkAlphaType && fChannels == 4) {
+    // Horizontally, in units where the row is srcWidth * dstWidth wide, source column x covers
+    // [x * dstWidth, (x + 1) * dstWidth) and destination column X covers
+    // [X * srcWidth, (X + 1) * srcWidth).
+    const int64_t srcWidth = srcSize.width();
+    const int64_t dstWidth = dstInfo.width();
+    fXStart.reserve(dstWidth);
+    fXWeightStart.reserve(dstWidth + 1);
+    for (int64_t X = 0; X < dstWidth; ++X) {
+        const int64_t lo = X * srcWidth;
+        const int64_t hi = lo + srcWidth;
+        const int64_t first = lo / dstWidth;
+        const int64_t last = (hi - 1) / dstWidth;
+        fXStart.push_back((int)first);
+        fXWeightStart.push_back((int)fXWeights.size());
+        for (int64_t x = first; x <= last; ++x) {
+            const int64_t overlap = std::min(hi, (x + 1) * dstWidth) - std::max(lo, x * dstWidth);
+            fXWeights.push_back((uint32_t)overlap);
+        }
+    }
+    fXWeightStart.push_back((int)fXWeights.size());
+
+    // A filtered channel is at most its largest value (255, or 255 * 255 for colors weighted by
+    // alpha) times the source width, which fits 32-bit lanes for all but the widest images.
+    const uint64_t maxChannel = fUnpremul ? 255 * 255 : 255;
+    if (maxChannel * srcWidth <= UINT32_MAX) {
+        fFiltered32.resize(dstWidth * fChannels);
+    } else {
+        fFiltered64.resize(dstWidth * fChannels);
+    }
+    fAccum.assign(dstWidth * fChannels, 0);
+}
+
+template <int N, typename T>
+void SkAreaResampler::filterRow(const uint8_t* src, T* filtered) {
+    using V = skvx::Vec<N, T>;
+    using B = skvx::Vec<N, uint8_t>;
+
+    const int dstWidth = fDstInfo.width();
+    for (int X = 0; X < dstWidth; ++X) {
+        const uint8_t* px = src + fXStart[X] * N;
+        V sum = 0;
+        for (int i = fXWeightStart[X]; i < fXWeightStart[X + 1]; ++i, px += N) {
+            V v = skvx::cast<T>(B::Load(px));
+            if constexpr (N == 4) {
+                if (fUnpremul) {
+                    // Colors are weighted by their alpha, and divided by the summed alpha when
+                    // the row is written, which averages them as if premultiplied but without
+                    // rounding them to 8 bits first.
+                    v *= (skvx::shuffle<3,3,3,3>(v) & V{T(~0), T(~0), T(~0), 0}) | V{0, 0, 0, 1};
+                }
+            }
+            sum += v * (T)fXWeights[i];
+        }
+        sum.store(filtered + X * N);
+    }
+}
+
+template <typename T>
+void SkAreaResampler::accumulate(const T* filtered, uint64_t weight) {
+    using U64x4 = skvx::Vec<4, uint64_t>;
+
+    uint64_t* accum = fAccum.data();
+    const int count = fDstInfo.width() * fChannels;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const U64x4 sum = U64x4::Load(accum + i) +
+                          skvx::cast<uint64_t>(skvx::Vec<4, T>::Load(filtered + i)) * weight;
+        sum.store(accum + i);
+    }
+    for (; i < count; ++i) {
+        accum[i] += filtered[i] * weight;
+    }
+}
+
+template <typename T>
+void SkAreaResampler::addFilteredRow(const uint8_t* src, T* filtered) {
+    const int dstHeight = fDstInfo.height();
+    if (fChannels == 4) {
+        this->filterRow<4>(src, filtered);
+    } else {
+        this->filterRow<1>(src, filtered);
+    }
+
+    const int64_t end = fSrcPos + dstHeight;
+    while (fSrcPos < end && fDstY < dstHeight) {
+        const int64_t dstEnd = (int64_t)(fDstY + 1) * fSrcHeight;
+        const int64_t overlap = std::min(end, dstEnd) - fSrcPos;
+        this->accumulate(filtered, (uint64_t)overlap);
+        fSrcPos += overlap;
+        if (fSrcPos == dstEnd) {
+            if (fChannels == 4) {
+                this->writeRow<4>();
+            } else {
+                this->writeRow<1>();
+            }
+            std::fill(fAccum.begin(), fAccum.end(), 0);
+            fDstY++;
+        }
+    }
+}
+
+template <int N>
+void SkAreaResampler::writeRow() {
+    // Rounds num / den to the nearest integer.
+    auto divide = [](uint64_t num, uint64_t den) { return (uint8_t)((num + den / 2) / den); };
+
+    uint8_t* dst = SkTAddOffset<uint8_t>(fDst, (fDstY - fDstTop) * fDstRowBytes);
+    const uint64_t* accum = fAccum.data();
+    const uint64_t area = (uint64_t)fSrcWidth * fSrcHeight;
+    for (int X = 0, dstWidth = fDstInfo.width(); X < dstWidth; ++X, dst += N, accum += N) {
+        if constexpr (N == 4) {
+            if (fUnpremul) {
+                // The colors were summed times alpha, so they are averaged over the summed alpha.
+                const uint64_t alpha = accum[3];
+                for (int c = 0; c < 3; ++c) {
+                    dst[c] = alpha ? divide(accum[c], alpha) : 0;
+                }
+                dst[3] = divide(alpha, area);
+                continue;
+            }
+        }
+        // Premultiplied colors never exceed alpha, and neither do their rounded averages.
+        for (int c = 0; c < N; ++c) {
+            dst[c] = divide(accum[c], area);
+        }
+    }
+}
+
+void SkAreaResampler::addRow(const void* row) {
+    if (fDstY >= fDstInfo.height()) {
+        return;
+    }
+    const auto* src = static_cast<const uint8_t*>(row);
+    if (!fFiltered32.empty()) {
+        this->addFilteredRow(src, fFiltered32.data());
+    } else {
+        this->addFilteredRow(src, fFiltered64.data());
+    }
+}
+
+SkCodec::Result SkAreaResampler::DecodeThenResample(SkCodec* codec, const SkImageInfo& dstInfo,
+                                                    void* dst, size_t dstRowBytes,
+                                                    const SkIRect& srcSubset,
+                                                    const SkCodec::Options& options) {
+    if (options.fFrameIndex != 0) {
+        return SkCodec::kUnimplemented;
+    }
+    auto resampler = Make(dstInfo, dst, dstRowBytes, srcSubset.size());
+    if (!resampler) {
+        return SkCodec::kInvalidScale;
+    }
+
+    SkBitmap decoded;
+    if (!decoded.tryAllocPixels(dstInfo.makeDimensions(codec->dimensions()))) {
+        return SkCodec::kInternalError;
+    }
+    SkCodec::Options decodeOptions = options;
+    decodeOptions.fSubset = nullptr;
+    decodeOptions.fZeroInitialized = SkCodec::kNo_ZeroInitialized;
+    const SkCodec::Result result = codec->getPixels(decoded.pixmap(), &decodeOptions);
+    switch (result) {
+        case SkCodec::kSuccess:
+        case SkCodec::kIncompleteInput:
+        case SkCodec::kErrorInInput:
+            // The codec has filled whatever it could not decode.
+            break;
+        default:
+            return result;
+    }
+
+    for (int y = srcSubset.top(); y < srcSubset.bottom(); ++y) {
+        resampler->addRow(decoded.getAddr(srcSubset.left(), y));
+    }
+    return result;
+}
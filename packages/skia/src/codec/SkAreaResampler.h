@@ -0,0 +1,112 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkAreaResampler_codec_DEFINED
+#define SkAreaResampler_codec_DEFINED
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkSize.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct SkIRect;
+
+/*
+ * Downscales a stream of decoded rows by area averaging: each destination pixel is the average of
+ * the source pixels under it, each weighted by how much of it is covered.
+ *
+ * The weights are the exact integer overlaps of source and destination pixels, and the sums are
+ * kept in integers wide enough never to overflow (the channels of a pixel in the lanes of a
+ * vector), so each destination pixel is the exact average rounded once.
+ *
+ * Rows are consumed top to bottom, and each destination row is written as soon as the last source
+ * row it covers arrives. Besides the destination, only two rows of sums the width of the
+ * destination are kept, so the image never has to be held at its decoded size.
+ */
+class SkAreaResampler {
+public:
+    /*
+     * Returns nullptr if |dstInfo| is larger than |srcSize| in either dimension, or does not have
+     * an 8-bit RGBA, BGRA, gray or alpha color type.
+     */
+    static std::unique_ptr<SkAreaResampler> Make(const SkImageInfo& dstInfo, void* dst,
+                                                 size_t dstRowBytes, SkISize srcSize);
+
+    /*
+     * For codecs that cannot produce scanlines top-down: decodes the first frame of |codec| whole,
+     * at its full size, and resamples |srcSubset| of it into |dst|.
+     */
+    static SkCodec::Result DecodeThenResample(SkCodec* codec, const SkImageInfo& dstInfo,
+                                              void* dst, size_t dstRowBytes,
+                                              const SkIRect& srcSubset,
+                                              const SkCodec::Options& options);
+
+    /*
+     * The format source rows must be decoded to: the destination's format, at the source width.
+     * Unpremultiplied rows are premultiplied before they are averaged.
+     */
+    const SkImageInfo& srcRowInfo() const { return fSrcRowInfo; }
+
+    void addRow(const void* row);
+
+    /*
+     * Directs the destination rows that follow to |dst|, which holds destination row |top| and
+     * the rows below it, |dstRowBytes| apart. This lets the destination be a small ring of rows
+     * that is drained as it fills, since each source row completes at most one destination row.
+     */
+    void setDst(void* dst, int top) {
+        fDst = dst;
+        fDstTop = top;
+    }
+
+    int rowsWritten() const { return fDstY; }
+
+private:
+    SkAreaResampler(const SkImageInfo& dstInfo, void* dst, size_t dstRowBytes, SkISize srcSize);
+
+    template <typename T> void addFilteredRow(const uint8_t* src, T* filtered);
+    template <int N, typename T> void filterRow(const uint8_t* src, T* filtered);
+    template <typename T> void accumulate(const T* filtered, uint64_t weight);
+    template <int N> void writeRow();
+
+    const SkImageInfo  fDstInfo;
+    const SkImageInfo  fSrcRowInfo;
+    void*              fDst;
+    int                fDstTop = 0;
+    const size_t       fDstRowBytes;
+    const int          fSrcWidth;
+    const int          fSrcHeight;
+    const int          fChannels;
+    const bool         fUnpremul;
+
+    // Destination column X averages consecutive source columns starting at fXStart[X], with the
+    // weights fXWeights[fXWeightStart[X]] up to fXWeights[fXWeightStart[X + 1]], which add up to
+    // the source width.
+    std::vector<int>      fXStart;
+    std::vector<int>      fXWeightStart;
+    std::vector<uint32_t> fXWeights;
+
+    // The current source row filtered horizontally, in 32-bit sums where they fit and 64-bit
+    // ones otherwise (only one of the two is allocated), and the sum of the filtered rows under
+    // the current destination row, weighted by their overlaps, which add up to fSrcHeight. The
+    // sums of a destination pixel are therefore its average times fSrcWidth * fSrcHeight.
+    std::vector<uint32_t> fFiltered32;
+    std::vector<uint64_t> fFiltered64;
+    std::vector<uint64_t> fAccum;
+
+    // In units where the image is fSrcHeight * destination height tall: source row y covers
+    // [y * dstHeight, (y + 1) * dstHeight) and destination row Y covers
+    // [Y * fSrcHeight, (Y + 1) * fSrcHeight).
+    int64_t            fSrcPos = 0;
+    int                fDstY = 0;
+};
+
+#endif
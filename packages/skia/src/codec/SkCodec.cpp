@@ -460,9 +460,11 @@ SkCodec::Result SkCodec::getPixels(const SkImageInfo& info, void* pixels, size_t
         return frameIndexResult;
     }
 
-    // FIXME: Support subsets somehow? Note that this works for SkWebpCodec
-    // because it supports arbitrary scaling/subset combinations.
-    if (!this->dimensionsSupported(info.dimensions())) {
+    // Scaling a subset is up to the codec (SkWebpCodec supports arbitrary combinations), but a
+    // subset that onGetValidSubset() accepted above can always be decoded at its own size.
+    const bool unscaledSubset = options->fSubset &&
+                                info.dimensions() == options->fSubset->size();
+    if (!unscaledSubset && !this->dimensionsSupported(info.dimensions())) {
         return kInvalidScale;
     }
 
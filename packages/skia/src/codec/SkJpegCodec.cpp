@@ -25,8 +25,11 @@
 #include "src/codec/SkJpegConstants.h"
 #include "src/codec/SkJpegDecoderMgr.h"
 #include "src/codec/SkJpegPriv.h"
+#include "src/codec/SkJpegRegionIndex.h"
+#include "src/codec/SkJpegRestartBands.h"
 #include "src/codec/SkParseEncodedOrigin.h"
 #include "src/codec/SkSwizzler.h"
+#include "src/core/SkTaskGroup.h"
 
 #ifdef SK_CODEC_DECODES_JPEG_GAINMAPS
 #include "include/private/SkGainmapInfo.h"
@@ -36,7 +39,9 @@
 #include "src/codec/SkJpegXmp.h"
 #endif  // SK_CODEC_DECODES_JPEG_GAINMAPS
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <csetjmp>
 #include <cstring>
 #include <utility>
@@ -645,8 +650,15 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
                                          const Options& options,
                                          int* rowsDecoded) {
     if (options.fSubset) {
-        // Subsets are not supported.
-        return kUnimplemented;
+        // Subsets are only supported with a region index.
+        if (!fRegionIndex) {
+            return kUnimplemented;
+        }
+        return this->decodeRegion(dstInfo, dst, dstRowBytes, options);
+    }
+
+    if (options.fExecutor && this->decodeRestartBands(dstInfo, dst, dstRowBytes, options)) {
+        return kSuccess;
     }
 
     // Get a pointer to the decompress info since we will use it quite frequently
@@ -684,6 +696,173 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
     return kSuccess;
 }
 
+bool SkJpegCodec::decodeRestartBands(const SkImageInfo& dstInfo, void* dst, size_t dstRowBytes,
+                                     const Options& options) {
+    // Below this size, re-parsing the stream and starting a decoder per band costs more than the
+    // parallelism saves.
+    static constexpr int64_t kMinPixels = 1024 * 1024;
+    static constexpr int kMaxBands = 16;
+
+    // Scaled decodes change the MCU geometry, so only full size decodes can be split.
+    if (dstInfo.dimensions() != this->dimensions() ||
+        (int64_t)dstInfo.width() * dstInfo.height() < kMinPixels) {
+        return false;
+    }
+
+    // Bands are cut out of the encoded bytes, so they need to be in memory.
+    auto bands = SkJpegRestartBands::Make(this->getEncodedData());
+    if (!bands || bands->width() != dstInfo.width() || bands->height() != dstInfo.height()) {
+        return false;
+    }
+    std::vector<SkJpegRestartBands::Band> split = bands->split(kMaxBands);
+    if (split.size() < 2) {
+        return false;
+    }
+
+    const skcms_ICCProfile* profile = this->getEncodedInfo().profile();
+    std::atomic<bool> succeeded{true};
+    SkTaskGroup tasks(*options.fExecutor);
+    for (const SkJpegRestartBands::Band& band : split) {
+        tasks.add([&, band] {
+            // The band carries the original header, so it picks up the same embedded profile.
+            // Pass ours along as the default in case it came from elsewhere (e.g. SkRawCodec).
+            Result result;
+            std::unique_ptr<SkCodec> codec = SkJpegCodec::MakeFromStream(
+                    SkMemoryStream::Make(band.fData), &result,
+                    profile ? SkEncodedInfo::ICCProfile::Make(*profile) : nullptr);
+            if (!codec || codec->dimensions() != SkISize{dstInfo.width(), band.fDecodeHeight}) {
+                succeeded = false;
+                return;
+            }
+
+            Options bandOptions;
+            bandOptions.fZeroInitialized = options.fZeroInitialized;
+            const SkImageInfo bandInfo = dstInfo.makeDimensions(codec->dimensions());
+            if (kSuccess != codec->startScanlineDecode(bandInfo, &bandOptions)) {
+                succeeded = false;
+                return;
+            }
+
+            // Decode and drop the context rows above the band.
+            const int contextRows = band.fOutputTop - band.fDecodeTop;
+            if (contextRows > 0) {
+                AutoTMalloc<uint8_t> scratch(dstInfo.minRowBytes());
+                for (int y = 0; y < contextRows; ++y) {
+                    if (1 != codec->getScanlines(scratch.get(), 1, 0)) {
+                        succeeded = false;
+                        return;
+                    }
+                }
+            }
+
+            void* rows = SkTAddOffset<void>(dst, band.fOutputTop * dstRowBytes);
+            if (band.fOutputHeight != codec->getScanlines(rows, band.fOutputHeight, dstRowBytes)) {
+                succeeded = false;
+            }
+        });
+    }
+    tasks.wait();
+    return succeeded;
+}
+
+sk_sp<SkData> SkJpegCodec::getEncodedData() {
+    SkStream* stream = this->stream();
+    if (!stream->getMemoryBase() || !stream->hasLength()) {
+        return nullptr;
+    }
+    return SkData::MakeWithoutCopy(stream->getMemoryBase(), stream->getLength());
+}
+
+bool SkJpegCodec::buildRegionIndex() {
+    if (!fRegionIndex) {
+        fRegionIndex = SkJpegRegionIndex::Make(this->getEncodedData());
+    }
+    return fRegionIndex != nullptr;
+}
+
+bool SkJpegCodec::setRegionIndex(const void* serializedIndex, size_t length) {
+    fRegionIndex = SkJpegRegionIndex::Deserialize(this->getEncodedData(), serializedIndex, length);
+    return fRegionIndex != nullptr;
+}
+
+sk_sp<SkData> SkJpegCodec::serializedRegionIndex() const {
+    return fRegionIndex ? fRegionIndex->serialize() : nullptr;
+}
+
+bool SkJpegCodec::onGetValidSubset(SkIRect* desiredSubset) const {
+    return fRegionIndex && SkIRect::MakeSize(this->dimensions()).contains(*desiredSubset);
+}
+
+SkCodec::Result SkJpegCodec::decodeRegion(const SkImageInfo& dstInfo, void* dst,
+                                          size_t dstRowBytes, const Options& options) {
+    const SkIRect& subset = *options.fSubset;
+    if (dstInfo.dimensions() != subset.size()) {
+        return kInvalidScale;
+    }
+    if (fRegionIndex->width() != this->dimensions().width() ||
+        fRegionIndex->height() != this->dimensions().height()) {
+        return kInternalError;
+    }
+
+    const SkJpegRegionIndex::Region region = fRegionIndex->makeRegion(subset.top(),
+                                                                      subset.bottom());
+    if (!region.fData) {
+        return kInvalidInput;
+    }
+
+    // As with restart bands, the region carries the original header, so only a profile that came
+    // from elsewhere needs passing along.
+    const skcms_ICCProfile* profile = this->getEncodedInfo().profile();
+    Result result;
+    std::unique_ptr<SkCodec> codec = SkJpegCodec::MakeFromStream(
+            SkMemoryStream::Make(region.fData), &result,
+            profile ? SkEncodedInfo::ICCProfile::Make(*profile) : nullptr);
+    if (!codec) {
+        return result;
+    }
+    if (codec->dimensions() != SkISize{this->dimensions().width(), region.fDecodeHeight}) {
+        return kInvalidInput;
+    }
+
+    // Scanline decodes subset horizontally, but libjpeg-turbo upsamples the edges of a horizontal
+    // crop as if they were the edges of the image. Crop an MCU wider on each side, and trim those
+    // columns off afterwards.
+    const int margin = fRegionIndex->mcuWidth();
+    const SkIRect columns = SkIRect::MakeLTRB(std::max(subset.left() - margin, 0), 0,
+                                              std::min(subset.right() + margin,
+                                                       this->dimensions().width()),
+                                              region.fDecodeHeight);
+    Options regionOptions;
+    regionOptions.fZeroInitialized = options.fZeroInitialized;
+    regionOptions.fSubset = &columns;
+    result = codec->startScanlineDecode(dstInfo.makeDimensions(codec->dimensions()),
+                                        &regionOptions);
+    if (result != kSuccess) {
+        return result;
+    }
+    const int contextRows = subset.top() - region.fDecodeTop;
+    if (contextRows > 0 && !codec->skipScanlines(contextRows)) {
+        return kInvalidInput;
+    }
+
+    if (columns.width() == subset.width()) {
+        if (subset.height() != codec->getScanlines(dst, subset.height(), dstRowBytes)) {
+            return kIncompleteInput;
+        }
+        return kSuccess;
+    }
+    const size_t bpp = dstInfo.bytesPerPixel();
+    AutoTMalloc<uint8_t> row(columns.width() * bpp);
+    const uint8_t* src = row.get() + (subset.left() - columns.left()) * bpp;
+    for (int y = 0; y < subset.height(); ++y) {
+        if (1 != codec->getScanlines(row.get(), 1, 0)) {
+            return kIncompleteInput;
+        }
+        memcpy(SkTAddOffset<void>(dst, y * dstRowBytes), src, subset.width() * bpp);
+    }
+    return kSuccess;
+}
+
 bool SkJpegCodec::allocateStorage(const SkImageInfo& dstInfo) {
     int dstWidth = dstInfo.width();
 
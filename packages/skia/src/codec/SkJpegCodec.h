@@ -23,6 +23,8 @@
 #include <memory>
 
 class JpegDecoderMgr;
+class SkData;
+class SkJpegRegionIndex;
 class SkSampler;
 class SkStream;
 class SkSwizzler;
@@ -46,6 +48,21 @@ public:
      */
     static std::unique_ptr<SkCodec> MakeFromStream(std::unique_ptr<SkStream>, Result*);
 
+    /*
+     * Attaches a region index (see SkJpegRegionIndex) so that getPixels() accepts any
+     * Options::fSubset, and decodes it starting from the MCU rows just above the subset rather
+     * than from the top of the image. Subset decodes are unscaled: the dimensions of the
+     * SkImageInfo must match the subset.
+     *
+     * buildRegionIndex() decodes the entropy-coded data once to build the index. setRegionIndex()
+     * instead attaches an index previously returned by serializedRegionIndex() for the same data.
+     *
+     * Both require the encoded data to be in memory, and fail if the image cannot be indexed.
+     */
+    bool buildRegionIndex();
+    bool setRegionIndex(const void* serializedIndex, size_t length);
+    sk_sp<SkData> serializedRegionIndex() const;
+
 protected:
 
     /*
@@ -72,6 +89,8 @@ protected:
 
     bool onDimensionsSupported(const SkISize&) override;
 
+    bool onGetValidSubset(SkIRect* desiredSubset) const override;
+
     bool conversionSupported(const SkImageInfo&, bool, bool) override;
 
     bool onGetGainmapInfo(SkGainmapInfo* info,
@@ -131,6 +150,22 @@ private:
     bool SK_WARN_UNUSED_RESULT allocateStorage(const SkImageInfo& dstInfo);
     int readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count, const Options&);
 
+    /*
+     * Decodes bands delimited by restart markers on options.fExecutor. Returns false, without
+     * having decoded anything useful, if the image cannot be split or any band fails; the caller
+     * should then decode serially.
+     */
+    bool decodeRestartBands(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                            const Options&);
+
+    /*
+     * Decodes options.fSubset using fRegionIndex.
+     */
+    Result decodeRegion(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, const Options&);
+
+    // Returns the encoded data if the stream is in memory, without copying it.
+    sk_sp<SkData> getEncodedData();
+
     /*
      * Scanline decoding.
      */
@@ -158,6 +193,8 @@ private:
 
     std::unique_ptr<SkSwizzler>        fSwizzler;
 
+    std::unique_ptr<SkJpegRegionIndex> fRegionIndex;
+
     friend class SkRawCodec;
 
     using INHERITED = SkCodec;
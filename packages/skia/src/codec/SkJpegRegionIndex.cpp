@@ -0,0 +1,619 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkJpegRegionIndex.h"
+
+#include "include/core/SkStream.h"
+#include "include/core/SkTypes.h"
+#include "include/private/base/SkTo.h"
+#include "src/codec/SkCodecPriv.h"
+#include "src/codec/SkJpegConstants.h"
+#include "src/codec/SkJpegSegmentScan.h"
+#include "src/core/SkChecksum.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kMarkerSOF0 = 0xC0;  // Baseline DCT, Huffman coding.
+constexpr uint8_t kMarkerSOF1 = 0xC1;  // Extended sequential DCT, Huffman coding.
+constexpr uint8_t kMarkerDHT  = 0xC4;
+constexpr uint8_t kMarkerJPG  = 0xC8;
+constexpr uint8_t kMarkerDAC  = 0xCC;
+constexpr uint8_t kMarkerDNL  = 0xDC;
+constexpr uint8_t kMarkerDRI  = 0xDD;
+
+// The largest DC difference category for 8-bit samples.
+constexpr int kMaxDCCategory = 11;
+
+constexpr uint32_t kIndexMagic   = SkSetFourByteTag('S', 'k', 'J', 'R');
+constexpr uint32_t kIndexVersion = 2;
+
+// How much of each end of the data the serialized index hashes to identify it.
+constexpr size_t kFingerprintBytes = 64 * 1024;
+
+bool is_start_of_frame(uint8_t marker) {
+    return marker >= 0xC0 && marker <= 0xCF &&
+           marker != kMarkerDHT && marker != kMarkerJPG && marker != kMarkerDAC;
+}
+
+// Identifies the data an index was built from without reading all of it: the headers and the
+// start of the scan, and the end of the scan. The caller checks the length separately.
+uint32_t fingerprint(const SkData& data) {
+    const size_t size = data.size();
+    const uint32_t head = SkChecksum::Hash32(data.data(), std::min(size, kFingerprintBytes));
+    if (size <= kFingerprintBytes) {
+        return head;
+    }
+    const size_t tail = std::min(size - kFingerprintBytes, kFingerprintBytes);
+    return SkChecksum::Hash32(data.bytes() + size - tail, tail, head);
+}
+
+uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// ITU T.81, F.2.2.1: maps the |s| additional bits of a coefficient to its signed value.
+int32_t extend(uint32_t bits, int s) {
+    return s == 0 ? 0 : (bits < (1u << (s - 1)) ? (int32_t)bits - (1 << s) + 1 : (int32_t)bits);
+}
+
+}  // namespace
+
+// Reads the entropy-coded data MSB first, skipping the zero byte stuffed after each 0xFF. Reading
+// past the end of the scan produces zeros, as libjpeg does.
+class SkJpegRegionIndex::BitReader {
+public:
+    BitReader(const uint8_t* data, size_t end, size_t offset, int bit)
+            : fData(data), fEnd(end), fOffset(offset), fBit(bit) {}
+
+    size_t offset() const { return fOffset; }
+    int bit() const { return fBit; }
+    bool pastEnd() const { return fOffset >= fEnd; }
+
+    // The next 16 bits, without consuming them.
+    uint32_t peek16() const {
+        uint32_t bits = 0;
+        size_t p = fOffset;
+        for (int i = 0; i < 3; ++i) {
+            bits = (bits << 8) | this->byteAt(p);
+            p = this->next(p);
+        }
+        return (bits >> (8 - fBit)) & 0xFFFF;
+    }
+
+    void skip(int count) {
+        fBit += count;
+        while (fBit >= 8) {
+            fOffset = this->next(fOffset);
+            fBit -= 8;
+        }
+    }
+
+    uint32_t read(int count) {
+        SkASSERT(0 <= count && count <= 16);
+        const uint32_t bits = this->peek16() >> (16 - count);
+        this->skip(count);
+        return bits;
+    }
+
+private:
+    uint8_t byteAt(size_t p) const { return p < fEnd ? fData[p] : 0; }
+    size_t next(size_t p) const {
+        if (p >= fEnd) {
+            return p;
+        }
+        return fData[p] == 0xFF ? p + 2 : p + 1;
+    }
+
+    const uint8_t* fData;
+    size_t         fEnd;
+    size_t         fOffset;
+    int            fBit;
+};
+
+// Writes entropy-coded data MSB first, stuffing a zero byte after each 0xFF.
+class SkJpegRegionIndex::BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>* out) : fOut(out) {}
+
+    void write(uint32_t bits, int count) {
+        SkASSERT(0 <= count && count <= 16);
+        fBits = (fBits << count) | (bits & ((1u << count) - 1));
+        fCount += count;
+        while (fCount >= 8) {
+            fCount -= 8;
+            const uint8_t byte = (uint8_t)(fBits >> fCount);
+            fOut->push_back(byte);
+            if (byte == 0xFF) {
+                fOut->push_back(0x00);
+            }
+        }
+        fBits &= (1u << fCount) - 1;
+    }
+
+    // Pads the last byte with ones, as encoders do.
+    void flush() {
+        if (fCount > 0) {
+            this->write(0xFF, 8 - fCount);
+        }
+    }
+
+private:
+    std::vector<uint8_t>* fOut;
+    uint32_t              fBits = 0;
+    int                   fCount = 0;
+};
+
+bool SkJpegRegionIndex::BuildHuffmanTable(const uint8_t counts[16], const uint8_t* values,
+                                          int valueCount, HuffmanTable* table) {
+    // ITU T.81, C.1 and C.2: the size and canonical code of each value, in order.
+    uint8_t  sizes[257];
+    uint16_t codes[256];
+    int p = 0;
+    for (int length = 1; length <= 16; ++length) {
+        for (int i = 0; i < counts[length - 1]; ++i) {
+            if (p >= valueCount) {
+                return false;
+            }
+            sizes[p++] = (uint8_t)length;
+        }
+    }
+    sizes[p] = 0;
+
+    uint32_t nextCode = 0;
+    int size = sizes[0];
+    for (p = 0; sizes[p];) {
+        while (sizes[p] == size) {
+            codes[p++] = (uint16_t)nextCode++;
+        }
+        // The all-ones code of each length is reserved.
+        if (nextCode >= (1u << size)) {
+            return false;
+        }
+        nextCode <<= 1;
+        size++;
+    }
+
+    // F.2.2.3: the decoding tables.
+    p = 0;
+    for (int length = 1; length <= 16; ++length) {
+        if (counts[length - 1]) {
+            table->fValOffset[length] = p - codes[p];
+            p += counts[length - 1];
+            table->fMaxCode[length] = codes[p - 1];
+        } else {
+            table->fValOffset[length] = 0;
+            table->fMaxCode[length] = -1;
+        }
+    }
+    table->fMaxCode[17] = 0xFFFFF;
+
+    memcpy(table->fValues, values, p);
+    memset(table->fLookaheadLength, 0, sizeof(table->fLookaheadLength));
+    memset(table->fCodeLength, 0, sizeof(table->fCodeLength));
+    for (int i = 0; i < p; ++i) {
+        table->fCode[values[i]] = codes[i];
+        table->fCodeLength[values[i]] = sizes[i];
+        if (sizes[i] <= 8) {
+            const int shift = 8 - sizes[i];
+            for (int extra = 0; extra < (1 << shift); ++extra) {
+                table->fLookaheadLength[(codes[i] << shift) | extra] = sizes[i];
+                table->fLookaheadValue [(codes[i] << shift) | extra] = values[i];
+            }
+        }
+    }
+    table->fDefined = true;
+    return true;
+}
+
+int SkJpegRegionIndex::DecodeSymbol(BitReader* reader, const HuffmanTable& table, int* length) {
+    const uint32_t bits = reader->peek16();
+    if (const int lookahead = table.fLookaheadLength[bits >> 8]) {
+        reader->skip(lookahead);
+        if (length) {
+            *length = lookahead;
+        }
+        return table.fLookaheadValue[bits >> 8];
+    }
+    for (int l = 9; l <= 16; ++l) {
+        const int32_t code = (int32_t)(bits >> (16 - l));
+        if (code <= table.fMaxCode[l]) {
+            const int32_t index = code + table.fValOffset[l];
+            if (index < 0 || index > 255) {
+                return -1;
+            }
+            reader->skip(l);
+            if (length) {
+                *length = l;
+            }
+            return table.fValues[index];
+        }
+    }
+    return -1;
+}
+
+bool SkJpegRegionIndex::EncodeDC(BitWriter* writer, const HuffmanTable& table, int32_t value) {
+    const uint32_t magnitude = (uint32_t)std::abs(value);
+    int category = 0;
+    while ((magnitude >> category) != 0) {
+        category++;
+    }
+    // Optimized tables only have codes for the categories the encoder actually used.
+    if (category > kMaxDCCategory || table.fCodeLength[category] == 0) {
+        return false;
+    }
+    writer->write(table.fCode[category], table.fCodeLength[category]);
+    writer->write((uint32_t)(value < 0 ? value - 1 : value), category);
+    return true;
+}
+
+std::unique_ptr<SkJpegRegionIndex> SkJpegRegionIndex::Make(sk_sp<SkData> data) {
+    if (!data) {
+        return nullptr;
+    }
+    std::unique_ptr<SkJpegRegionIndex> index(new SkJpegRegionIndex);
+    index->fData = std::move(data);
+    if (!index->parseHeaders() || !index->buildCheckpoints()) {
+        return nullptr;
+    }
+    return index;
+}
+
+bool SkJpegRegionIndex::parseHeaders() {
+    // Checkpoints and the serialized form store 32-bit offsets.
+    if (fData->size() > UINT32_MAX) {
+        return false;
+    }
+
+    SkJpegSegmentScanner scanner(kJpegMarkerEndOfImage);
+    scanner.onBytes(fData->data(), fData->size());
+    if (!scanner.isDone() || scanner.hadError()) {
+        return false;
+    }
+
+    const uint8_t* bytes = fData->bytes();
+    auto params = [bytes](const SkJpegSegment& segment) {
+        return bytes + segment.offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize;
+    };
+    auto paramsLength = [](const SkJpegSegment& segment) -> size_t {
+        return segment.parameterLength - kJpegSegmentParameterLengthSize;
+    };
+
+    const SkJpegSegment* frame = nullptr;
+    const SkJpegSegment* scan = nullptr;
+    for (const SkJpegSegment& segment : scanner.getSegments()) {
+        const uint8_t marker = segment.marker;
+        if (marker == kJpegMarkerEndOfImage) {
+            fEndOfScanOffset = segment.offset;
+            break;
+        }
+        if (scan) {
+            // Restart markers, more scans or a DNL: none of them can be indexed.
+            return false;
+        }
+        if (is_start_of_frame(marker)) {
+            if (frame || (marker != kMarkerSOF0 && marker != kMarkerSOF1)) {
+                return false;
+            }
+            frame = &segment;
+        } else if (marker == kMarkerDRI) {
+            if (paramsLength(segment) < 2 || read_u16(params(segment)) != 0) {
+                return false;
+            }
+        } else if (marker == kMarkerDHT) {
+            // Each table: class and id (1), the number of codes of each length (16), the values.
+            const uint8_t* p = params(segment);
+            const uint8_t* end = p + paramsLength(segment);
+            while (p < end) {
+                if (end - p < 17) {
+                    return false;
+                }
+                const int tableClass = p[0] >> 4;
+                const int tableId = p[0] & 0xF;
+                int valueCount = 0;
+                for (int i = 0; i < 16; ++i) {
+                    valueCount += p[1 + i];
+                }
+                if (tableClass > 1 || tableId > 3 || valueCount > 256 ||
+                    end - p < 17 + valueCount) {
+                    return false;
+                }
+                HuffmanTable* table = tableClass == 0 ? &fDCTables[tableId] : &fACTables[tableId];
+                if (!BuildHuffmanTable(p + 1, p + 17, valueCount, table)) {
+                    return false;
+                }
+                p += 17 + valueCount;
+            }
+        } else if (marker == kJpegMarkerStartOfScan) {
+            scan = &segment;
+        } else if (marker == kMarkerDNL) {
+            return false;
+        }
+    }
+    if (!frame || !scan || !fEndOfScanOffset) {
+        return false;
+    }
+
+    // StartOfFrame: precision (1), height (2), width (2), component count (1), then for each
+    // component an id (1), sampling factors (1) and quantization table (1).
+    const uint8_t* sof = params(*frame);
+    if (paramsLength(*frame) < 6) {
+        return false;
+    }
+    const int precision = sof[0];
+    fHeight = read_u16(sof + 1);
+    fWidth = read_u16(sof + 3);
+    const int components = sof[5];
+    if (precision != 8 || fHeight == 0 || fWidth == 0 || components == 0 ||
+        components > kMaxComponents || paramsLength(*frame) < 6 + 3 * (size_t)components) {
+        return false;
+    }
+    int maxH = 1, maxV = 1;
+    for (int i = 0; i < components; ++i) {
+        const uint8_t sampling = sof[6 + 3 * i + 1];
+        maxH = std::max(maxH, sampling >> 4);
+        maxV = std::max(maxV, sampling & 0xF);
+    }
+
+    // StartOfScan: component count (1), then for each component an id (1) and the DC and AC
+    // table ids (1).
+    const uint8_t* sos = params(*scan);
+    if (paramsLength(*scan) < 1 + 2 * (size_t)components || sos[0] != components) {
+        return false;
+    }
+    for (int i = 0; i < components; ++i) {
+        const uint8_t id = sos[1 + 2 * i];
+        int frameIndex = 0;
+        while (frameIndex < components && sof[6 + 3 * frameIndex] != id) {
+            frameIndex++;
+        }
+        if (frameIndex == components) {
+            return false;
+        }
+        const uint8_t sampling = sof[6 + 3 * frameIndex + 1];
+        Component& component = fComponents[i];
+        // A non-interleaved scan codes one block per MCU.
+        component.fBlocksPerMcu = components == 1 ? 1 : (sampling >> 4) * (sampling & 0xF);
+        component.fDCTable = sos[2 + 2 * i] >> 4;
+        component.fACTable = sos[2 + 2 * i] & 0xF;
+        if (component.fBlocksPerMcu == 0 || component.fDCTable > 3 || component.fACTable > 3 ||
+            !fDCTables[component.fDCTable].fDefined || !fACTables[component.fACTable].fDefined) {
+            return false;
+        }
+    }
+    fComponentCount = components;
+
+    fMcuWidth   = components == 1 ? 8 : 8 * maxH;
+    fMcuHeight  = components == 1 ? 8 : 8 * maxV;
+    fMcusPerRow = (fWidth  + fMcuWidth  - 1) / fMcuWidth;
+    fMcuRows    = (fHeight + fMcuHeight - 1) / fMcuHeight;
+    fFrameHeightOffset = frame->offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize + 1;
+    fScanDataOffset = scan->offset + kJpegMarkerCodeSize + scan->parameterLength;
+    return fScanDataOffset <= fEndOfScanOffset;
+}
+
+bool SkJpegRegionIndex::skipMcu(BitReader* reader, int32_t predictors[]) const {
+    for (int c = 0; c < fComponentCount; ++c) {
+        const Component& component = fComponents[c];
+        const HuffmanTable& dc = fDCTables[component.fDCTable];
+        const HuffmanTable& ac = fACTables[component.fACTable];
+        for (int block = 0; block < component.fBlocksPerMcu; ++block) {
+            const int s = DecodeSymbol(reader, dc, nullptr);
+            if (s < 0 || s > kMaxDCCategory) {
+                return false;
+            }
+            predictors[c] += extend(reader->read(s), s);
+
+            // F.2.2.2, skipping over the AC coefficients.
+            for (int k = 1; k < 64; ++k) {
+                const int rs = DecodeSymbol(reader, ac, nullptr);
+                if (rs < 0) {
+                    return false;
+                }
+                const int r = rs >> 4;
+                const int size = rs & 0xF;
+                if (size) {
+                    k += r;
+                    reader->skip(size);
+                } else if (r == 15) {
+                    k += 15;
+                } else {
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool SkJpegRegionIndex::buildCheckpoints() {
+    BitReader reader(fData->bytes(), fEndOfScanOffset, fScanDataOffset, 0);
+    int32_t predictors[kMaxComponents] = {};
+    fCheckpoints.reserve(fMcuRows);
+    for (int row = 0; row < fMcuRows; ++row) {
+        Checkpoint checkpoint;
+        checkpoint.fOffset = SkToU32(reader.offset());
+        checkpoint.fBit = (uint8_t)reader.bit();
+        std::copy_n(predictors, kMaxComponents, checkpoint.fPredictors);
+        fCheckpoints.push_back(checkpoint);
+
+        for (int mcu = 0; mcu < fMcusPerRow; ++mcu) {
+            if (!this->skipMcu(&reader, predictors)) {
+                SkCodecPrintf("Invalid Huffman code in MCU row %d\n", row);
+                return false;
+            }
+        }
+        // A truncated scan decodes as zeros, which would put later checkpoints past the data.
+        if (reader.pastEnd() && row + 1 < fMcuRows) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SkJpegRegionIndex::Region SkJpegRegionIndex::makeRegion(int top, int bottom) const {
+    if (top < 0 || bottom > fHeight || top >= bottom) {
+        return {};
+    }
+    // One MCU row of context on each side; see the class comment.
+    int firstRow = std::max(top / fMcuHeight - 1, 0);
+    const int endRow = std::min((bottom + fMcuHeight - 1) / fMcuHeight + 1, fMcuRows);
+    const int endY = std::min(endRow * fMcuHeight, fHeight);
+
+    // The first DC coefficient may land in a category that an optimized table has no code for.
+    // Starting a row earlier gives a different coefficient, and row 0 always works.
+    for (; firstRow >= 0; --firstRow) {
+        const int decodeTop = firstRow * fMcuHeight;
+        if (sk_sp<SkData> data = this->makeRegionData(firstRow, endRow, endY - decodeTop)) {
+            return {std::move(data), decodeTop, endY - decodeTop};
+        }
+    }
+    return {};
+}
+
+sk_sp<SkData> SkJpegRegionIndex::makeRegionData(int firstRow, int endRow, int height) const {
+    SkASSERT(0 <= firstRow && firstRow < endRow && endRow <= fMcuRows);
+    if (height <= 0 || height > 0xFFFF) {
+        return nullptr;
+    }
+
+    const uint8_t* src = fData->bytes();
+    const Checkpoint& start = fCheckpoints[firstRow];
+    const size_t endOffset = endRow == fMcuRows ? fEndOfScanOffset : fCheckpoints[endRow].fOffset;
+    const int endBit = endRow == fMcuRows ? 0 : fCheckpoints[endRow].fBit;
+
+    // The header, with the frame height patched to the region's height.
+    std::vector<uint8_t> out(src, src + fScanDataOffset);
+    out.reserve(fScanDataOffset + (endOffset - start.fOffset) + 64);
+    out[fFrameHeightOffset + 0] = (uint8_t)(height >> 8);
+    out[fFrameHeightOffset + 1] = (uint8_t)(height & 0xFF);
+
+    BitReader reader(src, fEndOfScanOffset, start.fOffset, start.fBit);
+    BitWriter writer(&out);
+    auto copy = [&reader, &writer](int count) { writer.write(reader.read(count), count); };
+
+    // The first MCU. The new scan starts with zero DC predictors, so the first block of each
+    // component codes its DC coefficient in full. The blocks after it are still relative to the
+    // block before, so they keep their original differences.
+    int32_t predictors[kMaxComponents];
+    std::copy_n(start.fPredictors, kMaxComponents, predictors);
+    for (int c = 0; c < fComponentCount; ++c) {
+        const Component& component = fComponents[c];
+        const HuffmanTable& dc = fDCTables[component.fDCTable];
+        const HuffmanTable& ac = fACTables[component.fACTable];
+        for (int block = 0; block < component.fBlocksPerMcu; ++block) {
+            const int s = DecodeSymbol(&reader, dc, nullptr);
+            if (s < 0 || s > kMaxDCCategory) {
+                return nullptr;
+            }
+            const int32_t diff = extend(reader.read(s), s);
+            predictors[c] += diff;
+            if (!EncodeDC(&writer, dc, block == 0 ? predictors[c] : diff)) {
+                return nullptr;
+            }
+
+            for (int k = 1; k < 64; ++k) {
+                const uint32_t bits = reader.peek16();
+                int length;
+                const int rs = DecodeSymbol(&reader, ac, &length);
+                if (rs < 0) {
+                    return nullptr;
+                }
+                writer.write(bits >> (16 - length), length);
+                const int r = rs >> 4;
+                const int size = rs & 0xF;
+                if (size) {
+                    k += r;
+                    copy(size);
+                } else if (r == 15) {
+                    k += 15;
+                } else {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Everything else is copied as is, a byte at a time once the reader is byte aligned.
+    if (reader.offset() > endOffset) {
+        return nullptr;
+    }
+    while (reader.offset() < endOffset || reader.bit() < endBit) {
+        copy(reader.bit() == 0 && reader.offset() < endOffset ? 8 : 1);
+    }
+    writer.flush();
+    out.push_back(0xFF);
+    out.push_back(kJpegMarkerEndOfImage);
+    return SkData::MakeWithCopy(out.data(), out.size());
+}
+
+sk_sp<SkData> SkJpegRegionIndex::serialize() const {
+    SkDynamicMemoryWStream stream;
+    stream.write32(kIndexMagic);
+    stream.write32(kIndexVersion);
+    stream.write32(SkToU32(fData->size()));
+    stream.write32(fingerprint(*fData));
+    stream.write32(SkToU32(fComponentCount));
+    stream.write32(SkToU32(fCheckpoints.size()));
+    for (const Checkpoint& checkpoint : fCheckpoints) {
+        stream.write32(checkpoint.fOffset);
+        stream.write8(checkpoint.fBit);
+        for (int c = 0; c < fComponentCount; ++c) {
+            stream.write32((uint32_t)checkpoint.fPredictors[c]);
+        }
+    }
+    return stream.detachAsData();
+}
+
+std::unique_ptr<SkJpegRegionIndex> SkJpegRegionIndex::Deserialize(sk_sp<SkData> data,
+                                                                  const void* indexData,
+                                                                  size_t length) {
+    if (!data || !indexData) {
+        return nullptr;
+    }
+    std::unique_ptr<SkJpegRegionIndex> index(new SkJpegRegionIndex);
+    index->fData = std::move(data);
+    if (!index->parseHeaders()) {
+        return nullptr;
+    }
+
+    SkMemoryStream stream(indexData, length, /*copyData=*/false);
+    uint32_t magic, version, dataSize, hash, components, rows;
+    if (!stream.readU32(&magic) || magic != kIndexMagic ||
+        !stream.readU32(&version) || version != kIndexVersion ||
+        !stream.readU32(&dataSize) || dataSize != index->fData->size() ||
+        !stream.readU32(&hash) ||
+        hash != fingerprint(*index->fData) ||
+        !stream.readU32(&components) || components != (uint32_t)index->fComponentCount ||
+        !stream.readU32(&rows) || rows != (uint32_t)index->fMcuRows) {
+        return nullptr;
+    }
+
+    index->fCheckpoints.resize(rows);
+    uint32_t previous = 0;
+    for (Checkpoint& checkpoint : index->fCheckpoints) {
+        uint32_t offset;
+        uint8_t bit;
+        if (!stream.readU32(&offset) || !stream.readU8(&bit) || bit > 7 ||
+            offset < index->fScanDataOffset || offset > index->fEndOfScanOffset ||
+            offset < previous) {
+            return nullptr;
+        }
+        checkpoint.fOffset = previous = offset;
+        checkpoint.fBit = bit;
+        for (uint32_t c = 0; c < components; ++c) {
+            if (!stream.readS32(&checkpoint.fPredictors[c])) {
+                return nullptr;
+            }
+        }
+    }
+    return index;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkJpegRegionIndex_codec_DEFINED
+#define SkJpegRegionIndex_codec_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * A seek index over the entropy-coded data of a single-scan, Huffman coded JPEG without restart
+ * markers.
+ *
+ * Without restart markers, the only way to find where an MCU row starts is to Huffman decode
+ * everything above it. The index does that once and records, for every MCU row, the bit position
+ * at which the row begins and the DC predictor of each component at that point. With it, any run
+ * of MCU rows can be cut out of the scan and wrapped in a copy of the image header to make a
+ * standalone JPEG: the first block of each component has its DC coefficient re-encoded relative
+ * to zero, and the rest of the entropy-coded data is copied bit for bit.
+ *
+ * Like SkJpegRestartBands, regions are cut with one MCU row of context above and below so that
+ * upsampling produces the same pixels as a full decode; the caller discards the context rows.
+ *
+ * The index can be serialized and stored next to the image. It records the length of the data it
+ * was built from and a hash of its first and last 64KB, so Deserialize() rejects an index built
+ * from other data without reading all of it; it cannot tell data that differs only in between.
+ */
+class SkJpegRegionIndex {
+public:
+    struct Region {
+        // A standalone JPEG covering the rows [fDecodeTop, fDecodeTop + fDecodeHeight) of the
+        // original image.
+        sk_sp<SkData> fData;
+        int           fDecodeTop = 0;
+        int           fDecodeHeight = 0;
+    };
+
+    /*
+     * Decodes the entropy-coded data once to build the index. Returns nullptr if |data| is not a
+     * JPEG that can be indexed: it must have exactly one frame with exactly one scan, use Huffman
+     * coding with 8-bit samples, and have no restart interval (images with restart markers are
+     * split with SkJpegRestartBands instead).
+     */
+    static std::unique_ptr<SkJpegRegionIndex> Make(sk_sp<SkData> data);
+
+    /*
+     * Recreates an index from the output of serialize(). Returns nullptr if |index| is malformed
+     * or was not built from |data|.
+     */
+    static std::unique_ptr<SkJpegRegionIndex> Deserialize(sk_sp<SkData> data,
+                                                          const void* index, size_t length);
+
+    sk_sp<SkData> serialize() const;
+
+    int width() const { return fWidth; }
+    int height() const { return fHeight; }
+    int mcuWidth() const { return fMcuWidth; }
+    int mcuHeight() const { return fMcuHeight; }
+    int mcuRows() const { return fMcuRows; }
+
+    /*
+     * Returns a standalone JPEG containing at least the image rows [top, bottom), plus the
+     * context needed to decode them exactly. Returns an empty Region on failure.
+     */
+    Region makeRegion(int top, int bottom) const;
+
+private:
+    static constexpr int kMaxComponents = 4;
+
+    struct HuffmanTable {
+        bool     fDefined = false;
+        // Decoding (ITU T.81, F.2.2.3), with an 8-bit lookahead for short codes.
+        int32_t  fMaxCode[18];
+        int32_t  fValOffset[17];
+        uint8_t  fValues[256];
+        uint8_t  fLookaheadLength[256];  // 0 if the code is longer than 8 bits
+        uint8_t  fLookaheadValue[256];
+        // Encoding (ITU T.81, C.2), indexed by symbol.
+        uint16_t fCode[256];
+        uint8_t  fCodeLength[256];        // 0 if the symbol has no code
+    };
+
+    struct Component {
+        int fBlocksPerMcu = 1;
+        int fDCTable = 0;
+        int fACTable = 0;
+    };
+
+    // Where an MCU row begins: the offset of the byte holding its first bit, how many bits of that
+    // byte belong to the previous row, and the DC predictors going into it.
+    struct Checkpoint {
+        uint32_t fOffset = 0;
+        uint8_t  fBit = 0;
+        int32_t  fPredictors[kMaxComponents] = {};
+    };
+
+    class BitReader;
+    class BitWriter;
+
+    SkJpegRegionIndex() = default;
+
+    static bool BuildHuffmanTable(const uint8_t counts[16], const uint8_t* values, int valueCount,
+                                  HuffmanTable*);
+    // Returns -1 for a code the table does not define. If |length| is not null, it receives the
+    // length of the code.
+    static int DecodeSymbol(BitReader*, const HuffmanTable&, int* length);
+    static bool EncodeDC(BitWriter*, const HuffmanTable&, int32_t value);
+
+    // Parses the headers of fData. Everything but the checkpoints is set up after this succeeds.
+    bool parseHeaders();
+    bool buildCheckpoints();
+    bool skipMcu(BitReader*, int32_t predictors[]) const;
+
+    sk_sp<SkData> makeRegionData(int firstRow, int endRow, int height) const;
+
+    sk_sp<SkData>           fData;
+    int                     fWidth = 0;
+    int                     fHeight = 0;
+    int                     fMcuWidth = 0;
+    int                     fMcuHeight = 0;
+    int                     fMcusPerRow = 0;
+    int                     fMcuRows = 0;
+    int                     fComponentCount = 0;
+    Component               fComponents[kMaxComponents];  // in scan order
+    HuffmanTable            fDCTables[4];
+    HuffmanTable            fACTables[4];
+
+    size_t                  fFrameHeightOffset = 0;
+    size_t                  fScanDataOffset = 0;
+    size_t                  fEndOfScanOffset = 0;
+
+    std::vector<Checkpoint> fCheckpoints;
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkJpegRestartBands.h"
+
+#include "include/private/base/SkTo.h"
+#include "src/codec/SkCodecPriv.h"
+#include "src/codec/SkJpegConstants.h"
+#include "src/codec/SkJpegSegmentScan.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kMarkerSOF0 = 0xC0;  // Baseline DCT, Huffman coding.
+constexpr uint8_t kMarkerSOF1 = 0xC1;  // Extended sequential DCT, Huffman coding.
+constexpr uint8_t kMarkerDHT  = 0xC4;
+constexpr uint8_t kMarkerJPG  = 0xC8;
+constexpr uint8_t kMarkerDAC  = 0xCC;
+constexpr uint8_t kMarkerRST0 = 0xD0;
+constexpr uint8_t kMarkerRST7 = 0xD7;
+constexpr uint8_t kMarkerDNL  = 0xDC;
+constexpr uint8_t kMarkerDRI  = 0xDD;
+
+bool is_start_of_frame(uint8_t marker) {
+    return marker >= 0xC0 && marker <= 0xCF &&
+           marker != kMarkerDHT && marker != kMarkerJPG && marker != kMarkerDAC;
+}
+
+bool is_restart(uint8_t marker) {
+    return marker >= kMarkerRST0 && marker <= kMarkerRST7;
+}
+
+uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+}  // namespace
+
+std::unique_ptr<SkJpegRestartBands> SkJpegRestartBands::Make(sk_sp<SkData> data) {
+    if (!data) {
+        return nullptr;
+    }
+
+    SkJpegSegmentScanner scanner(kJpegMarkerEndOfImage);
+    scanner.onBytes(data->data(), data->size());
+    if (!scanner.isDone() || scanner.hadError()) {
+        return nullptr;
+    }
+
+    const uint8_t* bytes = data->bytes();
+    auto params = [bytes](const SkJpegSegment& segment) {
+        return bytes + segment.offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize;
+    };
+    auto paramsLength = [](const SkJpegSegment& segment) -> size_t {
+        return segment.parameterLength - kJpegSegmentParameterLengthSize;
+    };
+
+    std::unique_ptr<SkJpegRestartBands> bands(new SkJpegRestartBands);
+    const SkJpegSegment* frame = nullptr;
+    const SkJpegSegment* scan = nullptr;
+    int restartInterval = 0;
+    for (const SkJpegSegment& segment : scanner.getSegments()) {
+        const uint8_t marker = segment.marker;
+        if (marker == kJpegMarkerEndOfImage) {
+            bands->fEndOfScanOffset = segment.offset;
+            break;
+        }
+        if (scan) {
+            // Anything but restart markers after the scan means more scans (or a DNL), neither of
+            // which we can split.
+            if (!is_restart(marker)) {
+                return nullptr;
+            }
+            bands->fRestartOffsets.push_back(segment.offset);
+            continue;
+        }
+        if (is_start_of_frame(marker)) {
+            if (frame || (marker != kMarkerSOF0 && marker != kMarkerSOF1)) {
+                return nullptr;
+            }
+            frame = &segment;
+        } else if (marker == kMarkerDRI) {
+            if (paramsLength(segment) < 2) {
+                return nullptr;
+            }
+            restartInterval = read_u16(params(segment));
+        } else if (marker == kJpegMarkerStartOfScan) {
+            scan = &segment;
+        } else if (marker == kMarkerDNL) {
+            return nullptr;
+        }
+    }
+    if (!frame || !scan || !bands->fEndOfScanOffset || restartInterval == 0) {
+        return nullptr;
+    }
+
+    // StartOfFrame: precision (1), height (2), width (2), component count (1), then for each
+    // component an id (1), sampling factors (1) and quantization table (1).
+    const uint8_t* sof = params(*frame);
+    if (paramsLength(*frame) < 6) {
+        return nullptr;
+    }
+    const int precision = sof[0];
+    const int height = read_u16(sof + 1);
+    const int width = read_u16(sof + 3);
+    const int components = sof[5];
+    if (precision != 8 || height == 0 || width == 0 || components == 0 ||
+        paramsLength(*frame) < 6 + 3 * (size_t)components) {
+        return nullptr;
+    }
+    int maxH = 1, maxV = 1;
+    for (int i = 0; i < components; ++i) {
+        const uint8_t sampling = sof[6 + 3 * i + 1];
+        maxH = std::max(maxH, sampling >> 4);
+        maxV = std::max(maxV, sampling & 0xF);
+    }
+
+    // A single scan has to carry every component, or the image would need more scans.
+    if (paramsLength(*scan) < 1 || params(*scan)[0] != components) {
+        return nullptr;
+    }
+
+    // A non-interleaved scan (only possible here for single component images) codes one 8x8 block
+    // per MCU. Otherwise an MCU covers the maximum sampling factors.
+    const int mcuWidth  = components == 1 ? 8 : 8 * maxH;
+    const int mcuHeight = components == 1 ? 8 : 8 * maxV;
+    const int mcusPerRow = (width  + mcuWidth  - 1) / mcuWidth;
+    const int mcuRows    = (height + mcuHeight - 1) / mcuHeight;
+    const int64_t totalMcus = (int64_t)mcusPerRow * mcuRows;
+    const int64_t intervals = (totalMcus + restartInterval - 1) / restartInterval;
+    if ((int64_t)bands->fRestartOffsets.size() != intervals - 1) {
+        SkCodecPrintf("Expected %lld restart markers, found %zu\n",
+                      (long long)(intervals - 1), bands->fRestartOffsets.size());
+        return nullptr;
+    }
+
+    for (int64_t i = 0; i < intervals; ++i) {
+        const int64_t firstMcu = i * restartInterval;
+        if (firstMcu % mcusPerRow == 0) {
+            bands->fBoundaryRows.push_back(SkToInt(firstMcu / mcusPerRow));
+            bands->fBoundaryIntervals.push_back(SkToInt(i));
+        }
+    }
+    if (bands->fBoundaryRows.size() < 2) {
+        return nullptr;
+    }
+
+    bands->fData = std::move(data);
+    bands->fWidth = width;
+    bands->fHeight = height;
+    bands->fMcuHeight = mcuHeight;
+    bands->fIntervalCount = SkToInt(intervals);
+    bands->fFrameHeightOffset =
+            frame->offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize + 1;
+    bands->fScanDataOffset = scan->offset + kJpegMarkerCodeSize + scan->parameterLength;
+    return bands;
+}
+
+std::vector<SkJpegRestartBands::Band> SkJpegRestartBands::split(int maxBands) const {
+    const int boundaries = this->boundaryCount();
+    const int bandCount = std::min(maxBands, boundaries);
+    if (bandCount < 1) {
+        return {};
+    }
+
+    // Pick the boundary each band starts at, spreading MCU rows evenly.
+    const int mcuRows = (fHeight + fMcuHeight - 1) / fMcuHeight;
+    std::vector<int> starts = {0};
+    for (int b = 1, i = 1; b < bandCount; ++b) {
+        const int targetRow = (int)((int64_t)b * mcuRows / bandCount);
+        while (i < boundaries && fBoundaryRows[i] < targetRow) {
+            ++i;
+        }
+        if (i >= boundaries) {
+            break;
+        }
+        starts.push_back(i++);
+    }
+    starts.push_back(boundaries);
+
+    auto rowOf = [this, boundaries](int boundary) {
+        return boundary < boundaries ? std::min(fBoundaryRows[boundary] * fMcuHeight, fHeight)
+                                     : fHeight;
+    };
+    auto intervalOf = [this, boundaries](int boundary) {
+        return boundary < boundaries ? fBoundaryIntervals[boundary] : fIntervalCount;
+    };
+
+    std::vector<Band> bands;
+    for (size_t i = 0; i + 1 < starts.size(); ++i) {
+        const int first = starts[i];
+        const int end   = starts[i + 1];
+        // One boundary of context on each side; see the class comment.
+        const int decodeFirst = std::max(first - 1, 0);
+        const int decodeEnd   = std::min(end + 1, boundaries);
+
+        Band band;
+        band.fOutputTop    = rowOf(first);
+        band.fOutputHeight = rowOf(end) - band.fOutputTop;
+        band.fDecodeTop    = rowOf(decodeFirst);
+        band.fDecodeHeight = rowOf(decodeEnd) - band.fDecodeTop;
+        band.fData = this->makeBandData(intervalOf(decodeFirst), intervalOf(decodeEnd),
+                                        band.fDecodeHeight);
+        if (!band.fData || band.fOutputHeight <= 0) {
+            return {};
+        }
+        bands.push_back(std::move(band));
+    }
+    return bands;
+}
+
+sk_sp<SkData> SkJpegRestartBands::makeBandData(int firstInterval, int endInterval,
+                                               int height) const {
+    SkASSERT(0 <= firstInterval && firstInterval < endInterval && endInterval <= fIntervalCount);
+    if (height <= 0 || height > 0xFFFF) {
+        return nullptr;
+    }
+
+    const uint8_t* src = fData->bytes();
+    const size_t dataStart = firstInterval == 0 ? fScanDataOffset
+                                                : fRestartOffsets[firstInterval - 1] +
+                                                  kJpegMarkerCodeSize;
+    const size_t dataEnd = endInterval == fIntervalCount ? fEndOfScanOffset
+                                                         : fRestartOffsets[endInterval - 1];
+    if (dataEnd < dataStart) {
+        return nullptr;
+    }
+    const size_t headerSize = fScanDataOffset;
+    const size_t dataSize = dataEnd - dataStart;
+
+    sk_sp<SkData> band = SkData::MakeUninitialized(headerSize + dataSize + kJpegMarkerCodeSize);
+    uint8_t* dst = static_cast<uint8_t*>(band->writable_data());
+
+    // The header, with the frame height patched to the band's height.
+    memcpy(dst, src, headerSize);
+    dst[fFrameHeightOffset + 0] = (uint8_t)(height >> 8);
+    dst[fFrameHeightOffset + 1] = (uint8_t)(height & 0xFF);
+
+    // The entropy-coded data. Decoders expect restart markers to count up from RST0, so renumber
+    // the ones inside the band.
+    memcpy(dst + headerSize, src + dataStart, dataSize);
+    for (int i = firstInterval; i < endInterval - 1; ++i) {
+        const size_t offset = headerSize + (fRestartOffsets[i] - dataStart);
+        dst[offset + 1] = (uint8_t)(kMarkerRST0 + ((i - firstInterval) & 7));
+    }
+
+    dst[headerSize + dataSize + 0] = 0xFF;
+    dst[headerSize + dataSize + 1] = kJpegMarkerEndOfImage;
+    return band;
+}
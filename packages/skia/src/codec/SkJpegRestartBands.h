@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkJpegRestartBands_codec_DEFINED
+#define SkJpegRestartBands_codec_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+ * Splits a single-scan, Huffman coded (baseline or extended sequential) JPEG into horizontal
+ * bands that can be entropy decoded independently.
+ *
+ * Restart markers reset the DC predictors and the bit reader, so the entropy-coded data that
+ * follows a restart marker can be decoded without anything that came before it. When the restart
+ * interval lines up with MCU rows, a run of restart intervals is exactly a run of MCU rows, and can
+ * be wrapped in a copy of the image header (with the frame height patched) to make a standalone
+ * JPEG that any decoder accepts.
+ *
+ * Chroma upsampling and the IDCT may look one MCU row above and below the rows being produced, so
+ * each band is decoded with one extra restart boundary of context on each side, and the caller
+ * discards those rows. This keeps the output identical to a serial decode.
+ */
+class SkJpegRestartBands {
+public:
+    struct Band {
+        // A standalone JPEG covering the rows [fDecodeTop, fDecodeTop + fDecodeHeight) of the
+        // original image.
+        sk_sp<SkData> fData;
+        int           fDecodeTop = 0;
+        int           fDecodeHeight = 0;
+
+        // The rows of the original image this band is responsible for producing. These are a
+        // subset of the decoded rows.
+        int           fOutputTop = 0;
+        int           fOutputHeight = 0;
+    };
+
+    /*
+     * Returns nullptr if |data| is not a JPEG that can be split: it must have exactly one frame
+     * with exactly one scan, use Huffman coding, and have a restart interval that lands on MCU row
+     * boundaries at least twice.
+     */
+    static std::unique_ptr<SkJpegRestartBands> Make(sk_sp<SkData> data);
+
+    int width() const { return fWidth; }
+    int height() const { return fHeight; }
+
+    // Number of MCU rows at which a band may begin.
+    int boundaryCount() const { return (int)fBoundaryRows.size(); }
+
+    /*
+     * Splits the image into at most |maxBands| bands of roughly equal height. Returns an empty
+     * vector if the bands could not be constructed.
+     */
+    std::vector<Band> split(int maxBands) const;
+
+private:
+    SkJpegRestartBands() = default;
+
+    sk_sp<SkData> makeBandData(int firstInterval, int endInterval, int height) const;
+
+    sk_sp<SkData>       fData;
+    int                 fWidth = 0;
+    int                 fHeight = 0;
+    int                 fMcuHeight = 0;
+    int                 fIntervalCount = 0;
+
+    // Offset of the frame height in the StartOfFrame parameters.
+    size_t              fFrameHeightOffset = 0;
+    // Offset of the first byte of entropy-coded data, right after the StartOfScan segment.
+    size_t              fScanDataOffset = 0;
+    // Offset of the EndOfImage marker.
+    size_t              fEndOfScanOffset = 0;
+
+    // The offset of each restart marker in the scan, in order. Restart marker i sits between
+    // restart intervals i and i + 1.
+    std::vector<size_t> fRestartOffsets;
+
+    // MCU rows at which a restart interval begins, paired with the index of that interval.
+    std::vector<int>    fBoundaryRows;
+    std::vector<int>    fBoundaryIntervals;
+};
+
+#endif
@@ -474,6 +474,9 @@ static skcms_PixelFormat png_select_xform_format(const SkEncodedInfo& info) {
         } else if (SkEncodedInfo::kRGB_Color == info.color()) {
             return skcms_PixelFormat_RGB_161616BE;
         }
+    } else if (SkEncodedInfo::kRGB_Color == info.color()) {
+        // skcms reads packed RGB directly, so 8-bit RGB rows need not be expanded to RGBA first.
+        return skcms_PixelFormat_RGB_888;
     } else if (SkEncodedInfo::kGray_Color == info.color()) {
         return skcms_PixelFormat_G_8;
     }
@@ -1042,14 +1045,11 @@ SkCodec::Result SkPngCodec::initializeXforms(const SkImageInfo& dstInfo, const O
     fSwizzler.reset(nullptr);
 
     // If skcms directly supports the encoded PNG format, we should skip format
-    // conversion in the swizzler (or skip swizzling altogether).
+    // conversion in the swizzler (or skip swizzling altogether). skcms then swizzles,
+    // premultiplies and converts each row in a single pass, straight into the destination.
     bool skipFormatConversion = false;
     switch (this->getEncodedInfo().color()) {
         case SkEncodedInfo::kRGB_Color:
-            if (this->getEncodedInfo().bitsPerComponent() != 16) {
-                break;
-            }
-            [[fallthrough]];
         case SkEncodedInfo::kRGBA_Color:
         case SkEncodedInfo::kGray_Color:
             skipFormatConversion = this->colorXform();
@@ -1114,8 +1114,7 @@ void SkPngCodec::initializeSwizzler(const SkImageInfo& dstInfo, const Options& o
         int srcBPP = 0;
         switch (this->getEncodedInfo().color()) {
             case SkEncodedInfo::kRGB_Color:
-                SkASSERT(this->getEncodedInfo().bitsPerComponent() == 16);
-                srcBPP = 6;
+                srcBPP = this->getEncodedInfo().bitsPerComponent() == 16 ? 6 : 3;
                 break;
             case SkEncodedInfo::kRGBA_Color:
                 srcBPP = this->getEncodedInfo().bitsPerComponent() / 2;
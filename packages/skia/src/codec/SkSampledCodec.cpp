@@ -14,6 +14,7 @@
 #include "include/core/SkTypes.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/base/SkMathPriv.h"
+#include "src/codec/SkAreaResampler.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkSampler.h"
 
@@ -78,6 +79,13 @@ SkISize SkSampledCodec::onGetSampledDimensions(int sampleSize) const {
 SkCodec::Result SkSampledCodec::onGetAndroidPixels(const SkImageInfo& info, void* pixels,
         size_t rowBytes, const AndroidOptions& options) {
     const SkIRect* subset = options.fSubset;
+    if (options.fAreaAverage) {
+        const SkISize srcSize = subset ? subset->size() : this->codec()->dimensions();
+        if (info.dimensions() != srcSize) {
+            return this->areaAverageDecode(info, pixels, rowBytes, options);
+        }
+    }
+
     if (!subset || subset->size() == this->codec()->dimensions()) {
         if (this->codec()->dimensionsSupported(info.dimensions())) {
             return this->codec()->getPixels(info, pixels, rowBytes, &options);
@@ -351,3 +359,97 @@ SkCodec::Result SkSampledCodec::sampledDecode(const SkImageInfo& info, void* pix
             return SkCodec::kUnimplemented;
     }
 }
+
+SkCodec::Result SkSampledCodec::areaAverageDecode(const SkImageInfo& info, void* pixels,
+        size_t rowBytes, const AndroidOptions& options) {
+    if (options.fFrameIndex != 0) {
+        return SkCodec::kUnimplemented;
+    }
+
+    const SkIRect subset = options.fSubset ? *options.fSubset
+                                           : SkIRect::MakeSize(this->codec()->dimensions());
+    if (info.width() > subset.width() || info.height() > subset.height()) {
+        return SkCodec::kInvalidScale;
+    }
+
+    // Let libjpeg do as much of the downscaling as it can while still producing at least as many
+    // pixels as requested. Its scaled pixels are averages over sampleSize x sampleSize blocks, so
+    // this only preserves the area average if the subset is made of whole blocks.
+    SkISize nativeSize = this->codec()->dimensions();
+    SkIRect nativeSubset = subset;
+    if (this->codec()->getEncodedFormat() == SkEncodedImageFormat::kJPEG) {
+        const SkISize fullSize = this->codec()->dimensions();
+        auto aligned = [](int edge, int fullEdge, int sampleSize) {
+            return edge % sampleSize == 0 || edge == fullEdge;
+        };
+        const int sampleSizes[] = { 8, 4, 2 };
+        for (int sampleSize : sampleSizes) {
+            if (!aligned(subset.fLeft, fullSize.width(), sampleSize) ||
+                !aligned(subset.fTop, fullSize.height(), sampleSize) ||
+                !aligned(subset.fRight, fullSize.width(), sampleSize) ||
+                !aligned(subset.fBottom, fullSize.height(), sampleSize)) {
+                continue;
+            }
+            const SkISize scaledSize =
+                    this->codec()->getScaledDimensions(get_scale_from_sample_size(sampleSize));
+            const SkIRect scaledSubset = SkIRect::MakeLTRB(
+                    subset.fLeft / sampleSize, subset.fTop / sampleSize,
+                    (subset.fRight + sampleSize - 1) / sampleSize,
+                    (subset.fBottom + sampleSize - 1) / sampleSize);
+            if (scaledSubset.width() >= info.width() && scaledSubset.height() >= info.height() &&
+                SkIRect::MakeSize(scaledSize).contains(scaledSubset)) {
+                nativeSize = scaledSize;
+                nativeSubset = scaledSubset;
+                break;
+            }
+        }
+    }
+
+    auto resampler = SkAreaResampler::Make(info, pixels, rowBytes, nativeSubset.size());
+    if (!resampler) {
+        return SkCodec::kInvalidConversion;
+    }
+
+    // The scanline decoder only needs to be aware of subsetting in the x-dimension.
+    AndroidOptions scanlineOptions = options;
+    SkIRect scanlineSubset = SkIRect::MakeXYWH(nativeSubset.x(), 0, nativeSubset.width(),
+                                               nativeSize.height());
+    scanlineOptions.fSubset = nativeSubset.width() == nativeSize.width() ? nullptr
+                                                                          : &scanlineSubset;
+    const SkImageInfo nativeInfo = info.makeDimensions(nativeSize);
+    const SkCodec::Result result = this->codec()->startScanlineDecode(nativeInfo,
+            &scanlineOptions);
+    if (SkCodec::kIncompleteInput == result || SkCodec::kErrorInInput == result) {
+        return SkCodec::kInvalidInput;
+    }
+    if (SkCodec::kUnimplemented == result ||
+        (SkCodec::kSuccess == result &&
+         this->codec()->getScanlineOrder() != SkCodec::kTopDown_SkScanlineOrder)) {
+        // Rows do not arrive top-down, so they cannot be averaged as they are decoded.
+        return SkAreaResampler::DecodeThenResample(this->codec(), info, pixels, rowBytes, subset,
+                                                   options);
+    }
+    if (SkCodec::kSuccess != result) {
+        return result;
+    }
+
+    auto fillRemaining = [&]() {
+        const int rowsWritten = resampler->rowsWritten();
+        const SkImageInfo fillInfo = info.makeWH(info.width(), info.height() - rowsWritten);
+        SkSampler::Fill(fillInfo, SkTAddOffset<void>(pixels, rowsWritten * rowBytes), rowBytes,
+                        options.fZeroInitialized);
+        return SkCodec::kIncompleteInput;
+    };
+
+    if (!this->codec()->skipScanlines(nativeSubset.y())) {
+        return fillRemaining();
+    }
+    skia_private::AutoTMalloc<uint8_t> row(resampler->srcRowInfo().minRowBytes());
+    for (int y = 0; y < nativeSubset.height(); y++) {
+        if (1 != this->codec()->getScanlines(row.get(), 1, 0)) {
+            return fillRemaining();
+        }
+        resampler->addRow(row.get());
+    }
+    return SkCodec::kSuccess;
+}
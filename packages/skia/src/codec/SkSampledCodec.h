@@ -60,6 +60,17 @@ private:
     SkCodec::Result sampledDecode(const SkImageInfo& info, void* pixels, size_t rowBytes,
             const AndroidOptions& options);
 
+    /**
+     *  This fulfills the same contract as onGetAndroidPixels().
+     *
+     *  We call this function from onGetAndroidPixels() when AndroidOptions::fAreaAverage
+     *  is set and fCodec does not support the requested size. fCodec decodes at the
+     *  smallest native scale that is still at least as large as the request, and rows
+     *  are area averaged down to the requested size as they are decoded.
+     */
+    SkCodec::Result areaAverageDecode(const SkImageInfo& info, void* pixels, size_t rowBytes,
+            const AndroidOptions& options);
+
     using INHERITED = SkAndroidCodec;
 };
 #endif // SkSampledCodec_DEFINED
@@ -57,6 +57,17 @@ static void sample2(void* dst, const uint8_t* src, int width, int bpp, int delta
     }
 }
 
+static void sample3(void* dst, const uint8_t* src, int width, int bpp, int deltaSrc, int offset,
+        const SkPMColor ctable[]) {
+    src += offset;
+    uint8_t* dst8 = (uint8_t*) dst;
+    for (int x = 0; x < width; x++) {
+        memcpy(dst8, src, 3);
+        dst8 += 3;
+        src += deltaSrc;
+    }
+}
+
 static void sample4(void* dst, const uint8_t* src, int width, int bpp, int deltaSrc, int offset,
         const SkPMColor ctable[]) {
     src += offset;
@@ -799,6 +810,9 @@ std::unique_ptr<SkSwizzler> SkSwizzler::MakeSimple(int srcBPP, const SkImageInfo
         case 2:     // kRGB_565_SkColorType
             proc = &sample2;
             break;
+        case 3:     // 8 bit PNG no alpha
+            proc = &sample3;
+            break;
         case 4:     // kRGBA_8888_SkColorType
                     // kBGRA_8888_SkColorType
                     // kRGBA_1010102_SkColorType
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/codec/SkTranscoder.h"
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkPixmap.h"
+#include "include/encode/SkEncoder.h"
+#include "include/private/base/SkTemplates.h"
+#include "src/codec/SkAreaResampler.h"
+
+#include <algorithm>
+
+using namespace skia_private;
+
+namespace SkTranscoder {
+
+SkCodec::Result Transcode(SkCodec* codec, const EncoderFactory& makeEncoder,
+                          const Options& options) {
+    if (!codec || !makeEncoder) {
+        return SkCodec::kInvalidParameters;
+    }
+
+    const SkISize fullSize = codec->dimensions();
+    const SkISize dstSize = options.fDimensions.isEmpty() ? fullSize : options.fDimensions;
+    if (dstSize.width() > fullSize.width() || dstSize.height() > fullSize.height()) {
+        return SkCodec::kInvalidScale;
+    }
+    const SkImageInfo dstInfo = SkImageInfo::Make(
+            dstSize, options.fColorType, codec->getInfo().alphaType(),
+            options.fColorSpace ? options.fColorSpace : codec->getInfo().refColorSpace());
+
+    // Let the codec do as much of the downscaling as it can natively, without going below the
+    // requested size. Codecs that cannot scale report their full size for every scale.
+    SkISize decodeSize = fullSize;
+    if (dstSize != fullSize) {
+        for (float scale : {1 / 8.0f, 1 / 4.0f, 1 / 2.0f}) {
+            const SkISize scaledSize = codec->getScaledDimensions(scale);
+            if (scaledSize.width() >= dstSize.width() && scaledSize.height() >= dstSize.height()) {
+                decodeSize = scaledSize;
+                break;
+            }
+        }
+    }
+    const SkImageInfo decodeInfo = dstInfo.makeDimensions(decodeSize);
+
+    // The ring of rows shared by the decoder (or resampler) and the encoder.
+    const int bufferRows = std::clamp(options.fBufferRows, 1, dstSize.height());
+    const size_t rowBytes = dstInfo.minRowBytes();
+    AutoTMalloc<uint8_t> ring(rowBytes * bufferRows);
+    const SkPixmap encoderSrc(dstInfo, ring.get(), rowBytes);
+
+    std::unique_ptr<SkAreaResampler> resampler;
+    if (decodeSize != dstSize) {
+        resampler = SkAreaResampler::Make(dstInfo, ring.get(), rowBytes, decodeSize);
+        if (!resampler) {
+            return SkCodec::kInvalidConversion;
+        }
+    }
+
+    std::unique_ptr<SkEncoder> encoder = makeEncoder(encoderSrc);
+    if (!encoder) {
+        return SkCodec::kInvalidConversion;
+    }
+
+    auto encodeRing = [&](int rows) {
+        return encoder->encodeRows(SkPixmap(dstInfo.makeWH(dstSize.width(), rows),
+                                            ring.get(), rowBytes));
+    };
+
+    // Passes a decoded row to the resampler, and drains the ring into the encoder as it fills.
+    int encodedRows = 0;
+    auto resampleRow = [&](const void* row) {
+        resampler->addRow(row);
+        const int rows = resampler->rowsWritten() - encodedRows;
+        if (rows == bufferRows || (rows > 0 && resampler->rowsWritten() == dstSize.height())) {
+            if (!encodeRing(rows)) {
+                return false;
+            }
+            encodedRows += rows;
+            resampler->setDst(ring.get(), encodedRows);
+        }
+        return true;
+    };
+
+    SkCodec::Result result = codec->startScanlineDecode(decodeInfo);
+    if (SkCodec::kSuccess == result &&
+        codec->getScanlineOrder() == SkCodec::kTopDown_SkScanlineOrder) {
+        // Rows the codec fails to decode are filled by getScanlines(), so the encoded image is
+        // always complete.
+        if (resampler) {
+            AutoTMalloc<uint8_t> row(resampler->srcRowInfo().minRowBytes());
+            for (int y = 0; y < decodeSize.height(); y++) {
+                if (1 != codec->getScanlines(row.get(), 1, 0)) {
+                    result = SkCodec::kIncompleteInput;
+                }
+                if (!resampleRow(row.get())) {
+                    return SkCodec::kInternalError;
+                }
+            }
+        } else {
+            for (int y = 0; y < dstSize.height(); y += bufferRows) {
+                const int rows = std::min(bufferRows, dstSize.height() - y);
+                if (rows != codec->getScanlines(ring.get(), rows, rowBytes)) {
+                    result = SkCodec::kIncompleteInput;
+                }
+                if (!encodeRing(rows)) {
+                    return SkCodec::kInternalError;
+                }
+            }
+        }
+        return result;
+    }
+    if (SkCodec::kSuccess != result && SkCodec::kUnimplemented != result) {
+        return result;
+    }
+
+    // The rows do not arrive top-down, so the image has to be decoded whole first.
+    SkBitmap decoded;
+    if (!decoded.tryAllocPixels(decodeInfo)) {
+        return SkCodec::kInternalError;
+    }
+    result = codec->getPixels(decoded.pixmap());
+    if (SkCodec::kSuccess != result && SkCodec::kIncompleteInput != result &&
+        SkCodec::kErrorInInput != result) {
+        return result;
+    }
+    if (resampler) {
+        for (int y = 0; y < decodeSize.height(); y++) {
+            if (!resampleRow(decoded.getAddr(0, y))) {
+                return SkCodec::kInternalError;
+            }
+        }
+    } else if (!encoder->encodeRows(decoded.pixmap())) {
+        return SkCodec::kInternalError;
+    }
+    return result;
+}
+
+}  // namespace SkTranscoder
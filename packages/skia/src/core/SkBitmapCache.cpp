@@ -8,6 +8,7 @@
 #include "src/core/SkBitmapCache.h"
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixelRef.h"
@@ -301,7 +302,10 @@ const SkMipmap* SkMipmapCache::AddAndRef(const SkImage_Base* image, SkResourceCa
         return nullptr;
     }
 
-    SkMipmap* mipmap = SkMipmap::Build(src, get_fact(localCache));
+    // The levels are filtered now, rather than lazily by whichever draw first samples them.
+    SkMipmap::BuildOptions options;
+    options.fExecutor = &SkExecutor::GetDefault();
+    SkMipmap* mipmap = SkMipmap::Build(src, get_fact(localCache), options);
     if (mipmap) {
         MipMapRec* rec = new MipMapRec(SkBitmapCacheDesc::Make(image), mipmap);
         CHECK_LOCAL(localCache, add, Add, rec);
@@ -424,6 +424,30 @@ void SkBitmapDevice::drawImageRect(const SkImage* image, const SkRect* src, cons
     SkASSERT(dst.isFinite());
     SkASSERT(dst.isSorted());
 
+    if (as_IB(image)->type() == SkImage_Base::Type::kRasterYUVA) {
+        const SkRect imageBounds = SkRect::Make(image->bounds());
+        if (!src || src->contains(imageBounds) ||
+            SkCanvas::kFast_SrcRectConstraint == constraint) {
+            // Sample the planes directly, rather than converting the whole image to RGBA first.
+            const SkRect yuvaSrc = src ? *src : imageBounds;
+            const SkMatrix matrix = SkMatrix::RectToRect(yuvaSrc, dst);
+            SkRect clippedSrc = yuvaSrc;
+            if (!clippedSrc.intersect(imageBounds)) {
+                return; // nothing to draw
+            }
+            const SkRect clippedDst = matrix.mapRect(clippedSrc);
+            if (!clippedDst.isFinite()) {
+                return;
+            }
+            SkPaint paintWithShader(paint);
+            paintWithShader.setStyle(SkPaint::kFill_Style);
+            paintWithShader.setShader(image->makeShader(SkTileMode::kClamp, SkTileMode::kClamp,
+                                                        sampling, &matrix));
+            this->drawRect(clippedDst, paintWithShader);
+            return;
+        }
+    }
+
     SkBitmap bitmap;
     // TODO: Elevate direct context requirement to public API and remove cheat.
     auto dContext = as_IB(image)->directContext();
@@ -735,8 +735,16 @@ SkBlitter* SkBlitter::Choose(const SkPixmap& device,
         paint.writable()->setDither(false);
     }
 
-    // Same basic idea used a few times: try SkRP, then try SkVM, then give up with a null-blitter.
+    // Same basic idea used a few times: try a specialized blitter, then SkRP, then SkVM, then give
+    // up with a null-blitter.
     auto create_SkRP_or_SkVMBlitter = [&]() -> SkBlitter* {
+#if defined(SK_ENABLE_SPECIALIZED_N32_BLITTERS)
+        if (!clipShader) {
+            if (auto blitter = SkCreateSpecializedN32Blitter(device, *paint, ctm, alloc, props)) {
+                return blitter;
+            }
+        }
+#endif
 
         // We need to make sure that in case RP blitter cannot be created we use VM and
         // when VM blitter cannot be created we use RP
@@ -0,0 +1,467 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBlendMode.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkColorPriv.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkShader.h"
+#include "include/core/SkSurfaceProps.h"
+#include "include/private/SkColorData.h"
+#include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTPin.h"
+#include "src/base/SkArenaAlloc.h"
+#include "src/base/SkVx.h"
+#include "src/core/SkBlitter.h"
+#include "src/core/SkColorSpacePriv.h"
+#include "src/core/SkColorSpaceXformSteps.h"
+#include "src/core/SkCoreBlitters.h"
+#include "src/core/SkMask.h"
+#include "src/core/SkMaskFilterBase.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkRasterPipelineOpList.h"
+#include "src/shaders/SkImageShader.h"
+#include "src/shaders/SkShaderBase.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+extern bool gSkForceRasterPipelineBlitter;
+extern bool gForceHighPrecisionRasterPipeline;
+
+// Blitters for the paints that most draws use and that the legacy kN32 blitters do not handle
+// (src blending, scaled images): a solid color, or a raster image sampled with nearest or
+// bilinear filtering and clamped edges, blended with src or srcover, all without any color
+// conversion. Each blend mode and kind of source is compiled into its own loop over a few pixels
+// at a time, with the same 8-bit math as the lowp raster pipeline, so they only stand in for it
+// where it would run lowp.
+
+namespace {
+
+// A row of |N| kN32 pixels, a channel per 16-bit lane.
+template <int N> using Pixels = skvx::Vec<4 * N, uint16_t>;
+
+template <int N>
+Pixels<N> load(const uint32_t* ptr) {
+    return skvx::cast<uint16_t>(skvx::Vec<4 * N, uint8_t>::Load(ptr));
+}
+
+template <int N>
+void store(uint32_t* ptr, const Pixels<N>& px) {
+    skvx::cast<uint8_t>(px).store(ptr);
+}
+
+// The same v/255 as the lowp raster pipeline's div255(): exact on NEON, and elsewhere an
+// approximation that is never off by more than 1.
+template <int N>
+Pixels<N> div255(const Pixels<N>& v) {
+#if defined(SK_ARM_HAS_NEON)
+    return (v + ((v + 128) >> 8) + 128) >> 8;
+#else
+    return (v + 255) >> 8;
+#endif
+}
+
+// Each pixel's alpha, in all four of its lanes.
+Pixels<1> alphas(const Pixels<1>& px) {
+    static_assert(SK_A32_SHIFT == 24);
+    return skvx::shuffle<3,3,3,3>(px);
+}
+Pixels<4> alphas(const Pixels<4>& px) {
+    return skvx::shuffle<3,3,3,3, 7,7,7,7, 11,11,11,11, 15,15,15,15>(px);
+}
+
+// Each pixel's coverage from |mask|, in all four of its lanes.
+template <int N> Pixels<N> coverage(const uint8_t* mask);
+
+template <> Pixels<1> coverage<1>(const uint8_t* mask) {
+    return Pixels<1>(mask[0]);
+}
+template <> Pixels<4> coverage<4>(const uint8_t* mask) {
+    const auto c = skvx::cast<uint16_t>(skvx::Vec<4, uint8_t>::Load(mask));
+    return skvx::shuffle<0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3>(c);
+}
+
+template <SkBlendMode kMode, int N>
+void blend(uint32_t* dst, const uint32_t* src, const Pixels<N>& c, bool fullCoverage) {
+    static_assert(kMode == SkBlendMode::kSrc || kMode == SkBlendMode::kSrcOver);
+    Pixels<N> s = load<N>(src);
+    if constexpr (kMode == SkBlendMode::kSrcOver) {
+        if (!fullCoverage) {
+            s = div255<N>(s * c);
+        }
+        const Pixels<N> d = load<N>(dst);
+        store<N>(dst, s + div255<N>(d * (255 - alphas(s))));
+    } else {
+        if (!fullCoverage) {
+            const Pixels<N> d = load<N>(dst);
+            s = div255<N>(d * (255 - c) + s * c);
+        }
+        store<N>(dst, s);
+    }
+}
+
+// Blends |count| pixels of |src| into |dst|, with the coverage of each from |mask| or, if it is
+// null, |constantCoverage| for all of them.
+template <SkBlendMode kMode>
+void blend_row(uint32_t* dst, const uint32_t* src, int count,
+               const uint8_t* mask, U8CPU constantCoverage) {
+    if (kMode == SkBlendMode::kSrc && !mask && constantCoverage == 0xFF) {
+        memcpy(dst, src, count * sizeof(uint32_t));
+        return;
+    }
+    const bool fullCoverage = !mask && constantCoverage == 0xFF;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        blend<kMode, 4>(dst + i, src + i,
+                        mask ? coverage<4>(mask + i) : Pixels<4>(constantCoverage), fullCoverage);
+    }
+    for (; i < count; ++i) {
+        blend<kMode, 1>(dst + i, src + i,
+                        mask ? coverage<1>(mask + i) : Pixels<1>(constantCoverage), fullCoverage);
+    }
+}
+
+// The pixels of a span are shaded into a buffer of this many, then blended.
+static constexpr int kMaxSpan = 64;
+
+// Shared by the solid color and image blitters: walks spans, runs and masks, and hands the
+// formats of mask it does not blend itself to the raster pipeline blitter.
+template <typename Derived>
+class SkN32SpecializedBlitter : public SkRasterBlitter {
+public:
+    SkN32SpecializedBlitter(const SkPixmap& device, const SkPaint& paint, const SkMatrix& ctm,
+                            SkArenaAlloc* alloc, const SkSurfaceProps& props)
+            : SkRasterBlitter(device)
+            , fPaint(paint)
+            , fCTM(ctm)
+            , fAlloc(alloc)
+            , fProps(props) {}
+
+    void blitH(int x, int y, int width) override {
+        this->blitRow(x, y, width, nullptr, 0xFF);
+    }
+
+    void blitAntiH(int x, int y, const SkAlpha antialias[], const int16_t runs[]) override {
+        for (int16_t run = *runs; run > 0; run = *runs) {
+            if (const SkAlpha aa = *antialias) {
+                this->blitRow(x, y, run, nullptr, aa);
+            }
+            x += run;
+            runs += run;
+            antialias += run;
+        }
+    }
+
+    void blitV(int x, int y, int height, SkAlpha alpha) override {
+        auto self = static_cast<Derived*>(this);
+        for (int i = 0; i < height; ++i) {
+            self->blitSpan(fDevice.writable_addr32(x, y + i), x, y + i, 1, nullptr, alpha);
+        }
+    }
+
+    void blitRect(int x, int y, int width, int height) override {
+        for (int i = 0; i < height; ++i) {
+            this->blitRow(x, y + i, width, nullptr, 0xFF);
+        }
+    }
+
+    void blitMask(const SkMask& mask, const SkIRect& clip) override {
+        if (mask.fFormat == SkMask::kBW_Format) {
+            this->INHERITED::blitMask(mask, clip);
+            return;
+        }
+        if (mask.fFormat != SkMask::kA8_Format) {
+            this->fallback()->blitMask(mask, clip);
+            return;
+        }
+        for (int y = clip.fTop; y < clip.fBottom; ++y) {
+            this->blitRow(clip.fLeft, y, clip.width(), mask.getAddr8(clip.fLeft, y), 0xFF);
+        }
+    }
+
+private:
+    // Has the derived blitter blend the row in spans of at most kMaxSpan pixels.
+    void blitRow(int x, int y, int width, const uint8_t* mask, U8CPU constantCoverage) {
+        auto self = static_cast<Derived*>(this);
+        while (width > 0) {
+            const int n = std::min(width, kMaxSpan);
+            self->blitSpan(fDevice.writable_addr32(x, y), x, y, n, mask, constantCoverage);
+            x += n;
+            width -= n;
+            if (mask) {
+                mask += n;
+            }
+        }
+    }
+
+    SkBlitter* fallback() {
+        if (!fFallback) {
+            fFallback = SkCreateRasterPipelineBlitter(fDevice, fPaint, fCTM, fAlloc, nullptr,
+                                                      fProps);
+            if (!fFallback) {
+                fFallback = fAlloc->make<SkNullBlitter>();
+            }
+        }
+        return fFallback;
+    }
+
+    const SkPaint        fPaint;
+    const SkMatrix       fCTM;
+    SkArenaAlloc*        fAlloc;
+    const SkSurfaceProps fProps;
+    SkBlitter*           fFallback = nullptr;
+
+    using INHERITED = SkRasterBlitter;
+};
+
+template <SkBlendMode kMode>
+class SkN32_Color_Blitter final : public SkN32SpecializedBlitter<SkN32_Color_Blitter<kMode>> {
+public:
+    SkN32_Color_Blitter(const SkPixmap& device, const SkPaint& paint, const SkMatrix& ctm,
+                        SkArenaAlloc* alloc, const SkSurfaceProps& props, SkPMColor color)
+            : SkN32SpecializedBlitter<SkN32_Color_Blitter>(device, paint, ctm, alloc, props)
+            , fColor(color) {
+        SkOpts::memset32(fRow, color, kMaxSpan);
+    }
+
+    void blitSpan(uint32_t* dst, int, int, int count, const uint8_t* mask, U8CPU coverage) {
+        const bool opaque = kMode == SkBlendMode::kSrc || SkGetPackedA32(fColor) == 0xFF;
+        if (!mask && coverage == 0xFF && opaque) {
+            SkOpts::memset32(dst, fColor, count);
+        } else {
+            blend_row<kMode>(dst, fRow, count, mask, coverage);
+        }
+    }
+
+private:
+    const SkPMColor fColor;
+    uint32_t        fRow[kMaxSpan];
+};
+
+// Samples an image whose pixels need no color conversion, through a scale and translate, with
+// clamped edges.
+template <SkBlendMode kMode, SkFilterMode kFilter>
+class SkN32_Image_Blitter final
+        : public SkN32SpecializedBlitter<SkN32_Image_Blitter<kMode, kFilter>> {
+public:
+    SkN32_Image_Blitter(const SkPixmap& device, const SkPaint& paint, const SkMatrix& ctm,
+                        SkArenaAlloc* alloc, const SkSurfaceProps& props,
+                        const SkPixmap& image, const SkMatrix& inverse)
+            : SkN32SpecializedBlitter<SkN32_Image_Blitter>(device, paint, ctm, alloc, props)
+            , fImage(image)
+            , fScaleX(inverse.getScaleX())
+            , fScaleY(inverse.getScaleY())
+            , fTransX(inverse.getTranslateX())
+            , fTransY(inverse.getTranslateY())
+            , fAlpha(paint.getAlpha()) {
+        SkASSERT(inverse.isScaleTranslate());
+    }
+
+    void blitSpan(uint32_t* dst, int x, int y, int count, const uint8_t* mask, U8CPU coverage) {
+        uint32_t src[kMaxSpan];
+        if constexpr (kFilter == SkFilterMode::kNearest) {
+            this->sampleNearest(src, x, y, count);
+        } else {
+            this->sampleLinear(src, x, y, count);
+        }
+        if (fAlpha != 0xFF) {
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                store<4>(src + i, div255<4>(load<4>(src + i) * fAlpha));
+            }
+            for (; i < count; ++i) {
+                store<1>(src + i, div255<1>(load<1>(src + i) * fAlpha));
+            }
+        }
+        blend_row<kMode>(dst, src, count, mask, coverage);
+    }
+
+private:
+    // Pixel centers map to the image like the raster pipeline maps them, x + 0.5 through the
+    // inverse matrix.
+    float mapX(int x) const { return fScaleX * (x + 0.5f) + fTransX; }
+    float mapY(int y) const { return fScaleY * (y + 0.5f) + fTransY; }
+
+    int clampX(int x) const { return SkTPin(x, 0, fImage.width()  - 1); }
+    int clampY(int y) const { return SkTPin(y, 0, fImage.height() - 1); }
+
+    // Like the pipeline's nearest gather, a sample exactly on a pixel boundary takes the pixel
+    // before it, so that scaled draws pick the same pixels in both.
+    static int nearest(float v) { return sk_float_ceil2int(v) - 1; }
+
+    void sampleNearest(uint32_t* src, int x, int y, int count) const {
+        const uint32_t* row = fImage.addr32(0, this->clampY(nearest(this->mapY(y))));
+        for (int i = 0; i < count; ++i) {
+            src[i] = row[this->clampX(nearest(this->mapX(x + i)))];
+        }
+    }
+
+    // Does what the lowp pipeline's bilerp_clamp_8888 does: quantizes the sample point to 16.16
+    // fixed point and lerps the four pixels around it with Q15 weights, rounding the same way.
+    void sampleLinear(uint32_t* src, int x, int y, int count) const {
+        using I32x4 = skvx::Vec<4, int32_t>;
+        auto unpack = [](uint32_t px) {
+            return skvx::cast<int32_t>(skvx::Vec<4, uint8_t>::Load(&px));
+        };
+        // The sample point less a half, in 16.16 fixed point.
+        auto quantize = [](float v) { return sk_float_floor2int(65536.0f * v + 0.5f) - 32768; };
+        // Twice the lerp from |a| to |b| by |t| on [-1, 1) in Q15, scaled_mult() and
+        // constrained_add() in the pipeline.
+        auto lerp2 = [](int32_t t, const I32x4& a, const I32x4& b) {
+            return ((t * (b - a) + (1 << 14)) >> 15) + (a + b);
+        };
+
+        const int32_t qy = quantize(this->mapY(y));
+        const int32_t ty = (int16_t)(qy ^ 0x8000);
+        const uint32_t* row0 = fImage.addr32(0, this->clampY(qy >> 16));
+        const uint32_t* row1 = fImage.addr32(0, this->clampY((qy >> 16) + 1));
+
+        for (int i = 0; i < count; ++i) {
+            const int32_t qx = quantize(this->mapX(x + i));
+            const int32_t tx = (int16_t)(qx ^ 0x8000);
+            const int ix0 = this->clampX(qx >> 16),
+                      ix1 = this->clampX((qx >> 16) + 1);
+
+            auto lerpX = [&](uint32_t left, uint32_t right) {
+                return (lerp2(tx, unpack(left) << 7, unpack(right) << 7) + 1) >> 1;
+            };
+            const I32x4 top    = lerpX(row0[ix0], row0[ix1]),
+                        bottom = lerpX(row1[ix0], row1[ix1]);
+            const I32x4 px = (lerp2(ty, top, bottom) + 0x80) >> 8;
+            skvx::cast<uint8_t>(px).store(src + i);
+        }
+    }
+
+    const SkPixmap fImage;
+    const float    fScaleX, fScaleY, fTransX, fTransY;
+    const U8CPU    fAlpha;
+};
+
+template <SkBlendMode kMode>
+SkBlitter* make_image_blitter(SkFilterMode filter, const SkPixmap& device, const SkPaint& paint,
+                              const SkMatrix& ctm, SkArenaAlloc* alloc,
+                              const SkSurfaceProps& props, const SkPixmap& image,
+                              const SkMatrix& inverse) {
+    if (filter == SkFilterMode::kNearest) {
+        return alloc->make<SkN32_Image_Blitter<kMode, SkFilterMode::kNearest>>(
+                device, paint, ctm, alloc, props, image, inverse);
+    }
+    return alloc->make<SkN32_Image_Blitter<kMode, SkFilterMode::kLinear>>(
+            device, paint, ctm, alloc, props, image, inverse);
+}
+
+}  // namespace
+
+SkBlitter* SkCreateSpecializedN32Blitter(const SkPixmap& device,
+                                         const SkPaint& paint,
+                                         const SkMatrix& ctm,
+                                         SkArenaAlloc* alloc,
+                                         const SkSurfaceProps& props) {
+    if (gSkForceRasterPipelineBlitter || gForceHighPrecisionRasterPipeline) {
+        return nullptr;
+    }
+#if defined(SK_FORCE_RASTER_PIPELINE_BLITTER)
+    return nullptr;
+#endif
+    // Without lowp stages (e.g. in builds not compiled by Clang) the raster pipeline draws in
+    // floats, and its results would not match ours.
+    if (!SkOpts::ops_lowp[(int)SkRasterPipelineOp::bilerp_clamp_8888]) {
+        return nullptr;
+    }
+    if (device.colorType() != kN32_SkColorType || device.alphaType() == kUnpremul_SkAlphaType) {
+        return nullptr;
+    }
+    const auto mode = paint.asBlendMode();
+    if (!mode || (*mode != SkBlendMode::kSrc && *mode != SkBlendMode::kSrcOver)) {
+        return nullptr;
+    }
+    const SkMaskFilterBase* mf = as_MFB(paint.getMaskFilter());
+    if (paint.getColorFilter() || (mf && mf->getFormat() == SkMask::k3D_Format)) {
+        return nullptr;
+    }
+
+    if (!paint.getShader()) {
+        // The paint color must already be in the device's color space, and in range.
+        const SkColor4f color = paint.getColor4f();
+        if (SkColorSpaceXformSteps(sk_srgb_singleton(), kUnpremul_SkAlphaType,
+                                   device.colorSpace(), kUnpremul_SkAlphaType).flags.mask() != 0 ||
+            !color.fitsInBytes()) {
+            return nullptr;
+        }
+        const SkPMColor4f pm = color.premul();
+        // Rounded like the raster pipeline's uniform_color.
+        auto to_byte = [](float v) { return (U8CPU)(v * 255.0f + 0.5f); };
+        const SkPMColor pmColor = SkPackARGB32(to_byte(pm.fA), to_byte(pm.fR),
+                                               to_byte(pm.fG), to_byte(pm.fB));
+        if (*mode == SkBlendMode::kSrc) {
+            return alloc->make<SkN32_Color_Blitter<SkBlendMode::kSrc>>(
+                    device, paint, ctm, alloc, props, pmColor);
+        }
+        return alloc->make<SkN32_Color_Blitter<SkBlendMode::kSrcOver>>(
+                device, paint, ctm, alloc, props, pmColor);
+    }
+
+    // Dithering only applies to shaders, and the raster pipeline does it.
+    if (paint.isDither()) {
+        return nullptr;
+    }
+
+    // Unwrap the local matrices around an image shader.
+    sk_sp<SkShader> shader = paint.refShader();
+    SkMatrix localMatrix = SkMatrix::I();
+    for (SkMatrix lm; sk_sp<SkShader> wrapped = as_SB(shader)->makeAsALocalMatrixShader(&lm);) {
+        localMatrix = SkShaderBase::ConcatLocalMatrices(localMatrix, lm);
+        shader = std::move(wrapped);
+    }
+    SkTileMode tileModes[2];
+    SkImage* image = shader->isAImage(nullptr, tileModes);
+    if (!image || tileModes[0] != SkTileMode::kClamp || tileModes[1] != SkTileMode::kClamp) {
+        return nullptr;
+    }
+    // Only SkImageShader reports an image once the local matrix shaders are unwrapped.
+    SkSamplingOptions sampling = static_cast<const SkImageShader*>(shader.get())->sampling();
+    if (sampling.useCubic || sampling.isAniso() || sampling.mipmap != SkMipmapMode::kNone) {
+        return nullptr;
+    }
+
+    SkPixmap pixels;
+    if (!image->peekPixels(&pixels) || pixels.colorType() != kN32_SkColorType ||
+        pixels.alphaType() == kUnpremul_SkAlphaType) {
+        return nullptr;
+    }
+    // The pixels must already be in the device's color space. (Opaque pixels are premul too.)
+    if (SkColorSpaceXformSteps(pixels.colorSpace(), kPremul_SkAlphaType,
+                               device.colorSpace(), kPremul_SkAlphaType).flags.mask() != 0) {
+        return nullptr;
+    }
+
+    SkMatrix inverse;
+    if (!SkMatrix::Concat(ctm, localMatrix).invert(&inverse) || !inverse.isScaleTranslate()) {
+        return nullptr;
+    }
+    // As SkImageShader does, sample an integer translate with nearest, as bilerp is the same.
+    if (inverse.getType() <= SkMatrix::kTranslate_Mask &&
+        inverse.getTranslateX() == (int)inverse.getTranslateX() &&
+        inverse.getTranslateY() == (int)inverse.getTranslateY()) {
+        sampling = SkSamplingOptions(SkFilterMode::kNearest);
+    }
+
+    // Opaque pixels drawn opaquely cover what is under them, whatever the blend mode.
+    if (*mode == SkBlendMode::kSrc || (image->isOpaque() && paint.getAlpha() == 0xFF)) {
+        return make_image_blitter<SkBlendMode::kSrc>(sampling.filter, device, paint, ctm, alloc,
+                                                     props, pixels, inverse);
+    }
+    return make_image_blitter<SkBlendMode::kSrcOver>(sampling.filter, device, paint, ctm, alloc,
+                                                     props, pixels, inverse);
+}
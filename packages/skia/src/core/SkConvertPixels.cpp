@@ -214,6 +214,51 @@ static bool convert_to_alpha8(const SkImageInfo& dstInfo,       void* vdst, size
     return false;
 }
 
+static bool convert_to_8888(const SkImageInfo& dstInfo,       void* dstPixels, size_t dstRB,
+                            const SkImageInfo& srcInfo, const void* srcPixels, size_t srcRB,
+                            const SkColorSpaceXformSteps& steps) {
+    const SkColorType dstCT = dstInfo.colorType();
+    if ((dstCT != kRGBA_8888_SkColorType && dstCT != kBGRA_8888_SkColorType) ||
+        steps.flags.linearize       ||
+        steps.flags.gamut_transform ||
+        steps.flags.encode) {
+        return false;
+    }
+    const bool swapRB = dstCT == kBGRA_8888_SkColorType;
+
+    auto convert_rows = [&](auto* fn, auto srcType) {
+        using Src = decltype(srcType);
+        auto dst = (uint32_t*)dstPixels;
+        auto src = (const Src*)srcPixels;
+        for (int y = 0; y < dstInfo.height(); y++) {
+            fn(dst, src, dstInfo.width());
+            dst = SkTAddOffset<uint32_t>(dst, dstRB);
+            src = SkTAddOffset<const Src>(src, srcRB);
+        }
+        return true;
+    };
+
+    switch (srcInfo.colorType()) {
+        case kGray_8_SkColorType:
+            // Gray is opaque, so there is nothing to premultiply or unpremultiply.
+            return convert_rows(SkOpts::gray_to_RGB1, uint8_t{});
+
+        case kAlpha_8_SkColorType:
+            // The color channels are 0, premultiplied or not.
+            return convert_rows(SkOpts::alpha_to_000A, uint8_t{});
+
+        case kRGBA_F16Norm_SkColorType:
+        case kRGBA_F16_SkColorType:
+            if (steps.flags.premul || steps.flags.unpremul) {
+                return false;
+            }
+            return convert_rows(swapRB ? SkOpts::F16_to_BGRA : SkOpts::F16_to_RGBA, uint64_t{});
+
+        default:
+            return false;
+    }
+}
+
 // Default: Use the pipeline.
 static void convert_with_pipeline(const SkImageInfo& dstInfo, void* dstRow, int dstStride,
                                   const SkImageInfo& srcInfo, const void* srcRow, int srcStride,
@@ -243,7 +288,7 @@ bool SkConvertPixels(const SkImageInfo& dstInfo,       void* dstPixels, size_t d
     SkColorSpaceXformSteps steps{srcInfo.colorSpace(), srcInfo.alphaType(),
                                  dstInfo.colorSpace(), dstInfo.alphaType()};
 
-    for (auto fn : {rect_memcpy, swizzle_or_premul, convert_to_alpha8}) {
+    for (auto fn : {rect_memcpy, swizzle_or_premul, convert_to_alpha8, convert_to_8888}) {
         if (fn(dstInfo, dstPixels, dstRB, srcInfo, srcPixels, srcRB, steps)) {
             return true;
         }
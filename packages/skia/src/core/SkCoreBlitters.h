@@ -137,4 +137,14 @@ SkBlitter* SkCreateRasterPipelineBlitter(const SkPixmap&, const SkPaint&,
                                          bool shader_is_opaque,
                                          SkArenaAlloc*, sk_sp<SkShader> clipShader);
 
+// Returns a blitter specialized for a solid color, or a raster image sampled with nearest or
+// bilinear filtering and clamped edges, blended with src or srcover into kN32; or nullptr if the
+// paint is not one of those. SkBlitter::Choose() only tries it when
+// SK_ENABLE_SPECIALIZED_N32_BLITTERS is defined.
+SkBlitter* SkCreateSpecializedN32Blitter(const SkPixmap&,
+                                         const SkPaint&,
+                                         const SkMatrix& ctm,
+                                         SkArenaAlloc*,
+                                         const SkSurfaceProps& props);
+
 #endif
@@ -116,6 +116,19 @@ bool SkImageFilter_Base::affectsTransparentBlack() const {
     return false;
 }
 
+bool SkImageFilter_Base::hasLocalDependencies() const {
+    if (!this->onHasLocalDependencies()) {
+        return false;
+    }
+    for (int i = 0; i < this->countInputs(); i++) {
+        const SkImageFilter* input = this->getInput(i);
+        if (input && !as_IFB(input)->hasLocalDependencies()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SkImageFilter::asAColorFilter(SkColorFilter** filterPtr) const {
     SkASSERT(nullptr != filterPtr);
     if (!this->isColorFilterNode(filterPtr)) {
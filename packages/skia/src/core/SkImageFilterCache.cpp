@@ -11,6 +11,7 @@
 
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkTraceMemoryDump.h"
 #include "include/private/base/SkMutex.h"
 #include "include/private/base/SkOnce.h"
 #include "src/base/SkTInternalLList.h"
@@ -35,6 +36,7 @@ public:
     CacheImpl(size_t maxBytes) : fMaxBytes(maxBytes), fCurrentBytes(0) { }
     ~CacheImpl() override {
         fLookup.foreach([&](Value* v) { delete v; });
+        fFrameLookup.foreach([&](Value* v) { delete v; });
     }
     struct Value {
         Value(const Key& key, const skif::FilterResult& image,
@@ -43,7 +45,16 @@ public:
 
         Key fKey;
         skif::FilterResult fImage;
+        // Only set for Frames, whose output is fImage.
+        skif::FilterResult fFrameSource;
+        sk_sp<SkColorSpace> fFrameColorSpace;
+        bool fIsFrame = false;
         const SkImageFilter* fFilter;
+
+        size_t bytes() const {
+            return (fImage.image() ? fImage.image()->getSize() : 0) +
+                   (fFrameSource.image() ? fFrameSource.image()->getSize() : 0);
+        }
         static const Key& GetKey(const Value& v) {
             return v.fKey;
         }
@@ -64,8 +75,10 @@ public:
             }
 
             *result = v->fImage;
+            fStats.fHits++;
             return true;
         }
+        fStats.fMisses++;
         return false;
     }
 
@@ -75,24 +88,50 @@ public:
         if (Value* v = fLookup.find(key)) {
             this->removeInternal(v);
         }
-        Value* v = new Value(key, result, filter);
-        fLookup.add(v);
-        fLRU.addToHead(v);
-        fCurrentBytes += result.image() ? result.image()->getSize() : 0;
-        if (auto* values = fImageFilterValues.find(filter)) {
-            values->push_back(v);
-        } else {
-            fImageFilterValues.set(filter, {v});
-        }
+        this->addInternal(new Value(key, result, filter));
+    }
 
-        while (fCurrentBytes > fMaxBytes) {
-            Value* tail = fLRU.tail();
-            SkASSERT(tail);
-            if (tail == v) {
-                break;
+    bool getFrame(const Key& key, Frame* frame) const override {
+        SkASSERT(frame);
+
+        SkAutoMutexExclusive mutex(fMutex);
+        if (Value* v = fFrameLookup.find(key)) {
+            if (v != fLRU.head()) {
+                fLRU.remove(v);
+                fLRU.addToHead(v);
             }
-            this->removeInternal(tail);
+
+            frame->fSource = v->fFrameSource;
+            frame->fOutput = v->fImage;
+            frame->fColorSpace = v->fFrameColorSpace;
+            return true;
+        }
+        return false;
+    }
+
+    void setFrame(const Key& key, const SkImageFilter* filter, const Frame& frame) override {
+        SkASSERT(key.fSrcGenID == 0 && key.fSrcSubset.isEmpty());
+
+        SkAutoMutexExclusive mutex(fMutex);
+        if (Value* v = fFrameLookup.find(key)) {
+            this->removeInternal(v);
         }
+        Value* v = new Value(key, frame.fOutput, filter);
+        v->fFrameSource = frame.fSource;
+        v->fFrameColorSpace = frame.fColorSpace;
+        v->fIsFrame = true;
+        this->addInternal(v);
+    }
+
+    void recordTiles(int reused, int recomputed) override {
+        SkAutoMutexExclusive mutex(fMutex);
+        fStats.fTilesReused += reused;
+        fStats.fTilesRecomputed += recomputed;
+    }
+
+    Stats stats() const override {
+        SkAutoMutexExclusive mutex(fMutex);
+        return fStats;
     }
 
     void purge() override {
@@ -119,8 +158,33 @@ public:
         fImageFilterValues.remove(filter);
     }
 
-    SkDEBUGCODE(int count() const override { return fLookup.count(); })
+    SkDEBUGCODE(int count() const override { return fLookup.count() + fFrameLookup.count(); })
 private:
+    void addInternal(Value* v) {
+        const SkImageFilter* filter = v->fFilter;
+        if (v->fIsFrame) {
+            fFrameLookup.add(v);
+        } else {
+            fLookup.add(v);
+        }
+        fLRU.addToHead(v);
+        fCurrentBytes += v->bytes();
+        if (auto* values = fImageFilterValues.find(filter)) {
+            values->push_back(v);
+        } else {
+            fImageFilterValues.set(filter, {v});
+        }
+
+        while (fCurrentBytes > fMaxBytes) {
+            Value* tail = fLRU.tail();
+            SkASSERT(tail);
+            if (tail == v) {
+                break;
+            }
+            this->removeInternal(tail);
+        }
+    }
+
     void removeInternal(Value* v) {
         if (v->fFilter) {
             if (auto* values = fImageFilterValues.find(v->fFilter)) {
@@ -136,18 +200,24 @@ private:
                 }
             }
         }
-        fCurrentBytes -= v->fImage.image() ? v->fImage.image()->getSize() : 0;
+        fCurrentBytes -= v->bytes();
         fLRU.remove(v);
-        fLookup.remove(v->fKey);
+        if (v->fIsFrame) {
+            fFrameLookup.remove(v->fKey);
+        } else {
+            fLookup.remove(v->fKey);
+        }
         delete v;
     }
 private:
     SkTDynamicHash<Value, Key>                          fLookup;
+    SkTDynamicHash<Value, Key>                          fFrameLookup;
     mutable SkTInternalLList<Value>                     fLRU;
-    // Value* always points to an item in fLookup.
+    // Value* always points to an item in fLookup or, for Frames, in fFrameLookup.
     THashMap<const SkImageFilter*, std::vector<Value*>> fImageFilterValues;
     size_t                                              fMaxBytes;
     size_t                                              fCurrentBytes;
+    mutable Stats                                       fStats;
     mutable SkMutex                                     fMutex;
 };
 
@@ -164,3 +234,13 @@ SkImageFilterCache* SkImageFilterCache::Get() {
     once([]{ cache = SkImageFilterCache::Create(kDefaultCacheSize); });
     return cache;
 }
+
+void SkImageFilterCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
+    // These are counts, not memory, so none of them is named "size".
+    const Stats stats = Get()->stats();
+    const char* dumpName = "skia/image_filter_cache";
+    dump->dumpNumericValue(dumpName, "hits", "objects", stats.fHits);
+    dump->dumpNumericValue(dumpName, "misses", "objects", stats.fMisses);
+    dump->dumpNumericValue(dumpName, "tiles_reused", "objects", stats.fTilesReused);
+    dump->dumpNumericValue(dumpName, "tiles_recomputed", "objects", stats.fTilesRecomputed);
+}
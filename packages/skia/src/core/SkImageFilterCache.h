@@ -8,12 +8,16 @@
 #ifndef SkImageFilterCache_DEFINED
 #define SkImageFilterCache_DEFINED
 
+#include "include/core/SkColorSpace.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkRefCnt.h"
 #include "src/core/SkImageFilterTypes.h"
 
+#include <cstdint>
+
 struct SkIPoint;
 class SkImageFilter;
+class SkTraceMemoryDump;
 
 struct SkImageFilterCacheKey {
     SkImageFilterCacheKey(const uint32_t uniqueID, const SkMatrix& matrix,
@@ -67,6 +71,39 @@ public:
                      const skif::FilterResult& result) = 0;
     virtual void purge() = 0;
     virtual void purgeByImageFilter(const SkImageFilter*) = 0;
+
+    // The last output of a filter that reuses the parts of its previous output that a change to
+    // the source did not damage (see SkImageFilters::Tiled()), along with that source and the
+    // color space it was filtered in, which the key leaves out.
+    struct Frame {
+        skif::FilterResult   fSource;
+        skif::FilterResult   fOutput;
+        sk_sp<SkColorSpace>  fColorSpace;
+    };
+    // Like get() and set(), but Frames are looked up separately from results, since their keys
+    // leave out the source (fSrcGenID and fSrcSubset are zero). Both images count against the
+    // cache's budget, and are purged like results.
+    virtual bool getFrame(const SkImageFilterCacheKey& key, Frame* frame) const = 0;
+    virtual void setFrame(const SkImageFilterCacheKey& key, const SkImageFilter* filter,
+                          const Frame& frame) = 0;
+
+    struct Stats {
+        // Calls to get() that found a result, and those that did not.
+        int64_t fHits = 0;
+        int64_t fMisses = 0;
+        // Tiles of Frames that were copied from the previous output, and those that were filtered
+        // again because the source changed within their required input.
+        int64_t fTilesReused = 0;
+        int64_t fTilesRecomputed = 0;
+    };
+    virtual void recordTiles(int reused, int recomputed) = 0;
+    // The counts since the cache was created.
+    virtual Stats stats() const = 0;
+
+    // Reports the stats() of the global cache, under "skia/image_filter_cache". Called by
+    // SkGraphics::DumpMemoryStatistics().
+    static void DumpMemoryStatistics(SkTraceMemoryDump* dump);
+
     SkDEBUGCODE(virtual int count() const = 0;)
 };
 
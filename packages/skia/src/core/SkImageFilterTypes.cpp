@@ -16,6 +16,7 @@
 #include "src/core/SkMatrixPriv.h"
 #include "src/core/SkRectPriv.h"
 #include "src/core/SkSpecialSurface.h"
+#include "src/core/SkTaskGroup.h"
 
 namespace skif {
 
@@ -257,6 +258,22 @@ sk_sp<SkSpecialSurface> Context::makeSurface(const SkISize& size,
     }
 }
 
+void Context::batch(int count, const std::function<void(int)>& fn) const {
+    SkExecutor* executor = this->executor();
+    if (!executor || count < 2) {
+        for (int i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    // This thread takes the first call itself. wait() helps with queued work, so batches nest
+    // (e.g. a merge of blends) without tying up a thread per level.
+    SkTaskGroup tasks(*executor);
+    tasks.batch(count - 1, [&fn](int i) { fn(i + 1); });
+    fn(0);
+    tasks.wait();
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Mapping
 
@@ -19,8 +19,11 @@
 #include "src/core/SkEnumBitMask.h"
 #include "src/core/SkSpecialImage.h"
 
+#include <functional>
+
 class GrRecordingContext;
 enum GrSurfaceOrigin : int;
+class SkExecutor;
 class SkImage;
 class SkImageFilter;
 class SkImageFilterCache;
@@ -869,6 +872,10 @@ struct ContextInfo {
     SkSurfaceProps      fSurfaceProps;
 
     SkImageFilterCache* fCache;
+
+    // If not null, CPU filtering may evaluate independent inputs of a filter on this executor
+    // (see Context::batch()). Not owned, like fColorSpace.
+    SkExecutor*         fExecutor = nullptr;
 };
 
 class Context {
@@ -942,6 +949,16 @@ public:
     // DEPRECATED: Use source() instead to get both the image and its origin.
     const SkSpecialImage* sourceImage() const { return fInfo.fSource.image(); }
 
+    // The executor for filtering independent inputs concurrently, or null. This is always null
+    // when filtering on the GPU, whose contexts must be used from a single thread.
+    SkExecutor* executor() const {
+        return fGaneshContext || fGraphiteRecorder ? nullptr : fInfo.fExecutor;
+    }
+
+    // Calls fn(0), ..., fn(count - 1) and returns once they have all returned. With an executor
+    // they may be called concurrently, so each call must only write to state it alone owns.
+    void batch(int count, const std::function<void(int)>& fn) const;
+
     // True if image filtering should occur on the GPU if possible.
     bool gpuBacked() const { return SkToBool(fGaneshContext); }
     // The recording context to use when computing the filter with the GPU.
@@ -972,6 +989,20 @@ public:
         return Context(info, fGaneshContext, fGaneshOrigin, fGraphiteRecorder);
     }
 
+    // Create a new context that matches this context, but with an overridden cache.
+    Context withNewCache(SkImageFilterCache* cache) const {
+        ContextInfo info = fInfo;
+        info.fCache = cache;
+        return Context(info, fGaneshContext, fGaneshOrigin, fGraphiteRecorder);
+    }
+
+    // Create a new context that matches this context, but with an overridden executor.
+    Context withNewExecutor(SkExecutor* executor) const {
+        ContextInfo info = fInfo;
+        info.fExecutor = executor;
+        return Context(info, fGaneshContext, fGaneshOrigin, fGraphiteRecorder);
+    }
+
     // Create a new context that matches this context, but with an overridden source.
     // TODO: Have this take just a FilterResult when no origin manipulation is required.
     Context withNewSource(sk_sp<SkSpecialImage> source, LayerSpace<SkIPoint> origin) const {
@@ -108,6 +108,11 @@ public:
     // Returns true if this image filter graph references the Context's source image.
     bool usesSource() const { return fUsesSrcInput; }
 
+    // Returns true if every node of this image filter graph has local dependencies (see
+    // onHasLocalDependencies()), so that a change to the source can only change the output where
+    // the output's required input, as computed by getInputBounds(), overlaps that change.
+    bool hasLocalDependencies() const;
+
     /**
      *  Most ImageFilters can natively handle scaling and translate components in the CTM. Only
      *  some of them can handle affine (or more complex) matrices. Some may only handle translation.
@@ -361,6 +366,14 @@ private:
      */
     virtual bool onAffectsTransparentBlack() const { return false; }
 
+    /**
+     *  Return true if each pixel this node outputs depends only on its inputs' pixels within the
+     *  bounds onGetInputLayerBounds() returns for that pixel. Returning false (the default) is
+     *  always safe; it just prevents reusing the unchanged parts of an earlier output when the
+     *  source changes (see SkImageFilters::Tiled()).
+     */
+    virtual bool onHasLocalDependencies() const { return false; }
+
     /**
      *  This is the virtual which should be overridden by the derived class to perform image
      *  filtering. Subclasses are responsible for recursing to their input filters, although the
@@ -473,11 +486,13 @@ void SkRegisterMatrixConvolutionImageFilterFlattenable();
 void SkRegisterMatrixTransformImageFilterFlattenable();
 void SkRegisterMergeImageFilterFlattenable();
 void SkRegisterMorphologyImageFilterFlattenables();
+void SkRegisterParallelImageFilterFlattenable();
 void SkRegisterPictureImageFilterFlattenable();
 #ifdef SK_ENABLE_SKSL
 void SkRegisterRuntimeImageFilterFlattenable();
 #endif
 void SkRegisterShaderImageFilterFlattenable();
 void SkRegisterTileImageFilterFlattenable();
+void SkRegisterTiledImageFilterFlattenable();
 
 #endif // SkImageFilter_Base_DEFINED
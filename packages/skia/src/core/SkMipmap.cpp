@@ -16,7 +16,9 @@
 #include "src/base/SkVx.h"
 #include "src/core/SkImageInfoPriv.h"
 #include "src/core/SkMipmapBuilder.h"
+#include "src/core/SkTaskGroup.h"
 
+#include <algorithm>
 #include <new>
 
 //
@@ -383,6 +385,109 @@ template <typename F> void downsample_3_3(void* dst, const void* src, size_t src
     }
 }
 
+//
+//  The 2x2 and 3x3 filters do most of the work, so for the common integer color types they also
+//  have versions that filter several destination pixels at once. These read the source two pixels
+//  at a time, as a "pair", and expand pixels into fields with room for a sum of 16 of them, exactly
+//  as the ColorTypeFilter does, so their results are identical. Each VecFilter provides:
+//
+//      Pair        a pair of source pixels.
+//      Pairs       N pairs.
+//      Lo(pairs)   the first pixel of each pair, expanded.
+//      Hi(pairs)   the second pixel of each pair, expanded.
+//      Compact(x)  N expanded pixels, compacted.
+//
+
+struct VecFilter_8888 {
+    using Scalar = ColorTypeFilter_8888;
+    static constexpr int N = 4;
+    using Pair = uint64_t;
+    using Pairs = skvx::Vec<N, Pair>;
+    using Expanded = skvx::Vec<2*N, uint32_t>;  // R and B in the first half, G and A in the second
+
+    static Expanded Expand(const skvx::Vec<N, uint32_t>& x) {
+        return skvx::join(x & 0x00FF00FF, (x >> 8) & 0x00FF00FF);
+    }
+    static Expanded Lo(const Pairs& p) { return Expand(skvx::cast<uint32_t>(p)); }
+    static Expanded Hi(const Pairs& p) { return Expand(skvx::cast<uint32_t>(p >> 32)); }
+    static skvx::Vec<N, uint32_t> Compact(const Expanded& x) {
+        return (x.lo & 0x00FF00FF) | ((x.hi & 0x00FF00FF) << 8);
+    }
+};
+
+struct VecFilter_565 {
+    using Scalar = ColorTypeFilter_565;
+    static constexpr int N = 8;
+    using Pair = uint32_t;
+    using Pairs = skvx::Vec<N, Pair>;
+    using Expanded = skvx::Vec<N, uint32_t>;
+
+    static Expanded Expand(const Expanded& x) {
+        return (x & ~SK_G16_MASK_IN_PLACE) | ((x & SK_G16_MASK_IN_PLACE) << 16);
+    }
+    static Expanded Lo(const Pairs& p) { return Expand(p & 0xFFFF); }
+    static Expanded Hi(const Pairs& p) { return Expand(p >> 16); }
+    static skvx::Vec<N, uint16_t> Compact(const Expanded& x) {
+        return skvx::cast<uint16_t>(((x & ~SK_G16_MASK_IN_PLACE) & 0xFFFF) |
+                                    ((x >> 16) & SK_G16_MASK_IN_PLACE));
+    }
+};
+
+struct VecFilter_8 {
+    using Scalar = ColorTypeFilter_8;
+    static constexpr int N = 16;
+    using Pair = uint16_t;
+    using Pairs = skvx::Vec<N, Pair>;
+    using Expanded = skvx::Vec<N, uint16_t>;
+
+    static Expanded Lo(const Pairs& p) { return p & 0xFF; }
+    static Expanded Hi(const Pairs& p) { return p >> 8; }
+    static skvx::Vec<N, uint8_t> Compact(const Expanded& x) { return skvx::cast<uint8_t>(x); }
+};
+
+template <typename V> void downsample_2_2_vec(void* dst, const void* src, size_t srcRB, int count) {
+    SkASSERT(count > 0);
+    using Pair = typename V::Pair;
+    auto p0 = static_cast<const Pair*>(src);
+    auto p1 = (const Pair*)((const char*)p0 + srcRB);
+    auto d = static_cast<typename V::Scalar::Type*>(dst);
+
+    int i = 0;
+    for (; i + V::N <= count; i += V::N) {
+        auto r0 = V::Pairs::Load(p0 + i);
+        auto r1 = V::Pairs::Load(p1 + i);
+
+        auto c = V::Lo(r0) + V::Hi(r0) + V::Lo(r1) + V::Hi(r1);
+        V::Compact(c >> 2).store(d + i);
+    }
+    if (i < count) {
+        downsample_2_2<typename V::Scalar>(d + i, p0 + i, srcRB, count - i);
+    }
+}
+
+template <typename V> void downsample_3_3_vec(void* dst, const void* src, size_t srcRB, int count) {
+    SkASSERT(count > 0);
+    using Pair = typename V::Pair;
+    auto p0 = static_cast<const Pair*>(src);
+    auto p1 = (const Pair*)((const char*)p0 + srcRB);
+    auto p2 = (const Pair*)((const char*)p1 + srcRB);
+    auto d = static_cast<typename V::Scalar::Type*>(dst);
+
+    // Each destination pixel also reads the first pixel of the next pair. The last one's is the
+    // last pixel of the row, so the pair would read past it, and it is left to the scalar loop.
+    auto column_sum = [](const Pair* p) {
+        auto a = V::Pairs::Load(p);
+        auto b = V::Pairs::Load(p + 1);
+        return add_121(V::Lo(a), V::Hi(a), V::Lo(b));
+    };
+    int i = 0;
+    for (; i + V::N < count; i += V::N) {
+        auto c = add_121(column_sum(p0 + i), column_sum(p1 + i), column_sum(p2 + i));
+        V::Compact(c >> 4).store(d + i);
+    }
+    downsample_3_3<typename V::Scalar>(d + i, p0 + i, srcRB, count - i);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 SkMipmap::SkMipmap(void* malloc, size_t size) : SkCachedData(malloc, size) {}
@@ -401,147 +506,147 @@ size_t SkMipmap::AllocLevelsSize(int levelCount, size_t pixelSize) {
     return SkTo<int32_t>(size);
 }
 
-SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
-                          bool computeContents) {
-    typedef void FilterProc(void*, const void* srcPtr, size_t srcRB, int count);
+namespace {
 
-    FilterProc* proc_1_2 = nullptr;
-    FilterProc* proc_1_3 = nullptr;
-    FilterProc* proc_2_1 = nullptr;
-    FilterProc* proc_2_2 = nullptr;
-    FilterProc* proc_2_3 = nullptr;
-    FilterProc* proc_3_1 = nullptr;
-    FilterProc* proc_3_2 = nullptr;
-    FilterProc* proc_3_3 = nullptr;
+typedef void FilterProc(void*, const void* srcPtr, size_t srcRB, int count);
 
-    const SkColorType ct = src.colorType();
-    const SkAlphaType at = src.alphaType();
+struct FilterProcs {
+    FilterProc* f1_2 = nullptr;
+    FilterProc* f1_3 = nullptr;
+    FilterProc* f2_1 = nullptr;
+    FilterProc* f2_2 = nullptr;
+    FilterProc* f2_3 = nullptr;
+    FilterProc* f3_1 = nullptr;
+    FilterProc* f3_2 = nullptr;
+    FilterProc* f3_3 = nullptr;
+};
 
+bool choose_procs(SkColorType ct, FilterProcs* procs) {
     switch (ct) {
         case kRGBA_8888_SkColorType:
         case kBGRA_8888_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_8888>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_8888>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_8888>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_8888>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_8888>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_8888>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_8888>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_8888>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_8888>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_8888>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_8888>;
+            procs->f2_2 = downsample_2_2_vec<VecFilter_8888>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_8888>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_8888>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_8888>;
+            procs->f3_3 = downsample_3_3_vec<VecFilter_8888>;
             break;
         case kRGB_565_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_565>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_565>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_565>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_565>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_565>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_565>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_565>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_565>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_565>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_565>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_565>;
+            procs->f2_2 = downsample_2_2_vec<VecFilter_565>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_565>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_565>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_565>;
+            procs->f3_3 = downsample_3_3_vec<VecFilter_565>;
             break;
         case kARGB_4444_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_4444>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_4444>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_4444>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_4444>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_4444>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_4444>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_4444>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_4444>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_4444>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_4444>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_4444>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_4444>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_4444>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_4444>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_4444>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_4444>;
             break;
         case kAlpha_8_SkColorType:
         case kGray_8_SkColorType:
         case kR8_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_8>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_8>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_8>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_8>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_8>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_8>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_8>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_8>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_8>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_8>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_8>;
+            procs->f2_2 = downsample_2_2_vec<VecFilter_8>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_8>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_8>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_8>;
+            procs->f3_3 = downsample_3_3_vec<VecFilter_8>;
             break;
         case kRGBA_F16Norm_SkColorType:
         case kRGBA_F16_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_RGBA_F16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_RGBA_F16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_RGBA_F16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_RGBA_F16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_RGBA_F16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_RGBA_F16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_RGBA_F16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_RGBA_F16>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_RGBA_F16>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_RGBA_F16>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_RGBA_F16>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_RGBA_F16>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_RGBA_F16>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_RGBA_F16>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_RGBA_F16>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_RGBA_F16>;
             break;
         case kR8G8_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_88>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_88>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_88>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_88>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_88>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_88>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_88>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_88>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_88>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_88>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_88>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_88>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_88>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_88>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_88>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_88>;
             break;
         case kR16G16_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_1616>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_1616>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_1616>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_1616>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_1616>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_1616>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_1616>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_1616>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_1616>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_1616>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_1616>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_1616>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_1616>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_1616>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_1616>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_1616>;
             break;
         case kA16_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_16>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_16>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_16>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_16>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_16>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_16>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_16>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_16>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_16>;
             break;
         case kRGBA_1010102_SkColorType:
         case kBGRA_1010102_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_1010102>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_1010102>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_1010102>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_1010102>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_1010102>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_1010102>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_1010102>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_1010102>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_1010102>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_1010102>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_1010102>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_1010102>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_1010102>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_1010102>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_1010102>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_1010102>;
             break;
         case kA16_float_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_Alpha_F16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_Alpha_F16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_Alpha_F16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_Alpha_F16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_Alpha_F16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_Alpha_F16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_Alpha_F16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_Alpha_F16>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_Alpha_F16>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_Alpha_F16>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_Alpha_F16>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_Alpha_F16>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_Alpha_F16>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_Alpha_F16>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_Alpha_F16>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_Alpha_F16>;
             break;
         case kR16G16_float_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_F16F16>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_F16F16>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_F16F16>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_F16F16>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_F16F16>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_F16F16>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_F16F16>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_F16F16>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_F16F16>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_F16F16>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_F16F16>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_F16F16>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_F16F16>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_F16F16>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_F16F16>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_F16F16>;
             break;
         case kR16G16B16A16_unorm_SkColorType:
-            proc_1_2 = downsample_1_2<ColorTypeFilter_16161616>;
-            proc_1_3 = downsample_1_3<ColorTypeFilter_16161616>;
-            proc_2_1 = downsample_2_1<ColorTypeFilter_16161616>;
-            proc_2_2 = downsample_2_2<ColorTypeFilter_16161616>;
-            proc_2_3 = downsample_2_3<ColorTypeFilter_16161616>;
-            proc_3_1 = downsample_3_1<ColorTypeFilter_16161616>;
-            proc_3_2 = downsample_3_2<ColorTypeFilter_16161616>;
-            proc_3_3 = downsample_3_3<ColorTypeFilter_16161616>;
+            procs->f1_2 = downsample_1_2<ColorTypeFilter_16161616>;
+            procs->f1_3 = downsample_1_3<ColorTypeFilter_16161616>;
+            procs->f2_1 = downsample_2_1<ColorTypeFilter_16161616>;
+            procs->f2_2 = downsample_2_2<ColorTypeFilter_16161616>;
+            procs->f2_3 = downsample_2_3<ColorTypeFilter_16161616>;
+            procs->f3_1 = downsample_3_1<ColorTypeFilter_16161616>;
+            procs->f3_2 = downsample_3_2<ColorTypeFilter_16161616>;
+            procs->f3_3 = downsample_3_3<ColorTypeFilter_16161616>;
             break;
 
         case kUnknown_SkColorType:
@@ -550,10 +655,86 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
         case kBGR_101010x_SkColorType:  // TODO: use 1010102?
         case kBGR_101010x_XR_SkColorType:  // TODO: use 1010102?
         case kRGBA_F32_SkColorType:
-            return nullptr;
+            return false;
 
         case kSRGBA_8888_SkColorType:  // TODO: needs careful handling
-            return nullptr;
+            return false;
+    }
+    return true;
+}
+
+// Returns the filter for a level whose source (the previous level) is width x height.
+FilterProc* choose_proc(const FilterProcs& procs, int width, int height) {
+    if (height & 1) {
+        if (height == 1) {        // src-height is 1
+            if (width & 1) {      // src-width is 3
+                return procs.f3_1;
+            } else {              // src-width is 2
+                return procs.f2_1;
+            }
+        } else {                  // src-height is 3
+            if (width & 1) {
+                if (width == 1) { // src-width is 1
+                    return procs.f1_3;
+                } else {          // src-width is 3
+                    return procs.f3_3;
+                }
+            } else {              // src-width is 2
+                return procs.f2_3;
+            }
+        }
+    } else {                      // src-height is 2
+        if (width & 1) {
+            if (width == 1) {     // src-width is 1
+                return procs.f1_2;
+            } else {              // src-width is 3
+                return procs.f3_2;
+            }
+        } else {                  // src-width is 2
+            return procs.f2_2;
+        }
+    }
+}
+
+void filter_rows(FilterProc* proc, const SkPixmap& src, const SkPixmap& dst, int top, int bottom) {
+    const char* srcRow = (const char*)src.addr() + 2 * top * src.rowBytes();
+    char* dstRow = (char*)dst.writable_addr() + top * dst.rowBytes();
+    for (int y = top; y < bottom; y++) {
+        proc(dstRow, srcRow, src.rowBytes(), dst.width());
+        srcRow += src.rowBytes() * 2; // jump two rows
+        dstRow += dst.rowBytes();
+    }
+}
+
+// Levels are split into bands of rows for parallel filtering if each band then has at least this
+// many destination pixels.
+constexpr int kMinPixelsPerBand = 64 * 1024;
+constexpr int kMaxBands = 32;
+
+void filter_level(FilterProc* proc, const SkPixmap& src, const SkPixmap& dst,
+                  SkExecutor* executor) {
+    const int height = dst.height();
+    const int bands = (int)std::min<int64_t>({height, kMaxBands,
+                                              (int64_t)dst.width() * height / kMinPixelsPerBand});
+    if (!executor || bands < 2) {
+        filter_rows(proc, src, dst, 0, height);
+        return;
+    }
+    SkTaskGroup tasks(*executor);
+    tasks.batch(bands, [&](int band) {
+        filter_rows(proc, src, dst, band * height / bands, (band + 1) * height / bands);
+    });
+}
+
+}  // namespace
+
+SkMipmap* SkMipmap::Allocate(const SkPixmap& src, SkDiscardableFactoryProc fact) {
+    const SkColorType ct = src.colorType();
+    const SkAlphaType at = src.alphaType();
+
+    FilterProcs procs;
+    if (!choose_procs(ct, &procs)) {
+        return nullptr;
     }
 
     if (src.width() <= 1 && src.height() <= 1) {
@@ -595,43 +776,12 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
     int         width = src.width();
     int         height = src.height();
     uint32_t    rowBytes;
-    SkPixmap    srcPM(src);
 
     // Depending on architecture and other factors, the pixel data alignment may need to be as
     // large as 8 (for F16 pixels). See the comment on SkMipmap::Level.
     SkASSERT(SkIsAlign8((uintptr_t)addr));
 
     for (int i = 0; i < countLevels; ++i) {
-        FilterProc* proc;
-        if (height & 1) {
-            if (height == 1) {        // src-height is 1
-                if (width & 1) {      // src-width is 3
-                    proc = proc_3_1;
-                } else {              // src-width is 2
-                    proc = proc_2_1;
-                }
-            } else {                  // src-height is 3
-                if (width & 1) {
-                    if (width == 1) { // src-width is 1
-                        proc = proc_1_3;
-                    } else {          // src-width is 3
-                        proc = proc_3_3;
-                    }
-                } else {              // src-width is 2
-                    proc = proc_2_3;
-                }
-            }
-        } else {                      // src-height is 2
-            if (width & 1) {
-                if (width == 1) {     // src-width is 1
-                    proc = proc_1_2;
-                } else {              // src-width is 3
-                    proc = proc_3_2;
-                }
-            } else {                  // src-width is 2
-                proc = proc_2_2;
-            }
-        }
         width = std::max(1, width >> 1);
         height = std::max(1, height >> 1);
         rowBytes = SkToU32(SkColorTypeMinRowBytes(ct, width));
@@ -642,20 +792,6 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
         new (&levels[i].fPixmap) SkPixmap(SkImageInfo::Make(width, height, ct, at), addr, rowBytes);
         levels[i].fScale  = SkSize::Make(SkIntToScalar(width)  / src.width(),
                                          SkIntToScalar(height) / src.height());
-
-        const SkPixmap& dstPM = levels[i].fPixmap;
-        if (computeContents) {
-            const void* srcBasePtr = srcPM.addr();
-            void* dstBasePtr = dstPM.writable_addr();
-
-            const size_t srcRB = srcPM.rowBytes();
-            for (int y = 0; y < height; y++) {
-                proc(dstBasePtr, srcBasePtr, srcRB, width);
-                srcBasePtr = (char*)srcBasePtr + srcRB * 2; // jump two rows
-                dstBasePtr = (char*)dstBasePtr + dstPM.rowBytes();
-            }
-        }
-        srcPM = dstPM;
         addr += height * rowBytes;
     }
     SkASSERT(addr == baseAddr + size);
@@ -664,6 +800,40 @@ SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
     return mipmap;
 }
 
+void SkMipmap::buildLevels(const SkPixmap& base, int count) const {
+    FilterProcs procs;
+    SkAssertResult(choose_procs(fLevels[0].fPixmap.colorType(), &procs));
+
+    for (int i = fLevelsBuilt.load(std::memory_order_relaxed); i < count; ++i) {
+        const SkPixmap& srcPM = i == 0 ? base : fLevels[i - 1].fPixmap;
+        filter_level(choose_proc(procs, srcPM.width(), srcPM.height()), srcPM,
+                     fLevels[i].fPixmap, fExecutor);
+        fLevelsBuilt.store(i + 1, std::memory_order_release);
+    }
+}
+
+void SkMipmap::buildLazyLevels(int index) const {
+    SkAutoMutexExclusive lock(fLazyMutex);
+    if (index < fLevelsBuilt.load(std::memory_order_relaxed)) {
+        return;  // Another thread built it while we waited.
+    }
+    this->buildLevels(fLazySrc.pixmap(), index + 1);
+    // Every level after the first is filtered from the level before it.
+    fLazySrc.reset();
+}
+
+SkMipmap* SkMipmap::Build(const SkPixmap& src, SkDiscardableFactoryProc fact,
+                          bool computeContents) {
+    SkMipmap* mipmap = Allocate(src, fact);
+    if (mipmap) {
+        if (computeContents) {
+            mipmap->buildLevels(src, mipmap->fCount);
+        }
+        mipmap->fLevelsBuilt.store(mipmap->fCount, std::memory_order_relaxed);
+    }
+    return mipmap;
+}
+
 int SkMipmap::ComputeLevelCount(int baseWidth, int baseHeight) {
     if (baseWidth < 1 || baseHeight < 1) {
         return 0;
@@ -764,6 +934,9 @@ bool SkMipmap::extractLevel(SkSize scaleSize, Level* levelPtr) const {
     if (level > fCount) {
         level = fCount;
     }
+    if (level > fLevelsBuilt.load(std::memory_order_acquire)) {
+        this->buildLazyLevels(level - 1);
+    }
     if (levelPtr) {
         *levelPtr = fLevels[level - 1];
         // need to augment with our colorspace
@@ -806,6 +979,26 @@ SkMipmap* SkMipmap::Build(const SkBitmap& src, SkDiscardableFactoryProc fact) {
     return Build(srcPixmap, fact);
 }
 
+SkMipmap* SkMipmap::Build(const SkBitmap& src, SkDiscardableFactoryProc fact,
+                          const BuildOptions& options) {
+    SkPixmap srcPixmap;
+    if (!src.peekPixels(&srcPixmap)) {
+        return nullptr;
+    }
+    SkMipmap* mipmap = Allocate(srcPixmap, fact);
+    if (!mipmap) {
+        return nullptr;
+    }
+    mipmap->fExecutor = options.fExecutor;
+    if (options.fLazy) {
+        SkAutoMutexExclusive lock(mipmap->fLazyMutex);
+        mipmap->fLazySrc = src;
+    } else {
+        mipmap->buildLevels(srcPixmap, mipmap->fCount);
+    }
+    return mipmap;
+}
+
 int SkMipmap::countLevels() const {
     return fCount;
 }
@@ -820,6 +1013,9 @@ bool SkMipmap::getLevel(int index, Level* levelPtr) const {
     if (index > fCount - 1) {
         return false;
     }
+    if (index >= fLevelsBuilt.load(std::memory_order_acquire)) {
+        this->buildLazyLevels(index);
+    }
     if (levelPtr) {
         *levelPtr = fLevels[index];
         // need to augment with our colorspace
@@ -8,16 +8,20 @@
 #ifndef SkMipmap_DEFINED
 #define SkMipmap_DEFINED
 
+#include "include/core/SkBitmap.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkSize.h"
+#include "include/private/base/SkMutex.h"
 #include "src/core/SkCachedData.h"
 #include "src/core/SkImageInfoPriv.h"
 #include "src/shaders/SkShaderBase.h"
 
-class SkBitmap;
+#include <atomic>
+
 class SkData;
 class SkDiscardableMemory;
+class SkExecutor;
 class SkMipmapBuilder;
 
 typedef SkDiscardableMemory* (*SkDiscardableFactoryProc)(size_t bytes);
@@ -39,6 +43,17 @@ public:
 
     static SkMipmap* Build(const SkBitmap& src, SkDiscardableFactoryProc);
 
+    struct BuildOptions {
+        // If not null, the rows of large levels are filtered in parallel on this executor.
+        SkExecutor* fExecutor = nullptr;
+
+        // If true, a level is only filtered (along with any larger levels it is filtered from)
+        // when getLevel() or extractLevel() first returns it, by the caller and under a lock. The
+        // mipmap refs the pixels of |src| until the first level has been filtered.
+        bool fLazy = false;
+    };
+    static SkMipmap* Build(const SkBitmap& src, SkDiscardableFactoryProc, const BuildOptions&);
+
     // Determines how many levels a SkMipmap will have without creating that mipmap.
     // This does not include the base mipmap level that the user provided when
     // creating the SkMipmap.
@@ -84,10 +99,26 @@ private:
     Level*              fLevels;    // managed by the baseclass, may be null due to onDataChanged.
     int                 fCount;
 
+    // The levels below fLevelsBuilt have been filtered. The others are filtered on demand, under
+    // fLazyMutex: the first from fLazySrc, which is then released, and the rest from each other.
+    mutable std::atomic<int> fLevelsBuilt{0};
+    mutable SkMutex          fLazyMutex;
+    mutable SkBitmap         fLazySrc SK_GUARDED_BY(fLazyMutex);
+    SkExecutor*              fExecutor = nullptr;
+
     SkMipmap(void* malloc, size_t size);
     SkMipmap(size_t size, SkDiscardableMemory* dm);
 
     static size_t AllocLevelsSize(int levelCount, size_t pixelSize);
+
+    // Allocates a mipmap for |src| and lays out its levels, without filtering any of them.
+    static SkMipmap* Allocate(const SkPixmap& src, SkDiscardableFactoryProc);
+
+    // Filters levels [fLevelsBuilt, count) from |base| and the levels before them.
+    void buildLevels(const SkPixmap& base, int count) const;
+
+    // Makes sure the level at |index| has been filtered.
+    void buildLazyLevels(int index) const;
 };
 
 #endif
@@ -61,6 +61,9 @@ namespace SkOpts {
     DEFINE_DEFAULT(gray_to_RGB1);
     DEFINE_DEFAULT(grayA_to_RGBA);
     DEFINE_DEFAULT(grayA_to_rgbA);
+    DEFINE_DEFAULT(alpha_to_000A);
+    DEFINE_DEFAULT(F16_to_RGBA);
+    DEFINE_DEFAULT(F16_to_BGRA);
     DEFINE_DEFAULT(inverted_CMYK_to_RGB1);
     DEFINE_DEFAULT(inverted_CMYK_to_BGR1);
 
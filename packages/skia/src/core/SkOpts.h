@@ -89,7 +89,12 @@ namespace SkOpts {
                            RGB_to_BGR1,     // i.e. swap RB and insert an opaque alpha
                            gray_to_RGB1,    // i.e. expand to color channels + an opaque alpha
                            grayA_to_RGBA,   // i.e. expand to color channels
-                           grayA_to_rgbA;   // i.e. expand to color channels and premultiply
+                           grayA_to_rgbA,   // i.e. expand to color channels and premultiply
+                           alpha_to_000A;   // i.e. expand to an alpha channel with no color
+
+    typedef void (*Swizzle_8888_u64)(uint32_t*, const uint64_t*, int);
+    extern Swizzle_8888_u64 F16_to_RGBA,    // i.e. clamp and round each channel to 8 bits
+                            F16_to_BGRA;    // i.e. clamp, round and swap RB
 
     extern void (*memset16)(uint16_t[], uint16_t, int);
     extern void (*memset32)(uint32_t[], uint32_t, int);
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkPictureAnalysis.h"
+
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPicture.h"
+#include "include/private/base/SkTemplates.h"
+#include "include/private/base/SkTo.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkBlenderBase.h"
+#include "src/core/SkColorFilterBase.h"
+#include "src/core/SkPictureData.h"
+#include "src/core/SkPicturePlayback.h"
+#include "src/core/SkPicturePriv.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+#include "src/shaders/SkShaderBase.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+using namespace SkRecords;
+
+namespace {
+
+double area(const SkRect& r) {
+    return r.isEmpty() ? 0 : (double)r.width() * (double)r.height();
+}
+
+bool uses_runtime_effect(const SkPaint& paint) {
+    return (paint.getShader()      && as_SB(paint.getShader())->asRuntimeEffect())       ||
+           (paint.getColorFilter() && as_CFB(paint.getColorFilter())->asRuntimeEffect()) ||
+           (paint.getBlender()     && as_BB(paint.getBlender())->asRuntimeEffect());
+}
+
+// Walks the record alongside the per-op bounds computed by SkRecordFillBounds.
+class Analyzer {
+public:
+    Analyzer(SkPictureAnalysis* out, const SkRect bounds[]) : fOut(out), fBounds(bounds) {}
+
+    void setCurrentOp(int index) { fCurrentOp = index; }
+
+    template <typename T> void operator()(const T& op) {
+        this->updateCTM(op);
+        fOut->fOpCount++;
+        fOut->fOpCounts[T::kType]++;
+
+        const SkRect& bounds = fBounds[fCurrentOp];
+        if (const SkPaint* paint = PaintOf(op)) {
+            if (paint->getImageFilter()) {
+                fOut->fImageFilters++;
+                fOut->fImageFilterArea += area(bounds);
+            }
+            if (uses_runtime_effect(*paint)) {
+                fOut->fRuntimeEffects++;
+                fOut->fRuntimeEffectArea += area(bounds);
+            }
+        }
+        if (T::kTags & kDraw_Tag) {
+            fOut->fDrawCount++;
+            fOut->fCoveredPixels += area(bounds);
+            this->accumulateOverdraw(bounds);
+        }
+        this->track(op, bounds);
+    }
+
+private:
+    // Abstracts away whether the paint is always part of the command or optional.
+    static const SkPaint* AsPtr(const Optional<SkPaint>& x) { return x; }
+    static const SkPaint* AsPtr(const SkPaint& x) { return &x; }
+
+    template <typename T>
+    static std::enable_if_t<(T::kTags & kHasPaint_Tag) != 0, const SkPaint*>
+    PaintOf(const T& op) { return AsPtr(op.paint); }
+
+    template <typename T>
+    static std::enable_if_t<(T::kTags & kHasPaint_Tag) == 0, const SkPaint*>
+    PaintOf(const T&) { return nullptr; }
+
+    // Mirrors SkRecords::FillBounds, so that clips, which it does not bound, can be mapped to
+    // picture space too.
+    template <typename T> void updateCTM(const T&) {}
+    void updateCTM(const Restore& op)   { fCTM = op.matrix; }
+    void updateCTM(const SetMatrix& op) { fCTM = op.matrix; }
+    void updateCTM(const SetM44& op)    { fCTM = op.matrix.asM33(); }
+    void updateCTM(const Concat44& op)  { fCTM.preConcat(op.matrix.asM33()); }
+    void updateCTM(const Concat& op)    { fCTM.preConcat(op.matrix); }
+    void updateCTM(const Scale& op)     { fCTM.preScale(op.sx, op.sy); }
+    void updateCTM(const Translate& op) { fCTM.preTranslate(op.dx, op.dy); }
+
+    // The picture-space bounds of local geometry, clamped to the cull rect.
+    SkRect mapToCull(const SkRect& local) const {
+        SkRect bounds = fCTM.mapRect(local);
+        return bounds.intersect(fOut->fCullRect) ? bounds : SkRect::MakeEmpty();
+    }
+
+    template <typename T> void track(const T&, const SkRect&) {}
+
+    void track(const SaveLayer& op, const SkRect& bounds) {
+        fOut->fSaveLayers++;
+        fOut->fSaveLayerArea += area(bounds);
+        if (op.backdrop) {
+            fOut->fImageFilters++;
+            fOut->fImageFilterArea += area(bounds);
+        }
+    }
+    void track(const ClipPath& op, const SkRect&) {
+        fOut->fComplexClips++;
+        if (op.opAA.aa()) {
+            fOut->fAAPaths++;
+            // An inverse fill covers everything outside the path, i.e. up to the whole cull.
+            fOut->fAAPathArea += area(op.path.isInverseFillType()
+                                              ? fOut->fCullRect
+                                              : this->mapToCull(op.path.getBounds()));
+        }
+    }
+    void track(const ClipRRect& op, const SkRect&) {
+        if (!op.rrect.isRect() || op.opAA.op() == SkClipOp::kDifference) {
+            fOut->fComplexClips++;
+        }
+    }
+    void track(const ClipRect& op, const SkRect&) {
+        if (op.opAA.op() == SkClipOp::kDifference) {
+            fOut->fComplexClips++;
+        }
+    }
+    void track(const ClipRegion& op, const SkRect&) {
+        if (op.region.isComplex() || op.op == SkClipOp::kDifference) {
+            fOut->fComplexClips++;
+        }
+    }
+    void track(const ClipShader&, const SkRect&) { fOut->fComplexClips++; }
+    void track(const DrawPath& op, const SkRect& bounds) {
+        if (op.paint.isAntiAlias() && !op.path.isRect(nullptr)) {
+            fOut->fAAPaths++;
+            fOut->fAAPathArea += area(bounds);
+        }
+    }
+    void track(const DrawPicture&, const SkRect&) { fOut->fNestedPictures++; }
+
+    void accumulateOverdraw(const SkRect& bounds) {
+        if (bounds.isEmpty() || fOut->fOverdraw.empty()) {
+            return;
+        }
+        const SkRect& cull = fOut->fCullRect;
+        const float inv = 1.0f / fOut->fCellSize;
+        int l = std::max(0, (int)std::floor((bounds.fLeft   - cull.fLeft) * inv));
+        int t = std::max(0, (int)std::floor((bounds.fTop    - cull.fTop)  * inv));
+        int r = std::min(fOut->fGridColumns, (int)std::ceil((bounds.fRight  - cull.fLeft) * inv));
+        int b = std::min(fOut->fGridRows,    (int)std::ceil((bounds.fBottom - cull.fTop)  * inv));
+        for (int y = t; y < b; ++y) {
+            uint16_t* row = fOut->fOverdraw.data() + y * fOut->fGridColumns;
+            for (int x = l; x < r; ++x) {
+                if (row[x] != UINT16_MAX) {
+                    row[x]++;
+                }
+            }
+        }
+    }
+
+    SkPictureAnalysis* fOut;
+    const SkRect*      fBounds;
+    int                fCurrentOp = 0;
+    SkMatrix           fCTM = SkMatrix::I();
+};
+
+}  // namespace
+
+SkPictureAnalysis SkPictureAnalysis::Analyze(const SkRecord& record,
+                                             const SkRect& cullRect,
+                                             const Options& options) {
+    SkPictureAnalysis analysis;
+    analysis.fCullRect = cullRect;
+
+    if (!cullRect.isEmpty() && cullRect.isFinite()) {
+        const int maxCells = std::max(1, options.fMaxCellsPerSide);
+        const SkScalar longest = std::max(cullRect.width(), cullRect.height());
+        analysis.fCellSize = std::max(options.fCellSize > 0 ? options.fCellSize : 1,
+                                      longest / maxCells);
+        analysis.fGridColumns = SkTPin((int)std::ceil(cullRect.width()  / analysis.fCellSize),
+                                      1, maxCells);
+        analysis.fGridRows    = SkTPin((int)std::ceil(cullRect.height() / analysis.fCellSize),
+                                      1, maxCells);
+        analysis.fOverdraw.resize(analysis.fGridColumns * analysis.fGridRows, 0);
+    }
+
+    // FillBounds gives us conservative picture-space bounds for every op, adjusted for paints and
+    // the layers they're drawn into, which is exactly what coverage and area estimates want.
+    skia_private::AutoTArray<SkRect> bounds(record.count());
+    skia_private::AutoTArray<SkBBoxHierarchy::Metadata> meta(record.count());
+    SkRecordFillBounds(cullRect, record, bounds.data(), meta.data());
+
+    Analyzer analyzer(&analysis, bounds.data());
+    for (int i = 0; i < record.count(); i++) {
+        analyzer.setCurrentOp(i);
+        record.visit(i, analyzer);
+    }
+    return analysis;
+}
+
+SkPictureAnalysis SkPictureAnalysis::Analyze(const SkPicture& picture, const Options& options) {
+    if (const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(sk_ref_sp(&picture))) {
+        return Analyze(*big->record(), picture.cullRect(), options);
+    }
+    SkRecord record;
+    SkRecorder recorder(&record, picture.cullRect());
+    picture.playback(&recorder);
+    return Analyze(record, picture.cullRect(), options);
+}
+
+SkPictureAnalysis SkPictureAnalysis::Analyze(const SkPictureData& data,
+                                             const SkRect& cullRect,
+                                             const Options& options) {
+    SkRecord record;
+    SkRecorder recorder(&record, cullRect);
+    SkPicturePlayback playback(&data);
+    playback.draw(&recorder, nullptr, nullptr);
+    return Analyze(record, cullRect, options);
+}
+
+const char* SkPictureAnalysis::OpName(int type) {
+#define SK_PICTURE_ANALYSIS_NAME(T) #T,
+    static const char* kNames[] = { SK_RECORD_TYPES(SK_PICTURE_ANALYSIS_NAME) };
+#undef SK_PICTURE_ANALYSIS_NAME
+    return 0 <= type && type < kOpTypeCount ? kNames[type] : "Unknown";
+}
+
+int SkPictureAnalysis::maxOverdraw() const {
+    return fOverdraw.empty() ? 0 : *std::max_element(fOverdraw.begin(), fOverdraw.end());
+}
+
+double SkPictureAnalysis::averageOverdraw() const {
+    double sum = 0;
+    int touched = 0;
+    for (uint16_t n : fOverdraw) {
+        if (n) {
+            sum += n;
+            touched++;
+        }
+    }
+    return touched ? sum / touched : 0;
+}
+
+double SkPictureAnalysis::estimateCostNs(const SkPictureCostModel& model) const {
+    return fOpCount           * model.fPerOpNs +
+           fCoveredPixels     * model.fPerPixelNs +
+           fAAPathArea        * model.fAAPathPerPixelNs +
+           fSaveLayerArea     * model.fSaveLayerPerPixelNs +
+           fImageFilterArea   * model.fImageFilterPerPixelNs +
+           fRuntimeEffectArea * model.fRuntimeEffectPerPixelNs +
+           fComplexClips      * model.fComplexClipNs;
+}
+
+SkPictureCostModel SkPictureCostModel::Make(Backend backend) {
+    // Order-of-magnitude defaults.  Real schedulers should calibrate() against their own devices.
+    switch (backend) {
+        case Backend::kRaster:
+            return { /*fPerOpNs=*/                 150,
+                     /*fPerPixelNs=*/              0.4,
+                     /*fAAPathPerPixelNs=*/        1.5,
+                     /*fSaveLayerPerPixelNs=*/     1.0,
+                     /*fImageFilterPerPixelNs=*/   8.0,
+                     /*fRuntimeEffectPerPixelNs=*/ 6.0,
+                     /*fComplexClipNs=*/           2000 };
+        case Backend::kGPU:
+            return { /*fPerOpNs=*/                 600,
+                     /*fPerPixelNs=*/              0.01,
+                     /*fAAPathPerPixelNs=*/        0.05,
+                     /*fSaveLayerPerPixelNs=*/     0.05,
+                     /*fImageFilterPerPixelNs=*/   0.2,
+                     /*fRuntimeEffectPerPixelNs=*/ 0.05,
+                     /*fComplexClipNs=*/           5000 };
+    }
+    SkUNREACHABLE;
+}
+
+namespace {
+
+// The features each SkPictureCostModel coefficient multiplies, in the same order as
+// coefficients().
+std::array<double, SkPictureCostModel::kCoefficientCount> features(const SkPictureAnalysis& a) {
+    return {(double)a.fOpCount, a.fCoveredPixels, a.fAAPathArea, a.fSaveLayerArea,
+            a.fImageFilterArea, a.fRuntimeEffectArea, (double)a.fComplexClips};
+}
+
+// Solves the N x N system A x = b in place by Gaussian elimination with partial pivoting.
+// Returns false if A is singular.
+template <int N>
+bool solve(double A[N][N], double b[N], double x[N]) {
+    for (int col = 0; col < N; ++col) {
+        int pivot = col;
+        for (int row = col + 1; row < N; ++row) {
+            if (std::fabs(A[row][col]) > std::fabs(A[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (A[pivot][col] == 0) {
+            return false;
+        }
+        std::swap(A[col], A[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (int row = col + 1; row < N; ++row) {
+            const double f = A[row][col] / A[col][col];
+            for (int k = col; k < N; ++k) {
+                A[row][k] -= f * A[col][k];
+            }
+            b[row] -= f * b[col];
+        }
+    }
+    for (int row = N - 1; row >= 0; --row) {
+        double sum = b[row];
+        for (int k = row + 1; k < N; ++k) {
+            sum -= A[row][k] * x[k];
+        }
+        x[row] = sum / A[row][row];
+    }
+    return true;
+}
+
+}  // namespace
+
+std::array<double*, SkPictureCostModel::kCoefficientCount> SkPictureCostModel::coefficients() {
+    return {&fPerOpNs, &fPerPixelNs, &fAAPathPerPixelNs, &fSaveLayerPerPixelNs,
+            &fImageFilterPerPixelNs, &fRuntimeEffectPerPixelNs, &fComplexClipNs};
+}
+
+void SkPictureCostModel::calibrate(const SkPictureAnalysis analyses[],
+                                   const double measuredNs[],
+                                   int count) {
+    constexpr int N = kCoefficientCount;
+    // How strongly each coefficient is held to its current value, relative to fitting one sample
+    // exactly.  Any amount keeps the features that no sample exercises where they are; a small
+    // one lets the samples that do exercise a feature move its coefficient almost freely.
+    constexpr double kPrior = 1e-4;
+
+    // Fit a multiplier m_j per coefficient c_j, minimizing the relative error of every estimate
+    //   sum_i ((sum_j m_j c_j f_ij - y_i) / y_i)^2 + kPrior sum_j (m_j - 1)^2,
+    // so that large and small pictures weigh the same.
+    std::array<double*, N> c = this->coefficients();
+    double AtA[N][N] = {}, Atb[N] = {};
+    int samples = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!(measuredNs[i] > 0)) {
+            continue;
+        }
+        const std::array<double, N> f = features(analyses[i]);
+        double row[N];
+        for (int j = 0; j < N; ++j) {
+            row[j] = *c[j] * f[j] / measuredNs[i];
+        }
+        for (int j = 0; j < N; ++j) {
+            for (int k = 0; k < N; ++k) {
+                AtA[j][k] += row[j] * row[k];
+            }
+            Atb[j] += row[j];
+        }
+        samples++;
+    }
+    if (samples == 0) {
+        return;
+    }
+    for (int j = 0; j < N; ++j) {
+        AtA[j][j] += kPrior;
+        Atb[j]    += kPrior;
+    }
+
+    double m[N];
+    if (!solve<N>(AtA, Atb, m)) {
+        return;
+    }
+    for (int j = 0; j < N; ++j) {
+        // A negative cost is never right; it means the samples cannot tell this feature apart
+        // from the others.  Keep a little of it rather than dropping it altogether.
+        *c[j] *= std::max(m[j], 0.05);
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureAnalysis_DEFINED
+#define SkPictureAnalysis_DEFINED
+
+#include "include/core/SkRect.h"
+#include "include/core/SkScalar.h"
+#include "src/core/SkRecords.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class SkPicture;
+class SkPictureData;
+class SkRecord;
+struct SkPictureAnalysis;
+
+// Per-backend coefficients used to turn an SkPictureAnalysis into an estimated cost.  The defaults
+// are coarse; schedulers that care should calibrate them against measured playbacks with
+// calibrate().
+struct SkPictureCostModel {
+    enum class Backend {
+        kRaster,  // single threaded SkBitmapDevice
+        kGPU,
+    };
+
+    double fPerOpNs;                   // fixed dispatch cost of any op
+    double fPerPixelNs;                // per covered pixel of a simple fill
+    double fAAPathPerPixelNs;          // extra, per pixel of anti-aliased path bounds
+    double fSaveLayerPerPixelNs;       // allocating, clearing and compositing a layer
+    double fImageFilterPerPixelNs;     // applying an image filter (layer or paint)
+    double fRuntimeEffectPerPixelNs;   // extra, per pixel drawn with a runtime effect
+    double fComplexClipNs;             // per non-rectangular clip
+
+    static constexpr int kCoefficientCount = 7;
+
+    static SkPictureCostModel Make(Backend);
+
+    // Fits each coefficient to `count` pictures and their measured playback times, by least squares
+    // on the relative error of the estimates.  Coefficients are pulled towards their current
+    // values, so features that none of the pictures exercise keep them; pictures that differ in
+    // what they do (paths vs. layers vs. filters, ...) are what tell the coefficients apart.
+    void calibrate(const SkPictureAnalysis analyses[], const double measuredNs[], int count);
+
+private:
+    std::array<double*, kCoefficientCount> coefficients();
+};
+
+// A summary of what a picture does, computed in one pass over its SkRecord.  All areas are in
+// picture space and clamped to the picture's cull rect.
+struct SkPictureAnalysis {
+#define SK_PICTURE_ANALYSIS_COUNT(T) +1
+    static constexpr int kOpTypeCount = 0 SK_RECORD_TYPES(SK_PICTURE_ANALYSIS_COUNT);
+#undef SK_PICTURE_ANALYSIS_COUNT
+
+    struct Options {
+        // Size, in picture-space units, of each cell of the overdraw grid.
+        SkScalar fCellSize = 32;
+        // Grids are capped at this many cells per side; the cell size grows to fit.
+        int fMaxCellsPerSide = 256;
+    };
+
+    static SkPictureAnalysis Analyze(const SkRecord&, const SkRect& cullRect, const Options&);
+    // Pictures that are not backed by an SkRecord are re-recorded first.
+    static SkPictureAnalysis Analyze(const SkPicture&, const Options&);
+    static SkPictureAnalysis Analyze(const SkPictureData&, const SkRect& cullRect,
+                                     const Options&);
+
+    static const char* OpName(int type);
+
+    double estimateCostNs(const SkPictureCostModel&) const;
+
+    int    fOpCount = 0;
+    int    fOpCounts[kOpTypeCount] = {};
+    int    fDrawCount = 0;
+
+    // Expensive features.
+    int    fSaveLayers = 0;
+    int    fImageFilters = 0;         // on layers, backdrops and draw paints
+    int    fComplexClips = 0;         // path, rrect, region, shader and difference clips
+    int    fRuntimeEffects = 0;       // paints using a runtime shader, color filter or blender
+    int    fAAPaths = 0;
+    int    fNestedPictures = 0;
+
+    double fCoveredPixels = 0;        // sum of the bounds of every draw
+    double fAAPathArea = 0;
+    double fSaveLayerArea = 0;
+    double fImageFilterArea = 0;
+    double fRuntimeEffectArea = 0;
+
+    // Overdraw map: the number of draws whose bounds touch each cell, row-major.
+    SkRect                fCullRect = SkRect::MakeEmpty();
+    SkScalar              fCellSize = 0;
+    int                   fGridColumns = 0;
+    int                   fGridRows = 0;
+    std::vector<uint16_t> fOverdraw;
+
+    int    maxOverdraw() const;
+    // Average number of draws touching each cell that is touched at all.
+    double averageOverdraw() const;
+};
+
+#endif  // SkPictureAnalysis_DEFINED
@@ -90,6 +90,27 @@ struct SkRasterPipeline_MipmapCtx {
     float lowerWeight;
 };
 
+// State used by yuva_init, yuva_store and yuva_finish
+struct SkRasterPipeline_YUVACtx {
+    // Image coords, saved before any plane is sampled
+    float x[SkRasterPipeline_kMaxStride_highp];
+    float y[SkRasterPipeline_kMaxStride_highp];
+
+    // Y, U, V and A, as sampled from their planes
+    float yuva[4][SkRasterPipeline_kMaxStride_highp];
+
+    // YUV to RGB, as from SkColorMatrix_YUV2RGB(). Alpha is passed through.
+    float matrix[20];
+};
+
+// State used by yuva_store for one plane of a YUVA image
+struct SkRasterPipeline_YUVAPlaneCtx {
+    SkRasterPipeline_YUVACtx* yuva;
+
+    // For each of r, g, b and a, the YUVA channel it holds once the plane is sampled, or -1.
+    int channel[4];
+};
+
 struct SkRasterPipeline_CoordClampCtx {
     float min_x, min_y;
     float max_x, max_y;
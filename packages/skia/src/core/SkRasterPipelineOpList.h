@@ -193,6 +193,7 @@
     M(bicubic_n3y) M(bicubic_n1y) M(bicubic_p1y) M(bicubic_p3y)                \
     M(accumulate)                                                              \
     M(mipmap_linear_init) M(mipmap_linear_update) M(mipmap_linear_finish)      \
+    M(yuva_init) M(yuva_store) M(yuva_finish)                                  \
     M(xy_to_2pt_conical_strip)                                                 \
     M(xy_to_2pt_conical_focal_on_circle)                                       \
     M(xy_to_2pt_conical_well_behaved)                                          \
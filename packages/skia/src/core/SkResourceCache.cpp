@@ -16,6 +16,8 @@
 #include "src/core/SkMessageBus.h"
 #include "src/core/SkMipmap.h"
 
+#include <algorithm>
+#include <atomic>
 #include <stddef.h>
 #include <stdlib.h>
 
@@ -41,6 +43,12 @@ static inline bool SkShouldPostMessageToBus(
     #define SK_DEFAULT_IMAGE_CACHE_LIMIT     (32 * 1024 * 1024)
 #endif
 
+// The number of independently locked shards the global cache is split into. 1 puts every Rec
+// behind a single mutex.
+#ifndef SK_RESOURCE_CACHE_SHARD_COUNT
+    #define SK_RESOURCE_CACHE_SHARD_COUNT    16
+#endif
+
 void SkResourceCache::Key::init(void* nameSpace, uint64_t sharedID, size_t dataSize) {
     SkASSERT(SkAlign4(dataSize) == dataSize);
 
@@ -83,6 +91,7 @@ class SkResourceCache::Hash :
 void SkResourceCache::init() {
     fHead = nullptr;
     fTail = nullptr;
+    fPurgeCursor = nullptr;
     fHash = new Hash;
     fTotalBytesUsed = 0;
     fCount = 0;
@@ -229,6 +238,18 @@ void SkResourceCache::purgeAsNeeded(bool forcePurge) {
     }
 }
 
+bool SkResourceCache::purgeOldest(bool resume) {
+    for (Rec* rec = resume ? fPurgeCursor : fTail; rec; rec = rec->fPrev) {
+        if (rec->canBePurged()) {
+            fPurgeCursor = rec->fPrev;
+            this->remove(rec);
+            return true;
+        }
+    }
+    fPurgeCursor = nullptr;
+    return false;
+}
+
 //#define SK_TRACK_PURGE_SHAREDID_HITRATE
 
 #ifdef SK_TRACK_PURGE_SHAREDID_HITRATE
@@ -311,6 +332,10 @@ void SkResourceCache::release(Rec* rec) {
     Rec* prev = rec->fPrev;
     Rec* next = rec->fNext;
 
+    if (fPurgeCursor == rec) {
+        fPurgeCursor = prev;
+    }
+
     if (!prev) {
         SkASSERT(fHead == rec);
         fHead = next;
@@ -454,94 +479,233 @@ void SkResourceCache::checkMessages() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static SkResourceCache* gResourceCache = nullptr;
-static SkMutex& resource_cache_mutex() {
-    static SkMutex& mutex = *(new SkMutex);
-    return mutex;
-}
+// The global cache is split into shards by key hash, each an SkResourceCache behind its own mutex,
+// so that threads finding and adding different keys rarely contend. Each shard keeps its own LRU
+// list, while the budget applies to all of them together: every locked access to a shard adds its
+// change in usage to global totals, and whoever takes the totals over budget evicts the least
+// recently used Rec of each shard in turn until they are back under. The accounting is
+// approximate in that other threads may take the totals over budget (or back under) while a
+// thread is evicting, and in that eviction only follows each shard's LRU order, not a global one.
+namespace {
+
+constexpr int kShardCount = SK_RESOURCE_CACHE_SHARD_COUNT;
+static_assert(kShardCount > 0, "SK_RESOURCE_CACHE_SHARD_COUNT must be positive");
+
+struct Shard {
+    SkMutex          fMutex;
+    SkResourceCache* fCache SK_GUARDED_BY(fMutex) = nullptr;
+
+    // For DumpMemoryStatistics().
+    uint64_t         fHits SK_GUARDED_BY(fMutex) = 0;
+    uint64_t         fMisses SK_GUARDED_BY(fMutex) = 0;
+};
 
-/** Must hold resource_cache_mutex() when calling. */
-static SkResourceCache* get_cache() {
-    // resource_cache_mutex() is always held when this is called, so we don't need to be fancy in here.
-    resource_cache_mutex().assertHeld();
-    if (nullptr == gResourceCache) {
+struct GlobalCache {
+    GlobalCache() {
 #ifdef SK_USE_DISCARDABLE_SCALEDIMAGECACHE
-        gResourceCache = new SkResourceCache(SkDiscardableMemory::Create);
+        fDiscardableFactory = SkDiscardableMemory::Create;
+        fTotalByteLimit = 0;
 #else
-        gResourceCache = new SkResourceCache(SK_DEFAULT_IMAGE_CACHE_LIMIT);
+        fDiscardableFactory = nullptr;
+        fTotalByteLimit = SK_DEFAULT_IMAGE_CACHE_LIMIT;
 #endif
+        for (Shard& shard : fShards) {
+            SkAutoMutexExclusive lock(shard.fMutex);
+            // Each shard is also limited to the whole budget, so that it never grows past it
+            // between checks of the totals.
+            shard.fCache = fDiscardableFactory
+                                   ? new SkResourceCache(fDiscardableFactory)
+                                   : new SkResourceCache(fTotalByteLimit.load());
+        }
+    }
+
+    bool overBudget() const {
+        if (fDiscardableFactory) {
+            return fCount.load(std::memory_order_relaxed) >=
+                   SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
+        }
+        return fTotalBytesUsed.load(std::memory_order_relaxed) >=
+               fTotalByteLimit.load(std::memory_order_relaxed);
     }
-    return gResourceCache;
+
+    Shard                                fShards[kShardCount];
+    SkResourceCache::DiscardableFactory  fDiscardableFactory;
+
+    std::atomic<size_t>                  fTotalBytesUsed{0};
+    std::atomic<int>                     fCount{0};
+    std::atomic<size_t>                  fTotalByteLimit;
+    std::atomic<size_t>                  fSingleAllocationByteLimit{0};
+
+    // The shard the next eviction starts from, so that evictions are spread over all of them.
+    std::atomic<uint32_t>                fNextEviction{0};
+};
+
+GlobalCache& global_cache() {
+    static GlobalCache* cache = new GlobalCache;
+    return *cache;
 }
 
+Shard& shard_for(uint32_t hash) {
+    return global_cache().fShards[hash % kShardCount];
+}
+
+// Locks a shard, and adds its change in usage to the global totals when done.
+class ShardAccess {
+public:
+    explicit ShardAccess(Shard& shard)
+            : fShard(shard)
+            , fAutoAcquire(shard.fMutex)
+            , fBytesUsed(shard.fCache->getTotalBytesUsed())
+            , fCount(shard.fCache->getCount()) {}
+
+    ~ShardAccess() {
+        fShard.fMutex.assertHeld();
+        GlobalCache& global = global_cache();
+        // Unsigned wrap-around makes this correct when the shard shrinks, too.
+        global.fTotalBytesUsed.fetch_add(fShard.fCache->getTotalBytesUsed() - fBytesUsed,
+                                         std::memory_order_relaxed);
+        global.fCount.fetch_add(fShard.fCache->getCount() - fCount, std::memory_order_relaxed);
+    }
+
+    SkResourceCache* operator->() const {
+        fShard.fMutex.assertHeld();
+        return fShard.fCache;
+    }
+
+    Shard& shard() const {
+        fShard.fMutex.assertHeld();
+        return fShard;
+    }
+
+private:
+    Shard&               fShard;
+    SkAutoMutexExclusive fAutoAcquire;
+    const size_t         fBytesUsed;
+    const int            fCount;
+};
+
+// Must not be called with any shard locked.
+void purge_as_needed() {
+    GlobalCache& global = global_cache();
+    // Each shard's first eviction starts from its oldest Rec, and later ones carry on from there,
+    // so that Recs in use are not scanned again for every eviction.
+    bool resume[kShardCount] = {};
+    while (global.overBudget()) {
+        bool purged = false;
+        for (int i = 0; i < kShardCount && global.overBudget(); ++i) {
+            const uint32_t index =
+                    global.fNextEviction.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+            purged |= ShardAccess(global.fShards[index])->purgeOldest(resume[index]);
+            resume[index] = true;
+        }
+        if (!purged) {
+            // Whatever is left is in use.
+            break;
+        }
+    }
+}
+
+template <typename Fn>
+void for_each_shard(Fn&& fn) {
+    for (Shard& shard : global_cache().fShards) {
+        ShardAccess access(shard);
+        fn(access);
+    }
+}
+
+}  // namespace
+
 size_t SkResourceCache::GetTotalBytesUsed() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getTotalBytesUsed();
+    return global_cache().fTotalBytesUsed.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::GetTotalByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getTotalByteLimit();
+    return global_cache().fTotalByteLimit.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::SetTotalByteLimit(size_t newLimit) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->setTotalByteLimit(newLimit);
+    GlobalCache& global = global_cache();
+    size_t prevLimit = global.fTotalByteLimit.exchange(newLimit);
+    for_each_shard([newLimit](const ShardAccess& shard) { shard->setTotalByteLimit(newLimit); });
+    if (newLimit < prevLimit) {
+        purge_as_needed();
+    }
+    return prevLimit;
 }
 
 SkResourceCache::DiscardableFactory SkResourceCache::GetDiscardableFactory() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->discardableFactory();
+    return global_cache().fDiscardableFactory;
 }
 
 SkCachedData* SkResourceCache::NewCachedData(size_t bytes) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->newCachedData(bytes);
+    // This needs no shard: allocating does not touch the cache.
+    if (DiscardableFactory factory = global_cache().fDiscardableFactory) {
+        SkDiscardableMemory* dm = factory(bytes);
+        return dm ? new SkCachedData(bytes, dm) : nullptr;
+    } else {
+        return new SkCachedData(sk_malloc_throw(bytes), bytes);
+    }
 }
 
 void SkResourceCache::Dump() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->dump();
+    for_each_shard([](const ShardAccess& shard) { shard->dump(); });
 }
 
 size_t SkResourceCache::SetSingleAllocationByteLimit(size_t size) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->setSingleAllocationByteLimit(size);
+    return global_cache().fSingleAllocationByteLimit.exchange(size);
 }
 
 size_t SkResourceCache::GetSingleAllocationByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getSingleAllocationByteLimit();
+    return global_cache().fSingleAllocationByteLimit.load(std::memory_order_relaxed);
 }
 
 size_t SkResourceCache::GetEffectiveSingleAllocationByteLimit() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->getEffectiveSingleAllocationByteLimit();
+    GlobalCache& global = global_cache();
+    // 0 means the caller is asking for our default
+    size_t limit = global.fSingleAllocationByteLimit.load(std::memory_order_relaxed);
+
+    // if we're not discardable (i.e. we are fixed-budget) then cap the single-limit
+    // to our budget.
+    if (nullptr == global.fDiscardableFactory) {
+        size_t totalLimit = global.fTotalByteLimit.load(std::memory_order_relaxed);
+        if (0 == limit) {
+            limit = totalLimit;
+        } else {
+            limit = std::min(limit, totalLimit);
+        }
+    }
+    return limit;
 }
 
 void SkResourceCache::PurgeAll() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->purgeAll();
+    for_each_shard([](const ShardAccess& shard) { shard->purgeAll(); });
 }
 
 void SkResourceCache::CheckMessages() {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->checkMessages();
+    for_each_shard([](const ShardAccess& shard) { shard->checkMessages(); });
 }
 
 bool SkResourceCache::Find(const Key& key, FindVisitor visitor, void* context) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    return get_cache()->find(key, visitor, context);
+    ShardAccess shard(shard_for(key.hash()));
+    bool found = shard->find(key, visitor, context);
+    if (found) {
+        shard.shard().fHits++;
+    } else {
+        shard.shard().fMisses++;
+    }
+    return found;
 }
 
 void SkResourceCache::Add(Rec* rec, void* payload) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->add(rec, payload);
+    {
+        ShardAccess shard(shard_for(rec->getHash()));
+        shard->add(rec, payload);
+    }
+    purge_as_needed();
 }
 
 void SkResourceCache::VisitAll(Visitor visitor, void* context) {
-    SkAutoMutexExclusive am(resource_cache_mutex());
-    get_cache()->visitAll(visitor, context);
+    for_each_shard([=](const ShardAccess& shard) { shard->visitAll(visitor, context); });
 }
 
 void SkResourceCache::PostPurgeSharedID(uint64_t sharedID) {
@@ -611,4 +775,15 @@ void SkResourceCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
     // Since resource could be backed by malloc or discardable, the cache always dumps detailed
     // stats to be accurate.
     VisitAll(sk_trace_dump_visitor, dump);
+
+    // The shards' totals are not named "size", as they would then be counted on top of the Recs.
+    int index = 0;
+    for_each_shard([dump, &index](const ShardAccess& shard) {
+        SkString dumpName = SkStringPrintf("skia/sk_resource_cache/shard_%d", index++);
+        dump->dumpNumericValue(dumpName.c_str(), "used_bytes", "bytes",
+                               shard->getTotalBytesUsed());
+        dump->dumpNumericValue(dumpName.c_str(), "rec_count", "objects", shard->getCount());
+        dump->dumpNumericValue(dumpName.c_str(), "hits", "objects", shard.shard().fHits);
+        dump->dumpNumericValue(dumpName.c_str(), "misses", "objects", shard.shard().fMisses);
+    });
 }
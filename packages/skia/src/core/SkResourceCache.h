@@ -23,8 +23,10 @@ class SkTraceMemoryDump;
  *  thread-safe, so if a given instance is to be shared across threads, the
  *  caller must manage the access itself (e.g. via a mutex).
  *
- *  As a convenience, a global instance is also defined, which can be safely
+ *  As a convenience, a global cache is also defined, which can be safely
  *  access across threads via the static methods (e.g. FindAndLock, etc.).
+ *  It is made of SK_RESOURCE_CACHE_SHARD_COUNT instances, each with its own
+ *  mutex, that share one budget.
  */
 class SkResourceCache {
 public:
@@ -223,6 +225,7 @@ public:
 
     size_t getTotalBytesUsed() const { return fTotalBytesUsed; }
     size_t getTotalByteLimit() const { return fTotalByteLimit; }
+    int getCount() const { return fCount; }
 
     /**
      *  This is respected by SkBitmapProcState::possiblyScaleImage.
@@ -248,6 +251,19 @@ public:
         this->purgeAsNeeded(true);
     }
 
+    /**
+     *  Purges the least recently used Rec that can be purged. Returns false if there is none.
+     *
+     *  If |resume| is true, the search carries on from where the previous call left off instead
+     *  of starting over at the oldest Rec, skipping again only the Recs that were in use then.
+     */
+    bool purgeOldest(bool resume = false);
+
+    /**
+     *  Purges the Recs of any SharedIDs posted with PostPurgeSharedID().
+     */
+    void checkMessages();
+
     DiscardableFactory discardableFactory() const { return fDiscardableFactory; }
 
     SkCachedData* newCachedData(size_t bytes);
@@ -260,6 +276,7 @@ public:
 private:
     Rec*    fHead;
     Rec*    fTail;
+    Rec*    fPurgeCursor;  // where purgeOldest(true) resumes, or nullptr
 
     class Hash;
     Hash*   fHash;
@@ -273,7 +290,6 @@ private:
 
     SkMessageBus<PurgeSharedIDMessage, uint32_t>::Inbox fPurgeSharedIDInbox;
 
-    void checkMessages();
     void purgeAsNeeded(bool forcePurge = false);
 
     // linklist management
@@ -153,10 +153,15 @@ void SkBlendImageFilter::flatten(SkWriteBuffer& buffer) const {
 sk_sp<SkSpecialImage> SkBlendImageFilter::onFilterImage(const Context& ctx,
                                                         SkIPoint* offset) const {
     SkIPoint backgroundOffset = SkIPoint::Make(0, 0);
-    sk_sp<SkSpecialImage> background(this->filterInput(0, ctx, &backgroundOffset));
-
     SkIPoint foregroundOffset = SkIPoint::Make(0, 0);
-    sk_sp<SkSpecialImage> foreground(this->filterInput(1, ctx, &foregroundOffset));
+    sk_sp<SkSpecialImage> background, foreground;
+    ctx.batch(2, [&](int i) {
+        if (i == 0) {
+            background = this->filterInput(0, ctx, &backgroundOffset);
+        } else {
+            foreground = this->filterInput(1, ctx, &foregroundOffset);
+        }
+    });
 
     SkIRect foregroundBounds = SkIRect::MakeEmpty();
     if (foreground) {
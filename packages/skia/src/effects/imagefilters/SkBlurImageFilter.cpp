@@ -73,6 +73,10 @@ private:
     friend void ::SkRegisterBlurImageFilterFlattenable();
     SK_FLATTENABLE_HOOKS(SkBlurImageFilter)
 
+    // With decal tiling each output pixel only reads the kernel's margin around it, which
+    // onFilterNodeBounds() includes. The other tile modes read wherever the input's edges are.
+    bool onHasLocalDependencies() const override { return fTileMode == SkTileMode::kDecal; }
+
 #if defined(SK_GANESH)
     sk_sp<SkSpecialImage> gpuFilter(
             const Context& ctx, SkVector sigma,
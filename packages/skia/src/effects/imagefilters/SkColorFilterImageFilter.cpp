@@ -56,6 +56,8 @@ private:
         return as_CFB(fColorFilter)->affectsTransparentBlack();
     }
 
+    bool onHasLocalDependencies() const override { return true; }
+
     bool onIsColorFilterNode(SkColorFilter** filter) const override {
         SkASSERT(1 == this->countInputs());
         if (filter) {
@@ -40,6 +40,8 @@ private:
 
     skif::FilterResult onFilterImage(const skif::Context& context) const override;
 
+    bool onHasLocalDependencies() const override { return true; }
+
     skif::LayerSpace<SkIRect> onGetInputLayerBounds(
             const skif::Mapping& mapping,
             const skif::LayerSpace<SkIRect>& desiredOutput,
@@ -8,6 +8,7 @@
 #include "include/core/SkAlphaType.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkColor.h"
+#include "include/core/SkColorPriv.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkFlattenable.h"
 #include "include/core/SkImageFilter.h"
@@ -26,10 +27,12 @@
 #include "include/private/SkSLSampleUsage.h"
 #include "include/private/base/SkSafe32.h"
 #include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkImageFilterTypes.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/core/SkWriteBuffer.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <utility>
@@ -102,13 +105,15 @@ private:
     using INHERITED = SkImageFilter_Base;
 };
 
-// Shift values to extract channels from an SkColor (SkColorGetR, SkColorGetG, etc)
+// Shift values to extract channels from an SkPMColor (SkGetPackedR32, SkGetPackedG32, etc)
 const uint8_t gChannelTypeToShift[] = {
-    16,  // R
-     8,  // G
-     0,  // B
-    24,  // A
+    SK_R32_SHIFT,  // R
+    SK_G32_SHIFT,  // G
+    SK_B32_SHIFT,  // B
+    SK_A32_SHIFT,  // A
 };
+// Extracts the unpremultiplied value of the selected channels. Only those channels are
+// unpremultiplied, rather than the whole color with SkUnPreMultiply::PMColorToColor().
 struct Extractor {
     Extractor(SkColorChannel typeX,
               SkColorChannel typeY)
@@ -118,8 +123,16 @@ struct Extractor {
 
     unsigned fShiftX, fShiftY;
 
-    unsigned getX(SkColor c) const { return (c >> fShiftX) & 0xFF; }
-    unsigned getY(SkColor c) const { return (c >> fShiftY) & 0xFF; }
+    unsigned getX(SkPMColor c) const { return get(c, fShiftX); }
+    unsigned getY(SkPMColor c) const { return get(c, fShiftY); }
+
+    static unsigned get(SkPMColor c, unsigned shift) {
+        const unsigned value = (c >> shift) & 0xFF;
+        if (shift == SK_A32_SHIFT) {
+            return value;
+        }
+        return SkUnPreMultiply::ApplyScale(SkUnPreMultiply::GetScale(SkGetPackedA32(c)), value);
+    }
 };
 
 static bool channel_selector_type_is_valid(SkColorChannel cst) {
@@ -231,41 +244,46 @@ private:
 }  // anonymous namespace
 #endif
 
-static void compute_displacement(Extractor ex, const SkVector& scale, SkBitmap* dst,
-                                 const SkBitmap& displ, const SkIPoint& offset,
-                                 const SkBitmap& src,
-                                 const SkIRect& bounds) {
+static void compute_displacement(const skif::Context& ctx, Extractor ex, const SkVector& scale,
+                                 SkBitmap* dst, const SkBitmap& displ, const SkIPoint& offset,
+                                 const SkBitmap& src, const SkIRect& bounds) {
     static const SkScalar Inv8bit = SkScalarInvert(255);
     const int srcW = src.width();
     const int srcH = src.height();
     const SkVector scaleForColor = SkVector::Make(scale.fX * Inv8bit, scale.fY * Inv8bit);
     const SkVector scaleAdj = SkVector::Make(SK_ScalarHalf - scale.fX * SK_ScalarHalf,
                                              SK_ScalarHalf - scale.fY * SK_ScalarHalf);
-    SkPMColor* dstPtr = dst->getAddr32(0, 0);
-    for (int y = bounds.top(); y < bounds.bottom(); ++y) {
-        const SkPMColor* displPtr = displ.getAddr32(bounds.left() + offset.fX, y + offset.fY);
-        for (int x = bounds.left(); x < bounds.right(); ++x, ++displPtr) {
-            SkColor c = SkUnPreMultiply::PMColorToColor(*displPtr);
-
-            SkScalar displX = scaleForColor.fX * ex.getX(c) + scaleAdj.fX;
-            SkScalar displY = scaleForColor.fY * ex.getY(c) + scaleAdj.fY;
-            // Truncate the displacement values
-            const int32_t srcX = Sk32_sat_add(x, SkScalarTruncToInt(displX));
-            const int32_t srcY = Sk32_sat_add(y, SkScalarTruncToInt(displY));
-            *dstPtr++ = ((srcX < 0) || (srcX >= srcW) || (srcY < 0) || (srcY >= srcH)) ?
-                      0 : *(src.getAddr32(srcX, srcY));
-        }
+    // The displacement only depends on the 8-bit channel value, so it is computed once for each.
+    int32_t displX[256], displY[256];
+    for (int i = 0; i < 256; ++i) {
+        // Truncate the displacement values
+        displX[i] = SkScalarTruncToInt(scaleForColor.fX * i + scaleAdj.fX);
+        displY[i] = SkScalarTruncToInt(scaleForColor.fY * i + scaleAdj.fY);
     }
+
+    // Each row depends only on the inputs, so bands of rows may be displaced concurrently.
+    static constexpr int kBandRows = 32;
+    const int height = bounds.height();
+    ctx.batch((height + kBandRows - 1) / kBandRows, [&](int band) {
+        const int top = bounds.top() + band * kBandRows;
+        const int bottom = std::min(top + kBandRows, bounds.bottom());
+        for (int y = top; y < bottom; ++y) {
+            const SkPMColor* displPtr = displ.getAddr32(bounds.left() + offset.fX, y + offset.fY);
+            SkPMColor* dstPtr = dst->getAddr32(0, y - bounds.top());
+            for (int x = bounds.left(); x < bounds.right(); ++x, ++displPtr) {
+                const SkPMColor c = *displPtr;
+                const int32_t srcX = Sk32_sat_add(x, displX[ex.getX(c)]);
+                const int32_t srcY = Sk32_sat_add(y, displY[ex.getY(c)]);
+                *dstPtr++ = ((srcX < 0) || (srcX >= srcW) || (srcY < 0) || (srcY >= srcH)) ?
+                          0 : *(src.getAddr32(srcX, srcY));
+            }
+        }
+    });
 }
 
 sk_sp<SkSpecialImage> SkDisplacementMapImageFilter::onFilterImage(const Context& ctx,
                                                                   SkIPoint* offset) const {
     SkIPoint colorOffset = SkIPoint::Make(0, 0);
-    sk_sp<SkSpecialImage> color(this->filterInput(1, ctx, &colorOffset));
-    if (!color) {
-        return nullptr;
-    }
-
     SkIPoint displOffset = SkIPoint::Make(0, 0);
     // Creation of the displacement map should happen in a non-colorspace aware context. This
     // texture is a purely mathematical construct, so we want to just operate on the stored
@@ -278,8 +296,15 @@ sk_sp<SkSpecialImage> SkDisplacementMapImageFilter::onFilterImage(const Context&
     // color space makes sense, so we ignore color spaces (and gamma) entirely. This may not be
     // ideal, but it's at least consistent and predictable.
     Context displContext = ctx.withNewColorSpace(/*cs=*/nullptr);
-    sk_sp<SkSpecialImage> displ(this->filterInput(0, displContext, &displOffset));
-    if (!displ) {
+    sk_sp<SkSpecialImage> color, displ;
+    ctx.batch(2, [&](int i) {
+        if (i == 0) {
+            color = this->filterInput(1, ctx, &colorOffset);
+        } else {
+            displ = this->filterInput(0, displContext, &displOffset);
+        }
+    });
+    if (!color || !displ) {
         return nullptr;
     }
 
@@ -393,7 +418,7 @@ sk_sp<SkSpecialImage> SkDisplacementMapImageFilter::onFilterImage(const Context&
         return nullptr;
     }
 
-    compute_displacement(Extractor(fXChannelSelector, fYChannelSelector), scale, &dst,
+    compute_displacement(ctx, Extractor(fXChannelSelector, fYChannelSelector), scale, &dst,
                          displBM, colorOffset - displOffset, colorBM, colorBounds);
 
     offset->fX = bounds.left();
@@ -25,13 +25,18 @@
 #include "include/effects/SkImageFilters.h"
 #include "include/private/base/SkFloatingPoint.h"
 #include "include/private/base/SkTPin.h"
+#include "include/private/base/SkTemplates.h"
+#include "src/base/SkVx.h"
+#include "src/core/SkImageFilterTypes.h"
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/core/SkWriteBuffer.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <utility>
 
@@ -87,16 +92,6 @@ static void setUniformNormal3(const GrGLSLProgramDataManager& pdman, UniformHand
 }
 #endif
 
-// Shift matrix components to the left, as we advance pixels to the right.
-static inline void shiftMatrixLeft(int m[9]) {
-    m[0] = m[1];
-    m[3] = m[4];
-    m[6] = m[7];
-    m[1] = m[2];
-    m[4] = m[5];
-    m[7] = m[8];
-}
-
 static inline void fast_normalize(SkPoint3* vector) {
     // add a tiny bit so we don't have to worry about divide-by-zero
     SkScalar magSq = vector->dot(*vector) + SK_ScalarNearlyZero;
@@ -114,6 +109,54 @@ static inline void fast_normalize(SkPoint3* vector) {
     vector->fZ *= scale;
 }
 
+namespace {
+// The raster filters light the interior of each row 4 pixels at a time, one SSE or NEON register
+// per coordinate. The math on each lane is the same as on an SkPoint3, operation for operation, so
+// the results are identical.
+struct SkPoint3x4 {
+    skvx::float4 fX, fY, fZ;
+
+    static SkPoint3x4 Make(const SkPoint3& p) { return {p.fX, p.fY, p.fZ}; }
+
+    skvx::float4 dot(const SkPoint3x4& p) const { return fX * p.fX + fY * p.fY + fZ * p.fZ; }
+    SkPoint3x4 makeScale(const skvx::float4& scale) const {
+        return {fX * scale, fY * scale, fZ * scale};
+    }
+};
+}  // anonymous namespace
+
+static SK_ALWAYS_INLINE void fast_normalize(SkPoint3x4* vector) {
+    skvx::float4 magSq = vector->dot(*vector) + SK_ScalarNearlyZero;
+    skvx::float4 scale = 1.0f / skvx::sqrt(magSq);
+    vector->fX *= scale;
+    vector->fY *= scale;
+    vector->fZ *= scale;
+}
+
+// SkScalarPow() of each lane.
+static SK_ALWAYS_INLINE skvx::float4 pow4(skvx::float4 x, SkScalar y) {
+    for (int i = 0; i < 4; ++i) {
+        x[i] = SkScalarPow(x[i], y);
+    }
+    return x;
+}
+
+// SkTPin(SkScalarRoundToInt(x), 0, 255) of each lane, with NaN going to 255 as it does there.
+static SK_ALWAYS_INLINE skvx::uint4 round_and_pin(skvx::float4 x) {
+    x = skvx::if_then_else(x < 255.0f, x, skvx::float4(255.0f));
+    x = skvx::if_then_else(x > 0.0f, x, skvx::float4(0.0f));
+    // Rounding the fraction on its own avoids the error in float of adding 0.5 to it.
+    skvx::int4 i = skvx::cast<int32_t>(x);
+    i -= (x - skvx::cast<float>(i) >= 0.5f);
+    return skvx::cast<uint32_t>(i);
+}
+
+static SK_ALWAYS_INLINE void store_argb(const skvx::uint4& a, const skvx::uint4& r,
+                                         const skvx::uint4& g, const skvx::uint4& b,
+                                         SkPMColor dst[4]) {
+    (a << SK_A32_SHIFT | r << SK_R32_SHIFT | g << SK_G32_SHIFT | b << SK_B32_SHIFT).store(dst);
+}
+
 static SkPoint3 read_point3(SkReadBuffer& buffer) {
     SkPoint3 point;
     point.fX = buffer.readScalar();
@@ -199,6 +242,13 @@ public:
                             SkTPin(SkScalarRoundToInt(color.fY), 0, 255),
                             SkTPin(SkScalarRoundToInt(color.fZ), 0, 255));
     }
+    SK_ALWAYS_INLINE void light(const SkPoint3x4& normal, const SkPoint3x4& surfaceTolight,
+                                const SkPoint3x4& lightColor, SkPMColor dst[4]) const {
+        skvx::float4 colorScale = fKD * normal.dot(surfaceTolight);
+        SkPoint3x4 color = lightColor.makeScale(colorScale);
+        store_argb(255, round_and_pin(color.fX), round_and_pin(color.fY), round_and_pin(color.fZ),
+                   dst);
+    }
 private:
     SkScalar fKD;
 };
@@ -207,6 +257,11 @@ static SkScalar max_component(const SkPoint3& p) {
     return p.x() > p.y() ? (p.x() > p.z() ? p.x() : p.z()) : (p.y() > p.z() ? p.y() : p.z());
 }
 
+static SK_ALWAYS_INLINE skvx::float4 max_component(const SkPoint3x4& p) {
+    return skvx::if_then_else(p.fX > p.fY, skvx::if_then_else(p.fX > p.fZ, p.fX, p.fZ),
+                                           skvx::if_then_else(p.fY > p.fZ, p.fY, p.fZ));
+}
+
 class SpecularLightingType : public BaseLightingType {
 public:
     SpecularLightingType(SkScalar ks, SkScalar shininess)
@@ -223,6 +278,16 @@ public:
                             SkTPin(SkScalarRoundToInt(color.fY), 0, 255),
                             SkTPin(SkScalarRoundToInt(color.fZ), 0, 255));
     }
+    SK_ALWAYS_INLINE void light(const SkPoint3x4& normal, const SkPoint3x4& surfaceTolight,
+                                const SkPoint3x4& lightColor, SkPMColor dst[4]) const {
+        SkPoint3x4 halfDir(surfaceTolight);
+        halfDir.fZ += SK_Scalar1;
+        fast_normalize(&halfDir);
+        skvx::float4 colorScale = fKS * pow4(normal.dot(halfDir), fShininess);
+        SkPoint3x4 color = lightColor.makeScale(colorScale);
+        store_argb(round_and_pin(max_component(color)), round_and_pin(color.fX),
+                   round_and_pin(color.fY), round_and_pin(color.fZ), dst);
+    }
 private:
     SkScalar fKS;
     SkScalar fShininess;
@@ -294,133 +359,6 @@ static inline SkPoint3 bottomRightNormal(int m[9], SkScalar surfaceScale) {
                          surfaceScale);
 }
 
-namespace {
-class UncheckedPixelFetcher {
-public:
-    static inline uint32_t Fetch(const SkBitmap& src, int x, int y, const SkIRect& bounds) {
-        return SkGetPackedA32(*src.getAddr32(x, y));
-    }
-};
-
-// The DecalPixelFetcher is used when the destination crop rect exceeds the input bitmap bounds.
-class DecalPixelFetcher {
-public:
-    static inline uint32_t Fetch(const SkBitmap& src, int x, int y, const SkIRect& bounds) {
-        if (x < bounds.fLeft || x >= bounds.fRight || y < bounds.fTop || y >= bounds.fBottom) {
-            return 0;
-        } else {
-            return SkGetPackedA32(*src.getAddr32(x, y));
-        }
-    }
-};
-}  // anonymous namespace
-
-template <class PixelFetcher>
-static void lightBitmap(const BaseLightingType& lightingType,
-                 const SkImageFilterLight* l,
-                 const SkBitmap& src,
-                 SkBitmap* dst,
-                 SkScalar surfaceScale,
-                 const SkIRect& bounds) {
-    SkASSERT(dst->width() == bounds.width() && dst->height() == bounds.height());
-    int left = bounds.left(), right = bounds.right();
-    int bottom = bounds.bottom();
-    int y = bounds.top();
-    SkIRect srcBounds = src.bounds();
-    SkPMColor* dptr = dst->getAddr32(0, 0);
-    {
-        int x = left;
-        int m[9];
-        m[4] = PixelFetcher::Fetch(src, x,     y,     srcBounds);
-        m[5] = PixelFetcher::Fetch(src, x + 1, y,     srcBounds);
-        m[7] = PixelFetcher::Fetch(src, x,     y + 1, srcBounds);
-        m[8] = PixelFetcher::Fetch(src, x + 1, y + 1, srcBounds);
-        SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(topLeftNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x)
-        {
-            shiftMatrixLeft(m);
-            m[5] = PixelFetcher::Fetch(src, x + 1, y,     srcBounds);
-            m[8] = PixelFetcher::Fetch(src, x + 1, y + 1, srcBounds);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(topNormal(m, surfaceScale), surfaceToLight,
-                                         l->lightColor(surfaceToLight));
-        }
-        shiftMatrixLeft(m);
-        surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(topRightNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-    }
-
-    for (++y; y < bottom - 1; ++y) {
-        int x = left;
-        int m[9];
-        m[1] = PixelFetcher::Fetch(src, x,     y - 1, srcBounds);
-        m[2] = PixelFetcher::Fetch(src, x + 1, y - 1, srcBounds);
-        m[4] = PixelFetcher::Fetch(src, x,     y,     srcBounds);
-        m[5] = PixelFetcher::Fetch(src, x + 1, y,     srcBounds);
-        m[7] = PixelFetcher::Fetch(src, x,     y + 1, srcBounds);
-        m[8] = PixelFetcher::Fetch(src, x + 1, y + 1, srcBounds);
-        SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(leftNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x) {
-            shiftMatrixLeft(m);
-            m[2] = PixelFetcher::Fetch(src, x + 1, y - 1, srcBounds);
-            m[5] = PixelFetcher::Fetch(src, x + 1, y,     srcBounds);
-            m[8] = PixelFetcher::Fetch(src, x + 1, y + 1, srcBounds);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(interiorNormal(m, surfaceScale), surfaceToLight,
-                                         l->lightColor(surfaceToLight));
-        }
-        shiftMatrixLeft(m);
-        surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(rightNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-    }
-
-    {
-        int x = left;
-        int m[9];
-        m[1] = PixelFetcher::Fetch(src, x,     bottom - 2, srcBounds);
-        m[2] = PixelFetcher::Fetch(src, x + 1, bottom - 2, srcBounds);
-        m[4] = PixelFetcher::Fetch(src, x,     bottom - 1, srcBounds);
-        m[5] = PixelFetcher::Fetch(src, x + 1, bottom - 1, srcBounds);
-        SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(bottomLeftNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x)
-        {
-            shiftMatrixLeft(m);
-            m[2] = PixelFetcher::Fetch(src, x + 1, bottom - 2, srcBounds);
-            m[5] = PixelFetcher::Fetch(src, x + 1, bottom - 1, srcBounds);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(bottomNormal(m, surfaceScale), surfaceToLight,
-                                         l->lightColor(surfaceToLight));
-        }
-        shiftMatrixLeft(m);
-        surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(bottomRightNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-    }
-}
-
-static void lightBitmap(const BaseLightingType& lightingType,
-                 const SkImageFilterLight* light,
-                 const SkBitmap& src,
-                 SkBitmap* dst,
-                 SkScalar surfaceScale,
-                 const SkIRect& bounds) {
-    if (src.bounds().contains(bounds)) {
-        lightBitmap<UncheckedPixelFetcher>(
-            lightingType, light, src, dst, surfaceScale, bounds);
-    } else {
-        lightBitmap<DecalPixelFetcher>(
-            lightingType, light, src, dst, surfaceScale, bounds);
-    }
-}
-
 namespace {
 enum BoundaryMode {
     kTopLeft_BoundaryMode,
@@ -914,6 +852,11 @@ public:
         return fDirection;
     }
     SkPoint3 lightColor(const SkPoint3&) const override { return this->color(); }
+    SkPoint3x4 surfaceToLight(const skvx::float4& x, int y, const skvx::float4& z,
+                              SkScalar surfaceScale) const {
+        return SkPoint3x4::Make(fDirection);
+    }
+    SkPoint3x4 lightColor(const SkPoint3x4&) const { return SkPoint3x4::Make(this->color()); }
     LightType type() const override { return kDistant_LightType; }
     const SkPoint3& direction() const { return fDirection; }
     std::unique_ptr<GpuLight> createGpuLight() const override {
@@ -970,7 +913,16 @@ public:
         fast_normalize(&direction);
         return direction;
     }
+    SkPoint3x4 surfaceToLight(const skvx::float4& x, int y, const skvx::float4& z,
+                              SkScalar surfaceScale) const {
+        SkPoint3x4 direction = {fLocation.fX - x,
+                                fLocation.fY - SkIntToScalar(y),
+                                fLocation.fZ - z * surfaceScale};
+        fast_normalize(&direction);
+        return direction;
+    }
     SkPoint3 lightColor(const SkPoint3&) const override { return this->color(); }
+    SkPoint3x4 lightColor(const SkPoint3x4&) const { return SkPoint3x4::Make(this->color()); }
     LightType type() const override { return kPoint_LightType; }
     const SkPoint3& location() const { return fLocation; }
     std::unique_ptr<GpuLight> createGpuLight() const override {
@@ -1074,6 +1026,14 @@ public:
         fast_normalize(&direction);
         return direction;
     }
+    SkPoint3x4 surfaceToLight(const skvx::float4& x, int y, const skvx::float4& z,
+                              SkScalar surfaceScale) const {
+        SkPoint3x4 direction = {fLocation.fX - x,
+                                fLocation.fY - SkIntToScalar(y),
+                                fLocation.fZ - z * surfaceScale};
+        fast_normalize(&direction);
+        return direction;
+    }
     SkPoint3 lightColor(const SkPoint3& surfaceToLight) const override {
         SkScalar cosAngle = -surfaceToLight.dot(fS);
         SkScalar scale = 0;
@@ -1085,6 +1045,19 @@ public:
         }
         return this->color().makeScale(scale);
     }
+    SkPoint3x4 lightColor(const SkPoint3x4& surfaceToLight) const {
+        skvx::float4 cosAngle = -surfaceToLight.dot(SkPoint3x4::Make(fS));
+        skvx::float4 scale = 0;
+        skvx::int4 inCone = cosAngle >= fCosOuterConeAngle;
+        if (skvx::any(inCone)) {
+            skvx::float4 inner = pow4(cosAngle, fSpecularExponent);
+            inner = skvx::if_then_else(cosAngle < fCosInnerConeAngle,
+                                       inner * ((cosAngle - fCosOuterConeAngle) * fConeScale),
+                                       inner);
+            scale = skvx::if_then_else(inCone, inner, scale);
+        }
+        return SkPoint3x4::Make(this->color()).makeScale(scale);
+    }
     std::unique_ptr<GpuLight> createGpuLight() const override {
 #if defined(SK_GANESH)
         return std::make_unique<GpuSpotLight>();
@@ -1197,6 +1170,143 @@ void SkImageFilterLight::flattenLight(SkWriteBuffer& buffer) const {
             return nullptr;
     }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+// The rows of heights are padded with zeros so that a vector may be read at any x within them.
+static constexpr int kHeightsPadding = 4;
+
+// Reads the heights (alpha) of row y of the bounds, in src's coordinates, with zeros outside src.
+static void read_heights(const SkBitmap& src, const SkIRect& bounds, int y, float heights[]) {
+    std::fill_n(heights, bounds.width() + kHeightsPadding, 0.0f);
+    if (y < 0 || y >= src.height()) {
+        return;
+    }
+    const int left = std::max(bounds.left(), 0), right = std::min(bounds.right(), src.width());
+    const SkPMColor* row = src.getAddr32(0, y);
+    for (int x = left; x < right; ++x) {
+        heights[x - bounds.left()] = SkGetPackedA32(row[x]);
+    }
+}
+
+// Lights rows [top, bottom) of the bounds. The first and last columns are lit one pixel at a time
+// with the normals of the edges; the interior of each row is lit a vector at a time.
+template <class LightingType, class Light>
+static void lightRows(const LightingType& lightingType,
+                      const Light& light,
+                      const SkBitmap& src,
+                      SkBitmap* dst,
+                      SkScalar surfaceScale,
+                      const SkIRect& bounds,
+                      int top, int bottom) {
+    using NormalProc = SkPoint3 (*)(int m[9], SkScalar surfaceScale);
+    static constexpr NormalProc kEdgeNormals[3][2] = {
+        {topLeftNormal,    topRightNormal},
+        {leftNormal,       rightNormal},
+        {bottomLeftNormal, bottomRightNormal},
+    };
+    const int width = bounds.width(), height = bounds.height();
+    const int rowLength = width + kHeightsPadding;
+
+    skia_private::AutoTMalloc<float> storage(4 * rowLength);
+    float* zeros = storage.get();
+    float* above = zeros + rowLength;
+    float* row   = above + rowLength;
+    float* below = row + rowLength;
+    std::fill_n(zeros, rowLength, 0.0f);
+    read_heights(src, bounds, bounds.top() + top - 1, above);
+    read_heights(src, bounds, bounds.top() + top, row);
+
+    const skvx::float4 iota = {0, 1, 2, 3};
+    for (int y = top; y < bottom; ++y) {
+        read_heights(src, bounds, bounds.top() + y + 1, below);
+        // The first (kind 0) and last (kind 2) rows of the bounds have no row beyond them, and
+        // their normals are found from the rows they do have, with other weights.
+        const int rowKind = y == 0 ? 0 : (y == height - 1 ? 2 : 1);
+        const float* up   = rowKind == 0 ? zeros : above;
+        const float* down = rowKind == 2 ? zeros : below;
+        const float* gradientUp   = rowKind == 0 ? row : up;
+        const float* gradientDown = rowKind == 2 ? row : down;
+        const SkScalar xScale = rowKind == 1 ? gOneQuarter : gOneThird;
+        const SkScalar yScale = rowKind == 1 ? gOneQuarter : gOneHalf;
+        const int sy = bounds.top() + y;
+        SkPMColor* dptr = dst->getAddr32(0, y);
+
+        for (int x = 1; x < width - 1; x += 4) {
+            auto load = [x](const float* heights, int dx) {
+                return skvx::float4::Load(heights + x + dx);
+            };
+            skvx::float4 gx = (load(up, 1) - load(up, -1)) +
+                              2 * (load(row, 1) - load(row, -1)) +
+                              (load(down, 1) - load(down, -1));
+            skvx::float4 gy = (load(gradientDown, -1) + 2 * load(gradientDown, 0) +
+                               load(gradientDown, 1)) -
+                              (load(gradientUp, -1) + 2 * load(gradientUp, 0) +
+                               load(gradientUp, 1));
+            SkPoint3x4 normal = {-(gx * xScale) * surfaceScale, -(gy * yScale) * surfaceScale, 1};
+            fast_normalize(&normal);
+            SkPoint3x4 surfaceToLight = light.surfaceToLight(
+                    SkIntToScalar(bounds.left() + x) + iota, sy, load(row, 0), surfaceScale);
+            if (x + 4 <= width - 1) {
+                lightingType.light(normal, surfaceToLight, light.lightColor(surfaceToLight),
+                                   dptr + x);
+            } else {
+                SkPMColor tail[4];
+                lightingType.light(normal, surfaceToLight, light.lightColor(surfaceToLight), tail);
+                memcpy(dptr + x, tail, (width - 1 - x) * sizeof(SkPMColor));
+            }
+        }
+
+        for (int x : {0, width - 1}) {
+            int m[9];
+            for (int i = 0; i < 3; ++i) {
+                const bool inside = x + i - 1 >= 0 && x + i - 1 < width;
+                m[i]     = inside ? up[x + i - 1]   : 0;
+                m[i + 3] = inside ? row[x + i - 1]  : 0;
+                m[i + 6] = inside ? down[x + i - 1] : 0;
+            }
+            SkPoint3 normal = kEdgeNormals[rowKind][x == 0 ? 0 : 1](m, surfaceScale);
+            SkPoint3 surfaceToLight =
+                    light.surfaceToLight(bounds.left() + x, sy, m[4], surfaceScale);
+            dptr[x] = lightingType.light(normal, surfaceToLight, light.lightColor(surfaceToLight));
+        }
+
+        std::swap(above, row);
+        std::swap(row, below);
+    }
+}
+
+template <class LightingType>
+static void lightBitmap(const skif::Context& ctx,
+                        const LightingType& lightingType,
+                        const SkImageFilterLight* light,
+                        const SkBitmap& src,
+                        SkBitmap* dst,
+                        SkScalar surfaceScale,
+                        const SkIRect& bounds) {
+    SkASSERT(dst->width() == bounds.width() && dst->height() == bounds.height());
+    // Each row depends only on the source, so bands of rows may be lit concurrently.
+    static constexpr int kBandRows = 32;
+    const int height = bounds.height();
+    auto lightBands = [&](const auto& light) {
+        ctx.batch((height + kBandRows - 1) / kBandRows, [&](int band) {
+            lightRows(lightingType, light, src, dst, surfaceScale, bounds,
+                      band * kBandRows, std::min((band + 1) * kBandRows, height));
+        });
+    };
+    switch (light->type()) {
+        case SkImageFilterLight::kDistant_LightType:
+            lightBands(static_cast<const SkDistantLight&>(*light));
+            break;
+        case SkImageFilterLight::kPoint_LightType:
+            lightBands(static_cast<const SkPointLight&>(*light));
+            break;
+        case SkImageFilterLight::kSpot_LightType:
+            lightBands(static_cast<const SkSpotLight&>(*light));
+            break;
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 sk_sp<SkImageFilter> SkImageFilters::DistantLitDiffuse(
@@ -1361,12 +1471,7 @@ sk_sp<SkSpecialImage> SkDiffuseLightingImageFilter::onFilterImage(const Context&
     sk_sp<SkImageFilterLight> transformedLight(light()->transform(matrix));
 
     DiffuseLightingType lightingType(fKD);
-    lightBitmap(lightingType,
-                                                             transformedLight.get(),
-                                                             inputBM,
-                                                             &dst,
-                                                             surfaceScale(),
-                                                             bounds);
+    lightBitmap(ctx, lightingType, transformedLight.get(), inputBM, &dst, surfaceScale(), bounds);
 
     return SkSpecialImage::MakeFromRaster(SkIRect::MakeWH(bounds.width(), bounds.height()),
                                           dst, ctx.surfaceProps());
@@ -1505,12 +1610,7 @@ sk_sp<SkSpecialImage> SkSpecularLightingImageFilter::onFilterImage(const Context
 
     sk_sp<SkImageFilterLight> transformedLight(light()->transform(matrix));
 
-    lightBitmap(lightingType,
-                                                              transformedLight.get(),
-                                                              inputBM,
-                                                              &dst,
-                                                              surfaceScale(),
-                                                              bounds);
+    lightBitmap(ctx, lightingType, transformedLight.get(), inputBM, &dst, surfaceScale(), bounds);
 
     return SkSpecialImage::MakeFromRaster(SkIRect::MakeWH(bounds.width(), bounds.height()), dst,
                                           ctx.surfaceProps());
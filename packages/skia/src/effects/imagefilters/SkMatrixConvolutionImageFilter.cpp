@@ -24,11 +24,15 @@
 #include "include/private/base/SkMath.h"
 #include "include/private/base/SkTPin.h"
 #include "include/private/base/SkTemplates.h"
+#include "src/base/SkUtils.h"
+#include "src/base/SkVx.h"
+#include "src/core/SkImageFilterTypes.h"
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/core/SkWriteBuffer.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -45,10 +49,52 @@ class SkMatrix;
 #include "src/gpu/ganesh/effects/GrMatrixConvolutionEffect.h"
 #endif
 
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <emmintrin.h>
+#elif defined(SK_ARM_HAS_NEON)
+    #include <arm_neon.h>
+#endif
+
 using namespace skia_private;
 
 namespace {
 
+// Sums the four 8-bit channels of pixels weighted by kernel values, as floats in the order the
+// channels are packed in memory. Each lane adds the same products in the same order as summing
+// the channels one at a time would. The accumulator is the platform's own vector type, which
+// compilers keep in a register across the kernel loops more reliably than a skvx::float4.
+struct ChannelSums {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    __m128 fSum = _mm_setzero_ps();
+
+    void add(SkPMColor c, float k) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i v = _mm_cvtsi32_si128(static_cast<int>(c));
+        v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+        fSum = _mm_add_ps(fSum, _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(k)));
+    }
+#elif defined(SK_ARM_HAS_NEON)
+    float32x4_t fSum = vdupq_n_f32(0);
+
+    void add(SkPMColor c, float k) {
+        const uint16x8_t v = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(c)));
+        fSum = vaddq_f32(fSum, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), k));
+    }
+#else
+    skvx::float4 fSum = 0;
+
+    void add(SkPMColor c, float k) {
+        // Each channel is moved to the low byte of its lane, then made a float by setting it as
+        // the mantissa of 2^23 and subtracting 2^23. That is exact, and stays in vector registers
+        // on compilers that split skvx::cast() into one conversion per lane.
+        const skvx::uint4 v = skvx::uint4(c) * skvx::uint4{1 << 24, 1 << 16, 1 << 8, 1} >> 24;
+        fSum += (skvx::bit_pun<skvx::float4>(v | 0x4B000000) - 8388608.0f) * k;
+    }
+#endif
+
+    skvx::float4 sums() const { return sk_bit_cast<skvx::float4>(fSum); }
+};
+
 class SkMatrixConvolutionImageFilter final : public SkImageFilter_Base {
 public:
     SkMatrixConvolutionImageFilter(const SkISize& kernelSize, const SkScalar* kernel,
@@ -95,7 +141,9 @@ private:
     SkTileMode  fTileMode;
     bool        fConvolveAlpha;
 
-    template <class PixelFetcher, bool convolveAlpha>
+    // A non-zero kKernelWidth and kKernelHeight must match fKernelSize; they let the compiler
+    // unroll the kernel loops for the common small sizes.
+    template <class PixelFetcher, bool convolveAlpha, int kKernelWidth = 0, int kKernelHeight = 0>
     void filterPixels(const SkBitmap& src,
                       SkBitmap* result,
                       SkIVector& offset,
@@ -107,6 +155,12 @@ private:
                       SkIVector& offset,
                       const SkIRect& rect,
                       const SkIRect& bounds) const;
+    template <int kKernelWidth, int kKernelHeight>
+    void filterUncheckedPixels(const SkBitmap& src,
+                               SkBitmap* result,
+                               SkIVector& offset,
+                               const SkIRect& rect,
+                               const SkIRect& bounds) const;
     void filterInteriorPixels(const SkBitmap& src,
                               SkBitmap* result,
                               SkIVector& offset,
@@ -254,34 +308,38 @@ void SkMatrixConvolutionImageFilter::flatten(SkWriteBuffer& buffer) const {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-template<class PixelFetcher, bool convolveAlpha>
+template<class PixelFetcher, bool convolveAlpha, int kKernelWidth, int kKernelHeight>
 void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
                                                   SkBitmap* result,
                                                   SkIVector& offset,
                                                   SkIRect rect,
                                                   const SkIRect& bounds) const {
+    SkASSERT(!kKernelWidth || kKernelWidth == fKernelSize.fWidth);
+    SkASSERT(!kKernelHeight || kKernelHeight == fKernelSize.fHeight);
+    const int kernelWidth = kKernelWidth ? kKernelWidth : fKernelSize.fWidth;
+    const int kernelHeight = kKernelHeight ? kKernelHeight : fKernelSize.fHeight;
     if (!rect.intersect(bounds)) {
         return;
     }
     for (int y = rect.fTop; y < rect.fBottom; ++y) {
         SkPMColor* dptr = result->getAddr32(rect.fLeft - offset.fX, y - offset.fY);
         for (int x = rect.fLeft; x < rect.fRight; ++x) {
-            SkScalar sumA = 0, sumR = 0, sumG = 0, sumB = 0;
-            for (int cy = 0; cy < fKernelSize.fHeight; cy++) {
-                for (int cx = 0; cx < fKernelSize.fWidth; cx++) {
+            ChannelSums channelSums;
+            for (int cy = 0; cy < kernelHeight; cy++) {
+                for (int cx = 0; cx < kernelWidth; cx++) {
                     SkPMColor s = PixelFetcher::fetch(src,
                                                       x + cx - fKernelOffset.fX,
                                                       y + cy - fKernelOffset.fY,
                                                       bounds);
-                    SkScalar k = fKernel[cy * fKernelSize.fWidth + cx];
-                    if (convolveAlpha) {
-                        sumA += SkGetPackedA32(s) * k;
-                    }
-                    sumR += SkGetPackedR32(s) * k;
-                    sumG += SkGetPackedG32(s) * k;
-                    sumB += SkGetPackedB32(s) * k;
+                    SkScalar k = fKernel[cy * kernelWidth + cx];
+                    channelSums.add(s, k);
                 }
             }
+            const skvx::float4 sum = channelSums.sums();
+            SkScalar sumA = sum[SK_A32_SHIFT / 8],
+                     sumR = sum[SK_R32_SHIFT / 8],
+                     sumG = sum[SK_G32_SHIFT / 8],
+                     sumB = sum[SK_B32_SHIFT / 8];
             int a = convolveAlpha
                   ? SkTPin(SkScalarFloorToInt(sumA * fGain + fBias), 0, 255)
                   : 255;
@@ -311,6 +369,21 @@ void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
     }
 }
 
+template<int kKernelWidth, int kKernelHeight>
+void SkMatrixConvolutionImageFilter::filterUncheckedPixels(const SkBitmap& src,
+                                                           SkBitmap* result,
+                                                           SkIVector& offset,
+                                                           const SkIRect& rect,
+                                                           const SkIRect& bounds) const {
+    if (fConvolveAlpha) {
+        filterPixels<UncheckedPixelFetcher, true, kKernelWidth, kKernelHeight>(
+                src, result, offset, rect, bounds);
+    } else {
+        filterPixels<UncheckedPixelFetcher, false, kKernelWidth, kKernelHeight>(
+                src, result, offset, rect, bounds);
+    }
+}
+
 void SkMatrixConvolutionImageFilter::filterInteriorPixels(const SkBitmap& src,
                                                           SkBitmap* result,
                                                           SkIVector& offset,
@@ -326,7 +399,13 @@ void SkMatrixConvolutionImageFilter::filterInteriorPixels(const SkBitmap& src,
         case SkTileMode::kClamp:
             // Fall through
         case SkTileMode::kDecal:
-            filterPixels<UncheckedPixelFetcher>(src, result, offset, rect, bounds);
+            if (fKernelSize == SkISize{3, 3}) {
+                this->filterUncheckedPixels<3, 3>(src, result, offset, rect, bounds);
+            } else if (fKernelSize == SkISize{5, 5}) {
+                this->filterUncheckedPixels<5, 5>(src, result, offset, rect, bounds);
+            } else {
+                filterPixels<UncheckedPixelFetcher>(src, result, offset, rect, bounds);
+            }
             break;
     }
 }
@@ -488,7 +567,17 @@ sk_sp<SkSpecialImage> SkMatrixConvolutionImageFilter::onFilterImage(const Contex
 
     this->filterBorderPixels(inputBM, &dst, dstContentOffset, top, srcBounds);
     this->filterBorderPixels(inputBM, &dst, dstContentOffset, left, srcBounds);
-    this->filterInteriorPixels(inputBM, &dst, dstContentOffset, interior, srcBounds);
+    // The interior is most of the work, and its rows are independent, so bands of them may be
+    // filtered concurrently.
+    static constexpr int kBandRows = 32;
+    if (!interior.isEmpty()) {
+        ctx.batch((interior.height() + kBandRows - 1) / kBandRows, [&](int band) {
+            SkIRect rows = interior;
+            rows.fTop = interior.fTop + band * kBandRows;
+            rows.fBottom = std::min(rows.fTop + kBandRows, interior.fBottom);
+            this->filterInteriorPixels(inputBM, &dst, dstContentOffset, rows, srcBounds);
+        });
+    }
     this->filterBorderPixels(inputBM, &dst, dstContentOffset, right, srcBounds);
     this->filterBorderPixels(inputBM, &dst, dstContentOffset, bottom, srcBounds);
 
@@ -12,6 +12,7 @@
 #include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkTypes.h"
+#include "include/private/base/SkTemplates.h"
 #include "src/core/SkImageFilterTypes.h"
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkReadBuffer.h"
@@ -36,6 +37,8 @@ private:
 
     MatrixCapability onGetCTMCapability() const override { return MatrixCapability::kComplex; }
 
+    bool onHasLocalDependencies() const override { return true; }
+
     skif::FilterResult onFilterImage(const skif::Context& ctx) const override;
 
     skif::LayerSpace<SkIRect> onGetInputLayerBounds(
@@ -77,9 +80,12 @@ sk_sp<SkFlattenable> SkMergeImageFilter::CreateProc(SkReadBuffer& buffer) {
 
 skif::FilterResult SkMergeImageFilter::onFilterImage(const skif::Context& ctx) const {
     const int inputCount = this->countInputs();
+    skia_private::AutoTArray<skif::FilterResult> inputs(inputCount);
+    ctx.batch(inputCount, [&](int i) { inputs[i] = this->getChildOutput(i, ctx); });
+
     skif::FilterResult::Builder builder{ctx};
     for (int i = 0; i < inputCount; ++i) {
-        builder.add(this->getChildOutput(i, ctx));
+        builder.add(std::move(inputs[i]));
     }
     return builder.merge();
 }
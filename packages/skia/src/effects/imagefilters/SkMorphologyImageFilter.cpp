@@ -23,7 +23,10 @@
 #include "include/effects/SkImageFilters.h"
 #include "include/private/SkColorData.h"
 #include "include/private/SkSLSampleUsage.h"
+#include "include/private/base/SkTemplates.h"
 #include "include/private/base/SkTo.h"
+#include "src/base/SkVx.h"
+#include "src/core/SkImageFilterTypes.h"
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkSpecialImage.h"
@@ -62,14 +65,6 @@ struct GrShaderCaps;
 #include "src/base/SkRandom.h"
 #endif
 
-#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
-    #include <emmintrin.h>
-#endif
-
-#if defined(SK_ARM_HAS_NEON)
-    #include <arm_neon.h>
-#endif
-
 namespace {
 
 enum class MorphType {
@@ -177,20 +172,30 @@ void SkMorphologyImageFilter::flatten(SkWriteBuffer& buffer) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static void call_proc_X(SkMorphologyImageFilter::Proc procX,
+// The rows (for X) or columns (for Y) are independent, so bands of them may be filtered
+// concurrently.
+static constexpr int kBandLines = 64;
+
+static void call_proc_X(const skif::Context& ctx, SkMorphologyImageFilter::Proc procX,
                         const SkBitmap& src, SkBitmap* dst,
                         int radiusX, const SkIRect& bounds) {
-    procX(src.getAddr32(bounds.left(), bounds.top()), dst->getAddr32(0, 0),
-          radiusX, bounds.width(), bounds.height(),
-          src.rowBytesAsPixels(), dst->rowBytesAsPixels());
+    ctx.batch((bounds.height() + kBandLines - 1) / kBandLines, [&](int band) {
+        const int top = band * kBandLines;
+        procX(src.getAddr32(bounds.left(), bounds.top() + top), dst->getAddr32(0, top),
+              radiusX, bounds.width(), std::min(kBandLines, bounds.height() - top),
+              src.rowBytesAsPixels(), dst->rowBytesAsPixels());
+    });
 }
 
-static void call_proc_Y(SkMorphologyImageFilter::Proc procY,
+static void call_proc_Y(const skif::Context& ctx, SkMorphologyImageFilter::Proc procY,
                         const SkPMColor* src, int srcRowBytesAsPixels, SkBitmap* dst,
                         int radiusY, const SkIRect& bounds) {
-    procY(src, dst->getAddr32(0, 0),
-          radiusY, bounds.height(), bounds.width(),
-          srcRowBytesAsPixels, dst->rowBytesAsPixels());
+    ctx.batch((bounds.width() + kBandLines - 1) / kBandLines, [&](int band) {
+        const int left = band * kBandLines;
+        procY(src + left, dst->getAddr32(left, 0),
+              radiusY, bounds.height(), std::min(kBandLines, bounds.width() - left),
+              srcRowBytesAsPixels, dst->rowBytesAsPixels());
+    });
 }
 
 SkRect SkMorphologyImageFilter::computeFastBounds(const SkRect& src) const {
@@ -544,117 +549,79 @@ static sk_sp<SkSpecialImage> apply_morphology(
 
 namespace {
 
-#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
-    template<MorphType type, MorphDirection direction>
-    static void morph(const SkPMColor* src, SkPMColor* dst,
-                      int radius, int width, int height, int srcStride, int dstStride) {
-        const int srcStrideX = direction == MorphDirection::kX ? 1 : srcStride;
-        const int dstStrideX = direction == MorphDirection::kX ? 1 : dstStride;
-        const int srcStrideY = direction == MorphDirection::kX ? srcStride : 1;
-        const int dstStrideY = direction == MorphDirection::kX ? dstStride : 1;
-        radius = std::min(radius, width - 1);
-        const SkPMColor* upperSrc = src + radius * srcStrideX;
-        for (int x = 0; x < width; ++x) {
-            const SkPMColor* lp = src;
-            const SkPMColor* up = upperSrc;
-            SkPMColor* dptr = dst;
-            for (int y = 0; y < height; ++y) {
-                __m128i extreme = (type == MorphType::kDilate) ? _mm_setzero_si128()
-                                                               : _mm_set1_epi32(0xFFFFFFFF);
-                for (const SkPMColor* p = lp; p <= up; p += srcStrideX) {
-                    __m128i src_pixel = _mm_cvtsi32_si128(*p);
-                    extreme = (type == MorphType::kDilate) ? _mm_max_epu8(src_pixel, extreme)
-                                                           : _mm_min_epu8(src_pixel, extreme);
+// Dilate and erode take the max or min of each channel over a window of 2 * radius + 1 pixels.
+// Following van Herk and Gil & Werman, each line is split into blocks the size of the window, and
+// the running extremes are taken forwards (g) and backwards (h) within each block. Any window then
+// covers the end of one block and the start of the next, so each output pixel costs one max or
+// min whatever the radius. The lines are padded by 'radius' pixels that never win (0 for max, 255
+// for min), which limits the windows to the line as before.
+//
+// Four lines are filtered at once, with one pixel of each in a byte16.
+template <MorphType type>
+static inline skvx::byte16 extreme(const skvx::byte16& a, const skvx::byte16& b) {
+    return type == MorphType::kDilate ? max(a, b) : min(a, b);
+}
+
+template<MorphType type, MorphDirection direction>
+static void morph(const SkPMColor* src, SkPMColor* dst,
+                  int radius, int width, int height, int srcStride, int dstStride) {
+    const int srcStrideX = direction == MorphDirection::kX ? 1 : srcStride;
+    const int dstStrideX = direction == MorphDirection::kX ? 1 : dstStride;
+    const int srcStrideY = direction == MorphDirection::kX ? srcStride : 1;
+    const int dstStrideY = direction == MorphDirection::kX ? dstStride : 1;
+    const SkPMColor identity = type == MorphType::kDilate ? 0 : 0xFFFFFFFF;
+    radius = std::min(radius, width - 1);
+    const int window = 2 * radius + 1;
+    const int padded = width + 2 * radius;
+    skia_private::AutoTMalloc<skvx::byte16> g(padded), h(padded);
+
+    for (int y = 0; y < height; y += 4) {
+        const int lines = std::min(4, height - y);
+        // When the lines are columns, their pixels are adjacent in memory.
+        const bool contiguous = direction == MorphDirection::kY && lines == 4;
+
+        for (int x = 0; x < padded; ++x) {
+            SkPMColor pixels[4] = {identity, identity, identity, identity};
+            if (x >= radius && x < width + radius) {
+                const SkPMColor* p = src + (x - radius) * srcStrideX;
+                if (contiguous) {
+                    h[x] = skvx::byte16::Load(p);
+                    continue;
+                }
+                for (int i = 0; i < lines; ++i) {
+                    pixels[i] = p[i * srcStrideY];
                 }
-                *dptr = _mm_cvtsi128_si32(extreme);
-                dptr += dstStrideY;
-                lp += srcStrideY;
-                up += srcStrideY;
             }
-            if (x >= radius) { src += srcStrideX; }
-            if (x + radius < width - 1) { upperSrc += srcStrideX; }
-            dst += dstStrideX;
+            h[x] = skvx::byte16::Load(pixels);
         }
-    }
-
-#elif defined(SK_ARM_HAS_NEON)
-    template<MorphType type, MorphDirection direction>
-    static void morph(const SkPMColor* src, SkPMColor* dst,
-                      int radius, int width, int height, int srcStride, int dstStride) {
-        const int srcStrideX = direction == MorphDirection::kX ? 1 : srcStride;
-        const int dstStrideX = direction == MorphDirection::kX ? 1 : dstStride;
-        const int srcStrideY = direction == MorphDirection::kX ? srcStride : 1;
-        const int dstStrideY = direction == MorphDirection::kX ? dstStride : 1;
-        radius = std::min(radius, width - 1);
-        const SkPMColor* upperSrc = src + radius * srcStrideX;
-        for (int x = 0; x < width; ++x) {
-            const SkPMColor* lp = src;
-            const SkPMColor* up = upperSrc;
-            SkPMColor* dptr = dst;
-            for (int y = 0; y < height; ++y) {
-                uint8x8_t extreme = vdup_n_u8(type == MorphType::kDilate ? 0 : 255);
-                for (const SkPMColor* p = lp; p <= up; p += srcStrideX) {
-                    uint8x8_t src_pixel = vreinterpret_u8_u32(vdup_n_u32(*p));
-                    extreme = (type == MorphType::kDilate) ? vmax_u8(src_pixel, extreme)
-                                                           : vmin_u8(src_pixel, extreme);
-                }
-                *dptr = vget_lane_u32(vreinterpret_u32_u8(extreme), 0);
-                dptr += dstStrideY;
-                lp += srcStrideY;
-                up += srcStrideY;
+        for (int start = 0; start < padded; start += window) {
+            const int end = std::min(start + window, padded);
+            g[start] = h[start];
+            for (int x = start + 1; x < end; ++x) {
+                g[x] = extreme<type>(g[x - 1], h[x]);
+            }
+            for (int x = end - 2; x >= start; --x) {
+                h[x] = extreme<type>(h[x], h[x + 1]);
             }
-            if (x >= radius) src += srcStrideX;
-            if (x + radius < width - 1) upperSrc += srcStrideX;
-            dst += dstStrideX;
         }
-    }
-
-#else
-    template<MorphType type, MorphDirection direction>
-    static void morph(const SkPMColor* src, SkPMColor* dst,
-                      int radius, int width, int height, int srcStride, int dstStride) {
-        const int srcStrideX = direction == MorphDirection::kX ? 1 : srcStride;
-        const int dstStrideX = direction == MorphDirection::kX ? 1 : dstStride;
-        const int srcStrideY = direction == MorphDirection::kX ? srcStride : 1;
-        const int dstStrideY = direction == MorphDirection::kX ? dstStride : 1;
-        radius = std::min(radius, width - 1);
-        const SkPMColor* upperSrc = src + radius * srcStrideX;
         for (int x = 0; x < width; ++x) {
-            const SkPMColor* lp = src;
-            const SkPMColor* up = upperSrc;
-            SkPMColor* dptr = dst;
-            for (int y = 0; y < height; ++y) {
-                // If we're maxing (dilate), start from 0; if minning (erode), start from 255.
-                const int start = (type == MorphType::kDilate) ? 0 : 255;
-                int B = start, G = start, R = start, A = start;
-                for (const SkPMColor* p = lp; p <= up; p += srcStrideX) {
-                    int b = SkGetPackedB32(*p),
-                        g = SkGetPackedG32(*p),
-                        r = SkGetPackedR32(*p),
-                        a = SkGetPackedA32(*p);
-                    if (type == MorphType::kDilate) {
-                        B = std::max(b, B);
-                        G = std::max(g, G);
-                        R = std::max(r, R);
-                        A = std::max(a, A);
-                    } else {
-                        B = std::min(b, B);
-                        G = std::min(g, G);
-                        R = std::min(r, R);
-                        A = std::min(a, A);
-                    }
-                }
-                *dptr = SkPackARGB32(A, R, G, B);
-                dptr += dstStrideY;
-                lp += srcStrideY;
-                up += srcStrideY;
+            const skvx::byte16 e = extreme<type>(h[x], g[x + 2 * radius]);
+            SkPMColor* d = dst + x * dstStrideX;
+            if (contiguous) {
+                e.store(d);
+                continue;
+            }
+            SkPMColor pixels[4];
+            e.store(pixels);
+            for (int i = 0; i < lines; ++i) {
+                d[i * dstStrideY] = pixels[i];
             }
-            if (x >= radius) { src += srcStrideX; }
-            if (x + radius < width - 1) { upperSrc += srcStrideX; }
-            dst += dstStrideX;
         }
+        src += 4 * srcStrideY;
+        dst += 4 * dstStrideY;
     }
-#endif
+}
+
 }  // namespace
 
 sk_sp<SkSpecialImage> SkMorphologyImageFilter::onFilterImage(const Context& ctx,
@@ -746,15 +713,15 @@ sk_sp<SkSpecialImage> SkMorphologyImageFilter::onFilterImage(const Context& ctx,
             return nullptr;
         }
 
-        call_proc_X(procX, inputBM, &tmp, width, srcBounds);
+        call_proc_X(ctx, procX, inputBM, &tmp, width, srcBounds);
         SkIRect tmpBounds = SkIRect::MakeWH(srcBounds.width(), srcBounds.height());
-        call_proc_Y(procY,
+        call_proc_Y(ctx, procY,
                     tmp.getAddr32(tmpBounds.left(), tmpBounds.top()), tmp.rowBytesAsPixels(),
                     &dst, height, tmpBounds);
     } else if (width > 0) {
-        call_proc_X(procX, inputBM, &dst, width, srcBounds);
+        call_proc_X(ctx, procX, inputBM, &dst, width, srcBounds);
     } else if (height > 0) {
-        call_proc_Y(procY,
+        call_proc_Y(ctx, procY,
                     inputBM.getAddr32(srcBounds.left(), srcBounds.top()),
                     inputBM.rowBytesAsPixels(),
                     &dst, height, srcBounds);
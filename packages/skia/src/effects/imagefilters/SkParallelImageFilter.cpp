@@ -0,0 +1,86 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkFlattenable.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/effects/SkImageFilters.h"
+#include "src/core/SkImageFilterTypes.h"
+#include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkReadBuffer.h"
+#include "src/core/SkWriteBuffer.h"
+
+#include <utility>
+
+class SkExecutor;
+
+namespace {
+
+// Evaluates its input with an executor in the context, so that the merges, blends, arithmetics,
+// displacements and runtime effects in the input's DAG filter their independent inputs
+// concurrently. The output is identical to the input's.
+class SkParallelImageFilter final : public SkImageFilter_Base {
+public:
+    SkParallelImageFilter(SkExecutor* executor, sk_sp<SkImageFilter> input)
+            : SkImageFilter_Base(&input, 1, /*cropRect=*/nullptr)
+            , fExecutor(executor) {
+        SkASSERT(executor);
+    }
+
+protected:
+    void flatten(SkWriteBuffer&) const override;
+
+private:
+    friend void ::SkRegisterParallelImageFilterFlattenable();
+    SK_FLATTENABLE_HOOKS(SkParallelImageFilter)
+
+    bool onHasLocalDependencies() const override { return true; }
+
+    skif::FilterResult onFilterImage(const skif::Context& context) const override {
+        return this->getChildOutput(0, context.withNewExecutor(fExecutor));
+    }
+
+    skif::LayerSpace<SkIRect> onGetInputLayerBounds(
+            const skif::Mapping& mapping,
+            const skif::LayerSpace<SkIRect>& desiredOutput,
+            const skif::LayerSpace<SkIRect>& contentBounds) const override {
+        return this->getChildInputLayerBounds(0, mapping, desiredOutput, contentBounds);
+    }
+
+    skif::LayerSpace<SkIRect> onGetOutputLayerBounds(
+            const skif::Mapping& mapping,
+            const skif::LayerSpace<SkIRect>& contentBounds) const override {
+        return this->getChildOutputLayerBounds(0, mapping, contentBounds);
+    }
+
+    SkExecutor* fExecutor;
+};
+
+} // end namespace
+
+sk_sp<SkImageFilter> SkImageFilters::Parallel(SkExecutor* executor, sk_sp<SkImageFilter> input) {
+    if (!executor || !input) {
+        return input;
+    }
+    return sk_sp<SkImageFilter>(new SkParallelImageFilter(executor, std::move(input)));
+}
+
+void SkRegisterParallelImageFilterFlattenable() {
+    SK_REGISTER_FLATTENABLE(SkParallelImageFilter);
+}
+
+sk_sp<SkFlattenable> SkParallelImageFilter::CreateProc(SkReadBuffer& buffer) {
+    SK_IMAGEFILTER_UNFLATTEN_COMMON(common, 1);
+    // The executor belongs to the process that made the filter, so it is not serialized, and the
+    // deserialized filter is just its input.
+    return common.getInput(0);
+}
+
+void SkParallelImageFilter::flatten(SkWriteBuffer& buffer) const {
+    this->SkImageFilter_Base::flatten(buffer);
+}
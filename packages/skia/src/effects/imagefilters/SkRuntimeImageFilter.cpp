@@ -22,6 +22,7 @@
 #include "include/effects/SkRuntimeEffect.h"
 #include "include/private/base/SkAssert.h"
 #include "include/private/base/SkTArray.h"
+#include "include/private/base/SkTemplates.h"
 #include "src/base/SkSpinlock.h"
 #include "src/core/SkImageFilterTypes.h"
 #include "src/core/SkImageFilter_Base.h"
@@ -241,9 +242,12 @@ skif::FilterResult SkRuntimeImageFilter::onFilterImage(const skif::Context& ctx)
 
     skif::Context inputCtx = ctx.withNewDesiredOutput(
             this->applyMaxSampleRadius(ctx.mapping(), ctx.desiredOutput()));
+    skia_private::AutoTArray<skif::FilterResult> inputs(inputCount);
+    inputCtx.batch(inputCount, [&](int i) { inputs[i] = this->getChildOutput(i, inputCtx); });
+
     skif::FilterResult::Builder builder{ctx};
     for (int i = 0; i < inputCount; ++i) {
-        builder.add(this->getChildOutput(i, inputCtx));
+        builder.add(std::move(inputs[i]));
     }
     return builder.eval([&](SkSpan<sk_sp<SkShader>> inputs) {
         // lock the mutation of the builder and creation of the shader so that the builder's state
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkFlattenable.h"
+#include "include/core/SkImageFilter.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSize.h"
+#include "include/effects/SkImageFilters.h"
+#include "include/private/base/SkTemplates.h"
+#include "src/core/SkImageFilterCache.h"
+#include "src/core/SkImageFilterTypes.h"
+#include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkReadBuffer.h"
+#include "src/core/SkSpecialImage.h"
+#include "src/core/SkSpecialSurface.h"
+#include "src/core/SkWriteBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+class SkExecutor;
+
+namespace {
+
+// Evaluates its input one output tile at a time on the CPU. Each tile asks the input DAG for just
+// that tile as its desired output, so every filter in the DAG only allocates what the tile (and
+// the margin its own inputs need around it) covers. The tiles are then copied into one output
+// image, so peak memory is that image plus the intermediates of the tiles in flight, rather than
+// a full-size image per intermediate.
+//
+// With reuse, the output and the source it was filtered from are kept as a Frame in the context's
+// cache. The next time the filter runs with the same matrix and output bounds, the old and new
+// sources are compared, and the tiles whose required input (per getInputLayerBounds()) saw no
+// change are copied from the old output instead of being filtered again.
+class SkTiledImageFilter final : public SkImageFilter_Base {
+public:
+    SkTiledImageFilter(const SkISize& tileSize, SkExecutor* executor, sk_sp<SkImageFilter> input,
+                       SkImageFilters::TileReuse reuse)
+            : SkImageFilter_Base(&input, 1, /*cropRect=*/nullptr)
+            , fTileSize(tileSize)
+            , fExecutor(executor)
+            , fReuse(reuse) {
+        SkASSERT(!tileSize.isEmpty());
+    }
+
+protected:
+    void flatten(SkWriteBuffer&) const override;
+
+private:
+    friend void ::SkRegisterTiledImageFilterFlattenable();
+    SK_FLATTENABLE_HOOKS(SkTiledImageFilter)
+
+    bool onHasLocalDependencies() const override { return true; }
+
+    skif::FilterResult onFilterImage(const skif::Context& context) const override;
+
+    // Returns, for each tile-sized cell of the source, whether 'prev' and 'source' differ in it.
+    skia_private::AutoTArray<bool> findDamage(const skif::Context& context,
+                                              const SkBitmap& prev,
+                                              const SkBitmap& source,
+                                              int cellsX, int cellsY) const;
+
+    skif::LayerSpace<SkIRect> onGetInputLayerBounds(
+            const skif::Mapping& mapping,
+            const skif::LayerSpace<SkIRect>& desiredOutput,
+            const skif::LayerSpace<SkIRect>& contentBounds) const override {
+        return this->getChildInputLayerBounds(0, mapping, desiredOutput, contentBounds);
+    }
+
+    skif::LayerSpace<SkIRect> onGetOutputLayerBounds(
+            const skif::Mapping& mapping,
+            const skif::LayerSpace<SkIRect>& contentBounds) const override {
+        return this->getChildOutputLayerBounds(0, mapping, contentBounds);
+    }
+
+    SkISize                   fTileSize;
+    SkExecutor*               fExecutor;
+    SkImageFilters::TileReuse fReuse;
+};
+
+} // end namespace
+
+sk_sp<SkImageFilter> SkImageFilters::Tiled(const SkISize& tileSize, SkExecutor* executor,
+                                           sk_sp<SkImageFilter> input, TileReuse reuse) {
+    if (tileSize.isEmpty() || !input) {
+        return input;
+    }
+    return sk_sp<SkImageFilter>(
+            new SkTiledImageFilter(tileSize, executor, std::move(input), reuse));
+}
+
+void SkRegisterTiledImageFilterFlattenable() {
+    SK_REGISTER_FLATTENABLE(SkTiledImageFilter);
+}
+
+sk_sp<SkFlattenable> SkTiledImageFilter::CreateProc(SkReadBuffer& buffer) {
+    SK_IMAGEFILTER_UNFLATTEN_COMMON(common, 1);
+    SkISize tileSize;
+    tileSize.fWidth = buffer.readInt();
+    tileSize.fHeight = buffer.readInt();
+    const bool reuse = buffer.readBool();
+    if (!buffer.validate(!tileSize.isEmpty())) {
+        return nullptr;
+    }
+    // Like SkImageFilters::Parallel(), the executor is not serialized.
+    return SkImageFilters::Tiled(tileSize, /*executor=*/nullptr, common.getInput(0),
+                                 static_cast<SkImageFilters::TileReuse>(reuse));
+}
+
+void SkTiledImageFilter::flatten(SkWriteBuffer& buffer) const {
+    this->SkImageFilter_Base::flatten(buffer);
+    buffer.writeInt(fTileSize.width());
+    buffer.writeInt(fTileSize.height());
+    buffer.writeBool(static_cast<bool>(fReuse));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+skif::FilterResult SkTiledImageFilter::onFilterImage(const skif::Context& context) const {
+    skif::LayerSpace<SkIRect> outputBounds = this->getChildOutputLayerBounds(
+            0, context.mapping(), context.source().layerBounds());
+    if (!outputBounds.intersect(context.desiredOutput())) {
+        return {};
+    }
+    const SkIRect bounds = SkIRect(outputBounds);
+    const bool reuse = fReuse == SkImageFilters::TileReuse::kYes && context.cache() &&
+                       this->hasLocalDependencies();
+    if (context.gpuBacked() || (!reuse && bounds.width() <= fTileSize.width() &&
+                                          bounds.height() <= fTileSize.height())) {
+        return this->getChildOutput(0, context);
+    }
+
+    sk_sp<SkSpecialSurface> surface = context.makeSurface(bounds.size());
+    SkPixmap dst;
+    if (!surface || !surface->getCanvas()->peekPixels(&dst)) {
+        return this->getChildOutput(0, context);
+    }
+    dst.erase(SK_ColorTRANSPARENT);
+
+    const int tilesX = (bounds.width() + fTileSize.width() - 1) / fTileSize.width();
+    const int tilesY = (bounds.height() + fTileSize.height() - 1) / fTileSize.height();
+    const skif::Context tileContext = fExecutor ? context.withNewExecutor(fExecutor) : context;
+
+    // The previous output can be reused if it was filtered with the same matrix to the same
+    // bounds, in the same color space, from a source of the same size and format.
+    const SkIRect sourceBounds = SkIRect(context.source().layerBounds());
+    const SkImageFilterCacheKey frameKey(this->uniqueID(), context.mapping().layerMatrix(),
+                                         bounds, /*srcGenID=*/0, SkIRect::MakeEmpty());
+    SkImageFilterCache::Frame frame;
+    SkBitmap prevOutput, prevSource, source;
+    bool havePrev = reuse && context.cache()->getFrame(frameKey, &frame) &&
+                    frame.fOutput.image() && frame.fOutput.image()->getROPixels(&prevOutput) &&
+                    prevOutput.dimensions() == bounds.size() &&
+                    prevOutput.colorType() == dst.colorType() &&
+                    SkColorSpace::Equals(frame.fColorSpace.get(), context.colorSpace()) &&
+                    SkIRect(frame.fSource.layerBounds()) == sourceBounds;
+    const int cellsX = (sourceBounds.width() + fTileSize.width() - 1) / fTileSize.width();
+    const int cellsY = (sourceBounds.height() + fTileSize.height() - 1) / fTileSize.height();
+    skia_private::AutoTArray<bool> damage;
+    if (havePrev && context.source().image() && frame.fSource.image() &&
+        frame.fSource.image()->uniqueID() != context.source().image()->uniqueID()) {
+        havePrev = frame.fSource.image()->getROPixels(&prevSource) &&
+                   context.source().image()->getROPixels(&source) &&
+                   prevSource.info() == source.info();
+        if (havePrev) {
+            damage = this->findDamage(tileContext, prevSource, source, cellsX, cellsY);
+        }
+    }
+    // Whether any of the source cells 'input' overlaps changed.
+    auto damaged = [&](SkIRect input) {
+        if (!damage.get() || !input.intersect(sourceBounds)) {
+            return false;
+        }
+        input.offset(-sourceBounds.left(), -sourceBounds.top());
+        for (int y = input.top() / fTileSize.height();
+             y <= (input.bottom() - 1) / fTileSize.height(); ++y) {
+            for (int x = input.left() / fTileSize.width();
+                 x <= (input.right() - 1) / fTileSize.width(); ++x) {
+                if (damage[y * cellsX + x]) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    std::atomic<int> reused{0};
+    tileContext.batch(tilesX * tilesY, [&](int i) {
+        SkIRect tile = SkIRect::MakeXYWH(bounds.left() + (i % tilesX) * fTileSize.width(),
+                                         bounds.top() + (i / tilesX) * fTileSize.height(),
+                                         fTileSize.width(),
+                                         fTileSize.height());
+        if (havePrev) {
+            const SkIRect input = SkIRect(this->getChildInputLayerBounds(
+                    0, context.mapping(), skif::LayerSpace<SkIRect>(tile),
+                    context.source().layerBounds()));
+            if (!damaged(input)) {
+                SkAssertResult(tile.intersect(bounds));
+                tile.offset(-bounds.left(), -bounds.top());
+                SkPixmap dstTile;
+                dst.extractSubset(&dstTile, tile);
+                prevOutput.pixmap().readPixels(dstTile, tile.left(), tile.top());
+                reused++;
+                return;
+            }
+        }
+
+        // Each tile caches its own intermediates, so that what a sub-DAG shared within the tile
+        // computes once is released with the tile instead of accumulating in the shared cache.
+        sk_sp<SkImageFilterCache> cache(
+                SkImageFilterCache::Create(SkImageFilterCache::kDefaultTransientSize));
+        skif::Context ctx = tileContext.withNewCache(cache.get())
+                                       .withNewDesiredOutput(skif::LayerSpace<SkIRect>(tile));
+
+        SkIPoint origin;
+        sk_sp<SkSpecialImage> image = this->getChildOutput(0, ctx).imageAndOffset(ctx, &origin);
+        SkBitmap pixels;
+        if (!image || !image->getROPixels(&pixels)) {
+            return;
+        }
+        SkIRect copy = SkIRect::MakeXYWH(origin.x(), origin.y(), image->width(), image->height());
+        if (!copy.intersect(tile) || !copy.intersect(bounds)) {
+            return;
+        }
+        // The tiles are disjoint, so writing them to the shared output concurrently is safe.
+        SkPixmap dstTile;
+        dst.extractSubset(&dstTile, copy.makeOffset(-bounds.left(), -bounds.top()));
+        pixels.pixmap().readPixels(dstTile, copy.left() - origin.x(), copy.top() - origin.y());
+    });
+
+    skif::FilterResult output(surface->makeImageSnapshot(), outputBounds.topLeft());
+    if (reuse) {
+        context.cache()->setFrame(frameKey, this,
+                                  {context.source(), output, sk_ref_sp(context.colorSpace())});
+        context.cache()->recordTiles(reused, tilesX * tilesY - reused);
+    }
+    return output;
+}
+
+skia_private::AutoTArray<bool> SkTiledImageFilter::findDamage(const skif::Context& context,
+                                                              const SkBitmap& prev,
+                                                              const SkBitmap& source,
+                                                              int cellsX, int cellsY) const {
+    skia_private::AutoTArray<bool> damage(cellsX * cellsY);
+    const size_t bpp = source.bytesPerPixel();
+    context.batch(cellsY, [&](int y) {
+        const int top = y * fTileSize.height();
+        const int bottom = std::min(top + fTileSize.height(), source.height());
+        for (int x = 0; x < cellsX; ++x) {
+            const int left = x * fTileSize.width();
+            const size_t bytes = bpp * (std::min(left + fTileSize.width(), source.width()) - left);
+            bool changed = false;
+            for (int row = top; row < bottom && !changed; ++row) {
+                changed = memcmp(prev.getAddr(left, row), source.getAddr(left, row), bytes) != 0;
+            }
+            damage[y * cellsX + x] = changed;
+        }
+    });
+    return damage;
+}
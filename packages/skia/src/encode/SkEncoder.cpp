@@ -27,3 +27,17 @@ bool SkEncoder::encodeRows(int numRows) {
 
     return true;
 }
+
+bool SkEncoder::encodeRows(const SkPixmap& rows) {
+    if (rows.width() != fSrc.width() || rows.height() <= 0 ||
+        rows.colorType() != fSrc.colorType() || rows.alphaType() != fSrc.alphaType() ||
+        !rows.addr()) {
+        return false;
+    }
+
+    fRows = &rows;
+    fRowsTop = fCurrRow;
+    const bool result = this->encodeRows(rows.height());
+    fRows = nullptr;
+    return result;
+}
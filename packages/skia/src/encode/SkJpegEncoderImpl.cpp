@@ -13,6 +13,7 @@
 #include "include/core/SkData.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixmap.h"
+#include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkYUVAInfo.h"
@@ -25,16 +26,19 @@
 #include "src/base/SkMSAN.h"
 #include "src/codec/SkJpegConstants.h"
 #include "src/codec/SkJpegPriv.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/encode/SkImageEncoderFns.h"
 #include "src/encode/SkImageEncoderPriv.h"
 #include "src/encode/SkJPEGWriteUtility.h"
 #include "src/image/SkImage_Base.h"
 
+#include <algorithm>
 #include <csetjmp>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 
 class GrDirectContext;
 class SkColorSpace;
@@ -257,11 +261,14 @@ bool SkJpegEncoderMgr::setParams(const SkYUVAPixmapInfo& srcInfo,
     return true;
 }
 
+// If |restartRows| is not zero, the image is encoded with a restart marker every |restartRows| MCU
+// rows, and with the standard Huffman tables.
 static std::unique_ptr<SkEncoder> Make(SkWStream* dst,
                                        const SkPixmap* src,
                                        const SkYUVAPixmaps* srcYUVA,
                                        const SkColorSpace* srcYUVAColorSpace,
-                                       const SkJpegEncoder::Options& options) {
+                                       const SkJpegEncoder::Options& options,
+                                       int restartRows = 0) {
     // Exactly one of |src| or |srcYUVA| should be specified.
     if (srcYUVA) {
         SkASSERT(!src);
@@ -292,6 +299,11 @@ static std::unique_ptr<SkEncoder> Make(SkWStream* dst,
         }
     }
 
+    if (restartRows > 0) {
+        encoderMgr->cinfo()->restart_in_rows = restartRows;
+        encoderMgr->cinfo()->optimize_coding = FALSE;
+    }
+
     jpeg_set_quality(encoderMgr->cinfo(), options.fQuality, TRUE);
     jpeg_start_compress(encoderMgr->cinfo(), TRUE);
 
@@ -351,6 +363,10 @@ bool SkJpegEncoderImpl::onEncodeRows(int numRows) {
     }
 
     if (fSrcYUVA) {
+        if (this->encodingSuppliedRows()) {
+            // The rows come from the planes, and a single pixmap cannot stand in for them.
+            return false;
+        }
         // TODO(ccameron): Consider using jpeg_write_raw_data, to avoid having to re-pack the data.
         for (int i = 0; i < numRows; i++) {
             yuva_copy_row(fSrcYUVA, fCurrRow + i, fStorage.get());
@@ -360,7 +376,7 @@ bool SkJpegEncoderImpl::onEncodeRows(int numRows) {
     } else {
         const size_t srcBytes = SkColorTypeBytesPerPixel(fSrc.colorType()) * fSrc.width();
         const size_t jpegSrcBytes = fEncoderMgr->cinfo()->input_components * fSrc.width();
-        const void* srcRow = fSrc.addr(0, fCurrRow);
+        const void* srcRow = this->srcRowAddr(fCurrRow);
         for (int i = 0; i < numRows; i++) {
             JSAMPLE* jpegSrcRow = (JSAMPLE*)srcRow;
             if (fEncoderMgr->proc()) {
@@ -380,7 +396,7 @@ bool SkJpegEncoderImpl::onEncodeRows(int numRows) {
             }
 
             jpeg_write_scanlines(fEncoderMgr->cinfo(), &jpegSrcRow, 1);
-            srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
+            srcRow = SkTAddOffset<const void>(srcRow, this->srcRowBytes());
         }
     }
 
@@ -392,9 +408,163 @@ bool SkJpegEncoderImpl::onEncodeRows(int numRows) {
     return true;
 }
 
+namespace {
+
+// Parallel encoding. The image is cut into bands of whole MCU rows, and each band is encoded as a
+// jpeg of its own, with a restart interval as long as the band. A band then holds exactly one
+// restart interval, and its entropy-coded data is exactly what a single encode of the whole image
+// with that restart interval would have produced for it. The output is the first band's header
+// (with the frame height patched) followed by each band's entropy-coded data, separated by
+// restart markers.
+
+// Bands are at least this many pixels, so the cost of a task stays well above its overhead.
+constexpr size_t kMinBandPixels = 256 * 1024;
+constexpr int kMaxBands = 64;
+constexpr uint8_t kMarkerRST0 = 0xD0;
+
+uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// Finds the frame height and the start of the entropy-coded data in a jpeg written by libjpeg,
+// which has a single frame and a single scan and ends with the EndOfImage marker.
+bool find_scan(const SkData& jpeg, size_t* frameHeightOffset, size_t* scanDataOffset) {
+    const uint8_t* bytes = jpeg.bytes();
+    const size_t size = jpeg.size();
+    *frameHeightOffset = 0;
+    size_t offset = kJpegMarkerCodeSize;
+    while (offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize <= size) {
+        if (bytes[offset] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = bytes[offset + 1];
+        const size_t length = read_u16(bytes + offset + kJpegMarkerCodeSize);
+        if (marker >= 0xC0 && marker <= 0xC2) {
+            // StartOfFrame: precision (1), then height (2).
+            *frameHeightOffset = offset + kJpegMarkerCodeSize + kJpegSegmentParameterLengthSize + 1;
+        }
+        offset += kJpegMarkerCodeSize + length;
+        if (marker == kJpegMarkerStartOfScan) {
+            *scanDataOffset = offset;
+            return *frameHeightOffset && offset + kJpegMarkerCodeSize <= size &&
+                   bytes[size - 2] == 0xFF && bytes[size - 1] == kJpegMarkerEndOfImage;
+        }
+    }
+    return false;
+}
+
+// Returns false if the image is not worth splitting, in which case nothing has been written.
+bool encode_in_parallel(SkWStream* dst, const SkPixmap& src,
+                        const SkJpegEncoder::Options& options, bool* success) {
+    if (!SkPixmapIsValid(src) || src.height() > 0xFFFF) {
+        return false;
+    }
+
+    // The MCU size follows from the sampling factors chosen in setParams().
+    bool gray = false;
+    switch (src.colorType()) {
+        case kGray_8_SkColorType:
+        case kAlpha_8_SkColorType:
+        case kR8_unorm_SkColorType:
+            gray = true;
+            break;
+        default:
+            break;
+    }
+    const int mcuWidth  = gray || options.fDownsample == SkJpegEncoder::Downsample::k444 ? 8 : 16;
+    const int mcuHeight = gray || options.fDownsample != SkJpegEncoder::Downsample::k420 ? 8 : 16;
+    const int mcusPerRow = (src.width() + mcuWidth - 1) / mcuWidth;
+    const int mcuRows = (src.height() + mcuHeight - 1) / mcuHeight;
+
+    // The restart interval is counted in MCUs, and cannot exceed 65535.
+    const size_t pixelsPerMcuRow = (size_t)src.width() * mcuHeight;
+    const int bandMcuRows = std::min(
+            std::max((int)((kMinBandPixels + pixelsPerMcuRow - 1) / pixelsPerMcuRow),
+                     (mcuRows + kMaxBands - 1) / kMaxBands),
+            0xFFFF / mcusPerRow);
+    if (bandMcuRows < 1) {
+        return false;
+    }
+    const int bandCount = (mcuRows + bandMcuRows - 1) / bandMcuRows;
+    if (bandCount < 2) {
+        return false;
+    }
+
+    std::vector<sk_sp<SkData>> bands(bandCount);
+    {
+        SkTaskGroup tasks(*options.fExecutor);
+        for (int i = 0; i < bandCount; ++i) {
+            tasks.add([&, i] {
+                const int top = i * bandMcuRows * mcuHeight;
+                const int bottom = std::min(top + bandMcuRows * mcuHeight, src.height());
+                SkPixmap bandSrc;
+                if (!src.extractSubset(&bandSrc, SkIRect::MakeLTRB(0, top, src.width(), bottom))) {
+                    return;
+                }
+
+                // Only the first band's header is kept, so only it needs the metadata. The color
+                // space is only used to write the ICC profile.
+                SkJpegEncoder::Options bandOptions = options;
+                if (i > 0) {
+                    bandOptions.xmpMetadata = nullptr;
+                    bandOptions.fICCProfile = nullptr;
+                    bandSrc.setColorSpace(nullptr);
+                }
+                SkDynamicMemoryWStream stream;
+                auto encoder = Make(&stream, &bandSrc, nullptr, nullptr, bandOptions, bandMcuRows);
+                if (encoder && encoder->encodeRows(bandSrc.height())) {
+                    bands[i] = stream.detachAsData();
+                }
+            });
+        }
+        tasks.wait();
+    }
+
+    *success = false;
+    size_t frameHeightOffset, scanDataOffset;
+    for (const sk_sp<SkData>& band : bands) {
+        if (!band || !find_scan(*band, &frameHeightOffset, &scanDataOffset)) {
+            return true;
+        }
+    }
+
+    // The first band's header, with the frame height patched to the image's height.
+    const sk_sp<SkData>& first = bands[0];
+    SkAssertResult(find_scan(*first, &frameHeightOffset, &scanDataOffset));
+    const uint8_t height[] = {(uint8_t)(src.height() >> 8), (uint8_t)(src.height() & 0xFF)};
+    if (!dst->write(first->bytes(), frameHeightOffset) || !dst->write(height, sizeof(height)) ||
+        !dst->write(first->bytes() + frameHeightOffset + sizeof(height),
+                    scanDataOffset - frameHeightOffset - sizeof(height))) {
+        return true;
+    }
+
+    for (int i = 0; i < bandCount; ++i) {
+        find_scan(*bands[i], &frameHeightOffset, &scanDataOffset);
+        if (i > 0) {
+            const uint8_t restart[] = {0xFF, (uint8_t)(kMarkerRST0 + ((i - 1) & 7))};
+            if (!dst->write(restart, sizeof(restart))) {
+                return true;
+            }
+        }
+        const size_t dataSize = bands[i]->size() - kJpegMarkerCodeSize - scanDataOffset;
+        if (!dst->write(bands[i]->bytes() + scanDataOffset, dataSize)) {
+            return true;
+        }
+    }
+    const uint8_t endOfImage[] = {0xFF, kJpegMarkerEndOfImage};
+    *success = dst->write(endOfImage, sizeof(endOfImage));
+    return true;
+}
+
+}  // namespace
+
 namespace SkJpegEncoder {
 
 bool Encode(SkWStream* dst, const SkPixmap& src, const Options& options) {
+    bool success = false;
+    if (options.fExecutor && encode_in_parallel(dst, src, options, &success)) {
+        return success;
+    }
     auto encoder = Make(dst, src, options);
     return encoder.get() && encoder->encodeRows(src.height());
 }
@@ -27,13 +27,17 @@
 #include "modules/skcms/skcms.h"
 #include "src/base/SkMSAN.h"
 #include "src/codec/SkPngPriv.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/encode/SkImageEncoderFns.h"
 #include "src/encode/SkImageEncoderPriv.h"
 #include "src/image/SkImage_Base.h"
 
 #include <algorithm>
+#include <atomic>
 #include <csetjmp>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -41,6 +45,7 @@
 
 #include <png.h>
 #include <pngconf.h>
+#include <zlib.h>
 
 class GrDirectContext;
 class SkImage;
@@ -438,7 +443,7 @@ bool SkPngEncoderImpl::onEncodeRows(int numRows) {
         return false;
     }
 
-    const void* srcRow = fSrc.addr(0, fCurrRow);
+    const void* srcRow = this->srcRowAddr(fCurrRow);
     for (int y = 0; y < numRows; y++) {
         sk_msan_assert_initialized(srcRow,
                                    (const uint8_t*)srcRow + (fSrc.width() << fSrc.shiftPerPixel()));
@@ -449,7 +454,7 @@ bool SkPngEncoderImpl::onEncodeRows(int numRows) {
 
         png_bytep rowPtr = (png_bytep)fStorage.get();
         png_write_rows(fEncoderMgr->pngPtr(), &rowPtr, 1);
-        srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
+        srcRow = SkTAddOffset<const void>(srcRow, this->srcRowBytes());
     }
 
     fCurrRow += numRows;
@@ -460,8 +465,10 @@ bool SkPngEncoderImpl::onEncodeRows(int numRows) {
     return true;
 }
 
-namespace SkPngEncoder {
-std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Options& options) {
+// Writes everything up to the image data, and returns the manager ready to encode rows.
+static std::unique_ptr<SkPngEncoderMgr> make_encoder_mgr(SkWStream* dst,
+                                                         const SkPixmap& src,
+                                                         const SkPngEncoder::Options& options) {
     if (!SkPixmapIsValid(src)) {
         return nullptr;
     }
@@ -484,13 +491,307 @@ std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Optio
     }
 
     encoderMgr->chooseProc(src.info());
+    return encoderMgr;
+}
+
+namespace {
+
+// Parallel encoding. Each band of rows is filtered and deflated on its own, as a raw deflate
+// stream primed with the last 32K of the previous band's filtered bytes (pigz style). Bands other
+// than the last end with a sync flush, which byte-aligns the output without ending the stream, so
+// the bands concatenate into one deflate stream. That is wrapped in a zlib header and a combined
+// adler32 and written as IDAT chunks.
+
+// Bands are at least this big, so the cost of restarting the compressor stays small.
+constexpr size_t kMinBandBytes = 256 * 1024;
+constexpr int kMaxBands = 64;
+constexpr size_t kDeflateWindowSize = 32768;
+
+// Must not exceed 2^31 - 1, the maximum png chunk length.
+constexpr size_t kMaxIDATSize = 1 << 30;
+
+uint8_t paeth_predictor(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return (uint8_t)a;
+    }
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// Writes the filter type byte followed by the filtered row. |prev| is all zeros for the first row.
+void filter_row(int filter, const uint8_t* row, const uint8_t* prev, size_t length, int bpp,
+                uint8_t* out) {
+    *out++ = (uint8_t)filter;
+    const size_t head = std::min(length, (size_t)bpp);
+    switch (filter) {
+        case PNG_FILTER_VALUE_SUB:
+            memcpy(out, row, head);
+            for (size_t i = head; i < length; ++i) {
+                out[i] = (uint8_t)(row[i] - row[i - bpp]);
+            }
+            break;
+        case PNG_FILTER_VALUE_UP:
+            for (size_t i = 0; i < length; ++i) {
+                out[i] = (uint8_t)(row[i] - prev[i]);
+            }
+            break;
+        case PNG_FILTER_VALUE_AVG:
+            for (size_t i = 0; i < head; ++i) {
+                out[i] = (uint8_t)(row[i] - (prev[i] >> 1));
+            }
+            for (size_t i = head; i < length; ++i) {
+                out[i] = (uint8_t)(row[i] - ((row[i - bpp] + prev[i]) >> 1));
+            }
+            break;
+        case PNG_FILTER_VALUE_PAETH:
+            for (size_t i = 0; i < head; ++i) {
+                out[i] = (uint8_t)(row[i] - prev[i]);
+            }
+            for (size_t i = head; i < length; ++i) {
+                out[i] = (uint8_t)(row[i] - paeth_predictor(row[i - bpp], prev[i], prev[i - bpp]));
+            }
+            break;
+        default:
+            memcpy(out, row, length);
+            break;
+    }
+}
+
+// Filters one row with each allowed filter, and keeps the one whose bytes, taken as signed, have
+// the smallest sum of magnitudes. This is the heuristic libpng uses.
+void filter_row_adaptive(int filterFlags, const uint8_t* row, const uint8_t* prev, size_t length,
+                         int bpp, uint8_t* out, uint8_t* scratch) {
+    static constexpr int kFilters[] = {PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP,
+                                       PNG_FILTER_AVG, PNG_FILTER_PAETH};
+    int allowed = 0;
+    for (int flag : kFilters) {
+        allowed += (filterFlags & flag) ? 1 : 0;
+    }
+    if (allowed <= 1) {
+        int filter = PNG_FILTER_VALUE_NONE;
+        for (int i = 0; i < 5; ++i) {
+            if (filterFlags & kFilters[i]) {
+                filter = i;
+            }
+        }
+        filter_row(filter, row, prev, length, bpp, out);
+        return;
+    }
+
+    uint64_t bestCost = UINT64_MAX;
+    for (int i = 0; i < 5; ++i) {
+        if (!(filterFlags & kFilters[i])) {
+            continue;
+        }
+        filter_row(i, row, prev, length, bpp, scratch);
+        uint64_t cost = 0;
+        for (size_t j = 1; j <= length; ++j) {
+            cost += scratch[j] < 128 ? scratch[j] : 256 - scratch[j];
+        }
+        if (cost < bestCost) {
+            bestCost = cost;
+            memcpy(out, scratch, length + 1);
+        }
+    }
+}
+
+struct DeflatedBand {
+    std::vector<uint8_t> fData;
+    uLong                fAdler = 0;
+    size_t               fLength = 0;  // of the filtered bytes
+};
+
+bool deflate_band(const SkPixmap& src,
+                  transform_scanline_proc proc,
+                  int pngBytesPerPixel,
+                  const SkPngEncoder::Options& options,
+                  int top,
+                  int bottom,
+                  DeflatedBand* band) {
+    const size_t pngRowBytes = (size_t)src.width() * pngBytesPerPixel;
+    const size_t filteredRowBytes = pngRowBytes + 1;
+    const int srcBpp = SkColorTypeBytesPerPixel(src.colorType());
+    const int filterBpp = std::max(1, pngBytesPerPixel);
+    const int filterFlags = (int)options.fFilterFlags & (int)SkPngEncoder::FilterFlag::kAll;
+
+    // Filter enough of the previous band to prime the compressor with, along with this band.
+    const int dictionaryRows = (int)std::min<size_t>(
+            top, (kDeflateWindowSize + filteredRowBytes - 1) / filteredRowBytes);
+    const int firstRow = top - dictionaryRows;
+    std::vector<uint8_t> filtered((size_t)(bottom - firstRow) * filteredRowBytes);
+    std::vector<uint8_t> rows(2 * pngRowBytes, 0);
+    std::vector<uint8_t> scratch(filteredRowBytes);
+    uint8_t* prev = rows.data();
+    uint8_t* curr = rows.data() + pngRowBytes;
+    if (firstRow > 0) {
+        proc((char*)prev, (const char*)src.addr(0, firstRow - 1), src.width(), srcBpp);
+    }
+    for (int y = firstRow; y < bottom; ++y) {
+        proc((char*)curr, (const char*)src.addr(0, y), src.width(), srcBpp);
+        filter_row_adaptive(filterFlags, curr, prev, pngRowBytes, filterBpp,
+                            filtered.data() + (size_t)(y - firstRow) * filteredRowBytes,
+                            scratch.data());
+        std::swap(prev, curr);
+    }
+
+    const uint8_t* input = filtered.data() + (size_t)dictionaryRows * filteredRowBytes;
+    band->fLength = (size_t)(bottom - top) * filteredRowBytes;
+    band->fAdler = adler32(adler32(0, nullptr, 0), input, (uInt)band->fLength);
+
+    z_stream stream = {};
+    const int level = std::min(std::max(0, options.fZLibLevel), 9);
+    const int strategy = filterFlags == (int)SkPngEncoder::FilterFlag::kNone ? Z_DEFAULT_STRATEGY
+                                                                              : Z_FILTERED;
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, strategy) != Z_OK) {
+        return false;
+    }
+    bool ok = true;
+    if (dictionaryRows > 0) {
+        const size_t dictionaryBytes =
+                std::min((size_t)dictionaryRows * filteredRowBytes, kDeflateWindowSize);
+        ok = deflateSetDictionary(&stream, input - dictionaryBytes, (uInt)dictionaryBytes) == Z_OK;
+    }
 
+    // Room for the worst case, plus the empty stored block written by a sync flush.
+    band->fData.resize(deflateBound(&stream, band->fLength) + 16);
+    stream.next_in = const_cast<uint8_t*>(input);
+    stream.avail_in = (uInt)band->fLength;
+    stream.next_out = band->fData.data();
+    stream.avail_out = (uInt)band->fData.size();
+    const bool last = bottom == src.height();
+    if (ok) {
+        const int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        ok = (last ? result == Z_STREAM_END : result == Z_OK) && stream.avail_in == 0 &&
+             stream.avail_out > 0;
+    }
+    band->fData.resize(band->fData.size() - stream.avail_out);
+    deflateEnd(&stream);
+    return ok;
+}
+
+void write_u32(uint8_t* dst, uint32_t value) {
+    dst[0] = (uint8_t)(value >> 24);
+    dst[1] = (uint8_t)(value >> 16);
+    dst[2] = (uint8_t)(value >> 8);
+    dst[3] = (uint8_t)(value);
+}
+
+bool write_chunk(SkWStream* dst, const char type[4], const uint8_t* data, size_t length) {
+    uint8_t header[8];
+    write_u32(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+    uLong crc = crc32(crc32(0, nullptr, 0), header + 4, 4);
+    if (length) {
+        crc = crc32(crc, data, (uInt)length);
+    }
+    uint8_t footer[4];
+    write_u32(footer, (uint32_t)crc);
+    return dst->write(header, sizeof(header)) && (!length || dst->write(data, length)) &&
+           dst->write(footer, sizeof(footer));
+}
+
+bool write_idat(SkWStream* dst, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        const size_t chunk = std::min(length, kMaxIDATSize);
+        if (!write_chunk(dst, "IDAT", data, chunk)) {
+            return false;
+        }
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+// Returns false if the image is not worth splitting, in which case nothing has been written.
+bool encode_in_parallel(SkWStream* dst, const SkPixmap& src, SkPngEncoderMgr* encoderMgr,
+                        const SkPngEncoder::Options& options, bool* success) {
+    // libpng strips the filler from opaque F16 rows as it writes them; keep those on that path.
+    if (kRGBA_F16_SkColorType == src.colorType() && kOpaque_SkAlphaType == src.alphaType()) {
+        return false;
+    }
+    if (!encoderMgr->proc()) {
+        return false;
+    }
+    const size_t filteredRowBytes = (size_t)src.width() * encoderMgr->pngBytesPerPixel() + 1;
+    const int bandRows = (int)std::max<size_t>(
+            {(size_t)1, kMinBandBytes / filteredRowBytes,
+             ((size_t)src.height() + kMaxBands - 1) / kMaxBands});
+    const int bandCount = (src.height() + bandRows - 1) / bandRows;
+    if (bandCount < 2) {
+        return false;
+    }
+
+    std::vector<DeflatedBand> bands(bandCount);
+    std::atomic<bool> succeeded{true};
+    {
+        SkTaskGroup tasks(*options.fExecutor);
+        for (int i = 0; i < bandCount; ++i) {
+            tasks.add([&, i] {
+                const int top = i * bandRows;
+                const int bottom = std::min(top + bandRows, src.height());
+                if (!deflate_band(src, encoderMgr->proc(), encoderMgr->pngBytesPerPixel(), options,
+                                  top, bottom, &bands[i])) {
+                    succeeded = false;
+                }
+            });
+        }
+        tasks.wait();
+    }
+    if (!succeeded) {
+        *success = false;
+        return true;
+    }
+
+    // The zlib header: deflate with a 32K window, no preset dictionary, and the compression level
+    // hint zlib itself would write.
+    const int level = std::min(std::max(0, options.fZLibLevel), 9);
+    const int levelHint = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    uint8_t header[2] = {0x78, (uint8_t)(levelHint << 6)};
+    header[1] += (uint8_t)(31 - ((header[0] << 8) + header[1]) % 31);
+
+    uLong adler = adler32(0, nullptr, 0);
+    for (const DeflatedBand& band : bands) {
+        adler = adler32_combine(adler, band.fAdler, (z_off_t)band.fLength);
+    }
+    uint8_t trailer[4];
+    write_u32(trailer, (uint32_t)adler);
+
+    bool ok = write_chunk(dst, "IDAT", header, sizeof(header));
+    for (const DeflatedBand& band : bands) {
+        ok = ok && write_idat(dst, band.fData.data(), band.fData.size());
+    }
+    ok = ok && write_chunk(dst, "IDAT", trailer, sizeof(trailer)) &&
+         write_chunk(dst, "IEND", nullptr, 0);
+    *success = ok;
+    return true;
+}
+
+}  // namespace
+
+namespace SkPngEncoder {
+std::unique_ptr<SkEncoder> Make(SkWStream* dst, const SkPixmap& src, const Options& options) {
+    std::unique_ptr<SkPngEncoderMgr> encoderMgr = make_encoder_mgr(dst, src, options);
+    if (!encoderMgr) {
+        return nullptr;
+    }
     return std::make_unique<SkPngEncoderImpl>(std::move(encoderMgr), src);
 }
 
 bool Encode(SkWStream* dst, const SkPixmap& src, const Options& options) {
-    auto encoder = Make(dst, src, options);
-    return encoder.get() && encoder->encodeRows(src.height());
+    std::unique_ptr<SkPngEncoderMgr> encoderMgr = make_encoder_mgr(dst, src, options);
+    if (!encoderMgr) {
+        return false;
+    }
+    bool success = false;
+    if (options.fExecutor &&
+        encode_in_parallel(dst, src, encoderMgr.get(), options, &success)) {
+        return success;
+    }
+    SkPngEncoderImpl encoder(std::move(encoderMgr), src);
+    return encoder.encodeRows(src.height());
 }
 
 sk_sp<SkData> Encode(GrDirectContext* ctx, const SkImage* img, const Options& options) {
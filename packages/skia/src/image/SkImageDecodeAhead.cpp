@@ -0,0 +1,203 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkImageDecodeAhead.h"
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkRSXform.h"
+#include "include/core/SkRect.h"
+#include "include/private/base/SkMutex.h"
+#include "src/core/SkBitmapCache.h"
+#include "src/core/SkTHash.h"
+#include "src/core/SkTaskGroup.h"
+#include "src/image/SkImage_Base.h"
+#include "src/image/SkImage_Lazy.h"
+
+#include <atomic>
+#include <utility>
+
+using namespace skia_private;
+
+class SkImageDecodeAhead::Impl {
+public:
+    explicit Impl(SkExecutor* executor)
+            : fCounters(sk_make_sp<SkDecodeAheadCounters>())
+            , fTasks(*executor) {}
+
+    bool queue(sk_sp<SkImage> image) {
+        const SkImage_Base* base = as_IB(image);
+        if (!base || (base->type() != SkImage_Base::Type::kLazy &&
+                      base->type() != SkImage_Base::Type::kLazyPicture)) {
+            return false;
+        }
+        const auto* lazy = static_cast<const SkImage_Lazy*>(base);
+        if (lazy->generator()->isTextureGenerator()) {
+            return false;
+        }
+
+        SkBitmap cached;
+        if (SkBitmapCache::Find(SkBitmapCacheDesc::Make(lazy), &cached)) {
+            fAlreadyDecoded++;
+            return false;
+        }
+        {
+            SkAutoMutexExclusive lock(fInFlightMutex);
+            if (fInFlight.contains(lazy->uniqueID())) {
+                return false;
+            }
+            fInFlight.add(lazy->uniqueID());
+        }
+
+        fTasks.add([this, image = std::move(image), lazy] {
+            switch (lazy->decodeAhead(fCounters.get())) {
+                case SkImage_Lazy::DecodeAheadResult::kDecoded:
+                    fDecoded++;
+                    break;
+                case SkImage_Lazy::DecodeAheadResult::kAlreadyDecoded:
+                    fAlreadyDecoded++;
+                    break;
+                case SkImage_Lazy::DecodeAheadResult::kFailed:
+                    fFailed++;
+                    break;
+            }
+            SkAutoMutexExclusive lock(fInFlightMutex);
+            fInFlight.remove(lazy->uniqueID());
+        });
+        return true;
+    }
+
+    void wait() { fTasks.wait(); }
+
+    Stats stats() const {
+        Stats stats;
+        stats.fDecoded = fDecoded.load();
+        stats.fAlreadyDecoded = fAlreadyDecoded.load();
+        stats.fFailed = fFailed.load();
+        stats.fHits = fCounters->fHits.load();
+        stats.fWasted = fCounters->fWasted.load();
+        return stats;
+    }
+
+private:
+    const sk_sp<SkDecodeAheadCounters> fCounters;
+
+    // The unique IDs of the images queued and not yet decoded.
+    SkMutex                            fInFlightMutex;
+    THashSet<uint32_t>                 fInFlight SK_GUARDED_BY(fInFlightMutex);
+
+    std::atomic<int>                   fDecoded{0};
+    std::atomic<int>                   fAlreadyDecoded{0};
+    std::atomic<int>                   fFailed{0};
+
+    // Declared last, so that it waits for the tasks before anything they use is destroyed.
+    SkTaskGroup                        fTasks;
+};
+
+namespace {
+
+// Plays back a picture, queuing the images it draws instead of drawing anything.
+class DecodeAheadCanvas final : public SkCanvas {
+public:
+    DecodeAheadCanvas(SkImageDecodeAhead* decodeAhead, const SkIRect& bounds)
+            : SkCanvas(bounds.width(), bounds.height())
+            , fDecodeAhead(decodeAhead) {
+        this->translate(-bounds.left(), -bounds.top());
+    }
+
+    int queued() const { return fQueued; }
+
+protected:
+    void onDrawImage2(const SkImage* image, SkScalar x, SkScalar y, const SkSamplingOptions&,
+                      const SkPaint*) override {
+        this->queue(image, SkRect::MakeXYWH(x, y, image->width(), image->height()));
+    }
+
+    void onDrawImageRect2(const SkImage* image, const SkRect&, const SkRect& dst,
+                          const SkSamplingOptions&, const SkPaint*, SrcRectConstraint) override {
+        this->queue(image, dst);
+    }
+
+    void onDrawImageLattice2(const SkImage* image, const Lattice&, const SkRect& dst,
+                             SkFilterMode, const SkPaint*) override {
+        this->queue(image, dst);
+    }
+
+    void onDrawAtlas2(const SkImage* image, const SkRSXform xforms[], const SkRect tex[],
+                      const SkColor[], int count, SkBlendMode, const SkSamplingOptions&,
+                      const SkRect* cull, const SkPaint*) override {
+        SkRect bounds = SkRect::MakeEmpty();
+        if (cull) {
+            bounds = *cull;
+        } else {
+            for (int i = 0; i < count; ++i) {
+                SkPoint quad[4];
+                xforms[i].toQuad(tex[i].width(), tex[i].height(), quad);
+                SkRect quadBounds;
+                quadBounds.setBounds(quad, 4);
+                bounds.join(quadBounds);
+            }
+        }
+        this->queue(image, bounds);
+    }
+
+    void onDrawEdgeAAImageSet2(const ImageSetEntry imageSet[], int count, const SkPoint[],
+                               const SkMatrix[], const SkSamplingOptions&, const SkPaint*,
+                               SrcRectConstraint) override {
+        // The entries' own transforms are ignored, which at worst queues an image that is not
+        // visible.
+        for (int i = 0; i < count; ++i) {
+            this->queue(imageSet[i].fImage.get(), imageSet[i].fDstRect);
+        }
+    }
+
+private:
+    void queue(const SkImage* image, const SkRect& dst) {
+        if (image && !this->quickReject(dst) && fDecodeAhead->queue(sk_ref_sp(image))) {
+            fQueued++;
+        }
+    }
+
+    SkImageDecodeAhead* fDecodeAhead;
+    int                 fQueued = 0;
+};
+
+}  // namespace
+
+SkImageDecodeAhead::SkImageDecodeAhead(SkExecutor* executor)
+        : fImpl(std::make_unique<Impl>(executor)) {}
+
+SkImageDecodeAhead::~SkImageDecodeAhead() {
+    fImpl->wait();
+}
+
+bool SkImageDecodeAhead::queue(sk_sp<SkImage> image) {
+    return fImpl->queue(std::move(image));
+}
+
+int SkImageDecodeAhead::queue(const SkPicture* picture) {
+    if (!picture) {
+        return 0;
+    }
+    const SkIRect bounds = picture->cullRect().roundOut();
+    if (bounds.isEmpty()) {
+        return 0;
+    }
+    DecodeAheadCanvas canvas(this, bounds);
+    picture->playback(&canvas);
+    return canvas.queued();
+}
+
+void SkImageDecodeAhead::wait() {
+    fImpl->wait();
+}
+
+SkImageDecodeAhead::Stats SkImageDecodeAhead::stats() const {
+    return fImpl->stats();
+}
@@ -137,6 +137,7 @@ public:
     enum class Type {
         kRaster,
         kRasterPinnable,
+        kRasterYUVA,
         kLazy,
         kLazyPicture,
         kGanesh,
@@ -104,14 +104,35 @@ SkImage_Lazy::SkImage_Lazy(Validator* validator)
     SkASSERT(fSharedGenerator);
 }
 
+SkImage_Lazy::~SkImage_Lazy() {
+    if (SkDecodeAheadCounters* counters = fDecodedAhead.exchange(nullptr)) {
+        counters->fWasted++;
+        counters->unref();
+    }
+}
+
 bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
                                SkImage::CachingHint chint) const {
+    bool foundInCache;
+    if (!this->getROPixels(ctx, bitmap, chint, &foundInCache, nullptr)) {
+        return false;
+    }
+    if (fDecodedAhead.load(std::memory_order_relaxed)) {
+        this->countDecodedAheadRead(foundInCache);
+    }
+    return true;
+}
+
+bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
+                               SkImage::CachingHint chint, bool* foundInCache,
+                               SkDecodeAheadCounters* decodeAheadCounters) const {
     auto check_output_bitmap = [bitmap]() {
         SkASSERT(bitmap->isImmutable());
         SkASSERT(bitmap->getPixels());
         (void)bitmap;
     };
 
+    *foundInCache = true;
     auto desc = SkBitmapCacheDesc::Make(this);
     if (SkBitmapCache::Find(desc, bitmap)) {
         check_output_bitmap();
@@ -120,18 +141,33 @@ bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
 
     if (SkImage::kAllow_CachingHint == chint) {
         SkPixmap pmap;
-        SkBitmapCache::RecPtr cacheRec = SkBitmapCache::Alloc(desc, this->imageInfo(), &pmap);
-        if (!cacheRec) {
-            return false;
-        }
+        SkBitmapCache::RecPtr cacheRec;
         bool success = false;
         {   // make sure ScopedGenerator goes out of scope before we try readPixelsProxy
-            success = ScopedGenerator(fSharedGenerator)->getPixels(pmap);
+            ScopedGenerator generator(fSharedGenerator);
+            // Another thread may have decoded the image while we waited for the generator. It
+            // adds the pixels to the cache before releasing the generator, so they are there now.
+            if (SkBitmapCache::Find(desc, bitmap)) {
+                check_output_bitmap();
+                return true;
+            }
+            cacheRec = SkBitmapCache::Alloc(desc, this->imageInfo(), &pmap);
+            if (!cacheRec) {
+                return false;
+            }
+            success = generator->getPixels(pmap);
+            if (success) {
+                this->setDecodedAhead(decodeAheadCounters);
+                SkBitmapCache::Add(std::move(cacheRec), bitmap);
+            }
         }
-        if (!success && !this->readPixelsProxy(ctx, pmap)) {
-            return false;
+        if (!success) {
+            if (!this->readPixelsProxy(ctx, pmap)) {
+                return false;
+            }
+            this->setDecodedAhead(decodeAheadCounters);
+            SkBitmapCache::Add(std::move(cacheRec), bitmap);
         }
-        SkBitmapCache::Add(std::move(cacheRec), bitmap);
         this->notifyAddedToRasterCache();
     } else {
         if (!bitmap->tryAllocPixels(this->imageInfo())) {
@@ -146,10 +182,44 @@ bool SkImage_Lazy::getROPixels(GrDirectContext* ctx, SkBitmap* bitmap,
         }
         bitmap->setImmutable();
     }
+    *foundInCache = false;
     check_output_bitmap();
     return true;
 }
 
+SkImage_Lazy::DecodeAheadResult SkImage_Lazy::decodeAhead(
+        SkDecodeAheadCounters* counters) const {
+    SkBitmap bitmap;
+    bool foundInCache;
+    if (!this->getROPixels(nullptr, &bitmap, SkImage::kAllow_CachingHint, &foundInCache,
+                           counters)) {
+        return DecodeAheadResult::kFailed;
+    }
+    return foundInCache ? DecodeAheadResult::kAlreadyDecoded : DecodeAheadResult::kDecoded;
+}
+
+void SkImage_Lazy::setDecodedAhead(SkDecodeAheadCounters* counters) const {
+    if (!counters) {
+        return;
+    }
+    // If pixels decoded ahead earlier have not been read yet, they must have been purged.
+    if (SkDecodeAheadCounters* previous = fDecodedAhead.exchange(SkRef(counters))) {
+        previous->fWasted++;
+        previous->unref();
+    }
+}
+
+void SkImage_Lazy::countDecodedAheadRead(bool foundInCache) const {
+    if (SkDecodeAheadCounters* counters = fDecodedAhead.exchange(nullptr)) {
+        if (foundInCache) {
+            counters->fHits++;
+        } else {
+            counters->fWasted++;
+        }
+        counters->unref();
+    }
+}
+
 sk_sp<SharedGenerator> SkImage_Lazy::generator() const {
     return fSharedGenerator;
 }
@@ -19,6 +19,7 @@
 #include "include/private/base/SkMutex.h"
 #include "src/image/SkImage_Base.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -35,6 +36,13 @@ struct SkIRect;
 
 namespace skgpu { namespace graphite { class Recorder; } }
 
+// Counts how the images decoded by an SkImageDecodeAhead are used. It outlives the
+// SkImageDecodeAhead, as the images may be drawn (or deleted) after it is gone.
+struct SkDecodeAheadCounters final : public SkNVRefCnt<SkDecodeAheadCounters> {
+    std::atomic<int> fHits{0};
+    std::atomic<int> fWasted{0};
+};
+
 class SkImage_Lazy : public SkImage_Base {
 public:
     struct Validator {
@@ -49,6 +57,7 @@ public:
     };
 
     SkImage_Lazy(Validator* validator);
+    ~SkImage_Lazy() override;
 
     // From SkImage.h
     bool isValid(GrRecordingContext*) const override;
@@ -68,6 +77,17 @@ public:
                                 RequiredProperties) const override;
 
     bool getROPixels(GrDirectContext*, SkBitmap*, CachingHint) const override;
+
+    enum class DecodeAheadResult {
+        kDecoded,
+        kAlreadyDecoded,
+        kFailed,
+    };
+    // Decodes the image into the raster cache. If it was not there already, the next read of
+    // the pixels is counted in |counters| as a hit if it finds them in the cache, and as wasted
+    // otherwise.
+    DecodeAheadResult decodeAhead(SkDecodeAheadCounters* counters) const;
+
     SkImage_Base::Type type() const override { return SkImage_Base::Type::kLazy; }
     sk_sp<SkImage> onMakeColorTypeAndColorSpace(SkColorType, sk_sp<SkColorSpace>,
                                                 GrDirectContext*) const override;
@@ -88,6 +108,18 @@ private:
 
     class ScopedGenerator;
 
+    // As getROPixels(), but also reports whether the pixels were found in the cache. If they are
+    // decoded and added to the cache, and |decodeAheadCounters| is not null, they are marked as
+    // decoded ahead before other threads can find them.
+    bool getROPixels(GrDirectContext*, SkBitmap*, CachingHint, bool* foundInCache,
+                     SkDecodeAheadCounters* decodeAheadCounters) const;
+
+    // Marks the pixels in the cache as decoded ahead for |counters|.
+    void setDecodedAhead(SkDecodeAheadCounters* counters) const;
+
+    // Counts the first read of pixels that were decoded ahead.
+    void countDecodedAheadRead(bool foundInCache) const;
+
     // Note that this->imageInfo() is not necessarily the info from the generator. It may be
     // cropped by onMakeSubset and its color type/space may be changed by
     // onMakeColorTypeAndColorSpace.
@@ -100,6 +132,9 @@ private:
     // When the SkImage_Lazy goes away, we will iterate over all the listeners to inform them
     // of the unique ID's demise. This is used to remove cached textures from GrContext.
     mutable SkIDChangeListener::List fUniqueIDListeners;
+    // Set (and owns a ref) when decodeAhead() puts the pixels in the cache, until they are next
+    // read.
+    mutable std::atomic<SkDecodeAheadCounters*> fDecodedAhead{nullptr};
 };
 
 // Ref-counted tuple(SkImageGenerator, SkMutex) which allows sharing one generator among N images
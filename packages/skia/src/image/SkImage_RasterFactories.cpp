@@ -7,17 +7,20 @@
 
 #include "include/core/SkAlphaType.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkColorSpace.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkYUVAPixmaps.h"
 #include "include/private/base/SkMath.h"
 #include "src/core/SkCompressedDataUtils.h"
 #include "src/core/SkImagePriv.h"
 #include "src/image/SkImage_Base.h"
 #include "src/image/SkImage_Raster.h"
+#include "src/image/SkImage_RasterYUVA.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -92,6 +95,19 @@ sk_sp<SkImage> RasterFromData(const SkImageInfo& info, sk_sp<SkData> data, size_
     return sk_make_sp<SkImage_Raster>(info, std::move(data), rowBytes);
 }
 
+sk_sp<SkImage> RasterFromYUVAPixmaps(const SkYUVAPixmaps& yuvaPixmaps,
+                                     sk_sp<SkColorSpace> imageColorSpace) {
+    if (!yuvaPixmaps.isValid()) {
+        return nullptr;
+    }
+    SkYUVAPixmaps pixmaps = yuvaPixmaps.ownsStorage() ? yuvaPixmaps
+                                                      : SkYUVAPixmaps::MakeCopy(yuvaPixmaps);
+    if (!pixmaps.isValid()) {
+        return nullptr;
+    }
+    return sk_make_sp<SkImage_RasterYUVA>(std::move(pixmaps), std::move(imageColorSpace));
+}
+
 // TODO: this could be improved to decode and make use of the mipmap
 // levels potentially present in the compressed data. For now, any
 // mipmap levels are discarded.
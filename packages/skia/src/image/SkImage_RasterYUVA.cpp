@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/image/SkImage_RasterYUVA.h"
+
+#include "include/core/SkAlphaType.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkShader.h"
+#include "include/core/SkSurfaceProps.h"
+#include "include/core/SkTileMode.h"
+#include "include/core/SkYUVAInfo.h"
+#include "src/base/SkArenaAlloc.h"
+#include "src/core/SkBitmapCache.h"
+#include "src/core/SkEffectPriv.h"
+#include "src/core/SkRasterPipeline.h"
+#include "src/core/SkRasterPipelineOpContexts.h"
+#include "src/core/SkRasterPipelineOpList.h"
+#include "src/shaders/SkShaderBase.h"
+
+#include <utility>
+
+static SkImageInfo make_info(const SkYUVAPixmaps& pixmaps, sk_sp<SkColorSpace> colorSpace) {
+    const SkYUVAInfo& yuvaInfo = pixmaps.yuvaInfo();
+    return SkImageInfo::Make(yuvaInfo.dimensions(),
+                             SkYUVAPixmaps::RecommendedRGBAColorType(pixmaps.dataType()),
+                             yuvaInfo.hasAlpha() ? kPremul_SkAlphaType : kOpaque_SkAlphaType,
+                             std::move(colorSpace));
+}
+
+SkImage_RasterYUVA::SkImage_RasterYUVA(SkYUVAPixmaps pixmaps, sk_sp<SkColorSpace> colorSpace)
+        : SkImage_Base(make_info(pixmaps, std::move(colorSpace)), kNeedNewImageUniqueID)
+        , fPixmaps(std::move(pixmaps)) {
+    SkASSERT(fPixmaps.isValid() && fPixmaps.ownsStorage());
+}
+
+bool SkImage_RasterYUVA::convertPixels(const SkPixmap& dst, int srcX, int srcY) const {
+    SkASSERT(dst.colorType() == this->colorType() && dst.alphaType() == this->alphaType());
+
+    const SkMatrix localMatrix = SkMatrix::Translate(-srcX, -srcY);
+    sk_sp<SkShader> shader = this->makeShader(SkTileMode::kClamp, SkTileMode::kClamp,
+                                              SkSamplingOptions(), &localMatrix);
+
+    SkSTArenaAlloc<2048> alloc;
+    SkRasterPipeline p(&alloc);
+    p.append(SkRasterPipelineOp::seed_shader);
+
+    const SkSurfaceProps props;
+    const SkStageRec rec = {&p, &alloc, dst.colorType(), dst.colorSpace(), SkColors::kBlack, props};
+    if (!shader || !as_SB(shader)->appendRootStages(rec, SkMatrix::I())) {
+        return false;
+    }
+
+    SkRasterPipeline_MemoryCtx dstCtx = {dst.writable_addr(), (int)dst.rowBytesAsPixels()};
+    p.append_store(dst.colorType(), &dstCtx);
+    p.run(0, 0, dst.width(), dst.height());
+    return true;
+}
+
+bool SkImage_RasterYUVA::onReadPixels(GrDirectContext*,
+                                      const SkImageInfo& dstInfo,
+                                      void* dstPixels,
+                                      size_t dstRowBytes,
+                                      int srcX,
+                                      int srcY,
+                                      CachingHint chint) const {
+    SkBitmap bitmap;
+    return this->getROPixels(nullptr, &bitmap, chint) &&
+           bitmap.readPixels(dstInfo, dstPixels, dstRowBytes, srcX, srcY);
+}
+
+bool SkImage_RasterYUVA::getROPixels(GrDirectContext*,
+                                     SkBitmap* bitmap,
+                                     CachingHint chint) const {
+    const SkBitmapCacheDesc desc = SkBitmapCacheDesc::Make(this);
+    if (SkBitmapCache::Find(desc, bitmap)) {
+        return true;
+    }
+
+    if (chint == kAllow_CachingHint) {
+        SkPixmap pmap;
+        SkBitmapCache::RecPtr cacheRec = SkBitmapCache::Alloc(desc, this->imageInfo(), &pmap);
+        if (!cacheRec || !this->convertPixels(pmap, 0, 0)) {
+            return false;
+        }
+        SkBitmapCache::Add(std::move(cacheRec), bitmap);
+        this->notifyAddedToRasterCache();
+    } else {
+        if (!bitmap->tryAllocPixels(this->imageInfo()) ||
+            !this->convertPixels(bitmap->pixmap(), 0, 0)) {
+            return false;
+        }
+        bitmap->setImmutable();
+    }
+    return true;
+}
+
+sk_sp<SkImage> SkImage_RasterYUVA::onMakeSubset(GrDirectContext*, const SkIRect& subset) const {
+    SkBitmap bitmap;
+    if (!bitmap.tryAllocPixels(this->imageInfo().makeDimensions(subset.size())) ||
+        !this->convertPixels(bitmap.pixmap(), subset.left(), subset.top())) {
+        return nullptr;
+    }
+    bitmap.setImmutable();
+    return bitmap.asImage();
+}
+
+sk_sp<SkImage> SkImage_RasterYUVA::onMakeSubset(skgpu::graphite::Recorder*,
+                                                const SkIRect& subset,
+                                                RequiredProperties props) const {
+    sk_sp<SkImage> rgba = this->makeRasterImage(nullptr);
+    return rgba ? rgba->makeSubset(nullptr, subset, props) : nullptr;
+}
+
+sk_sp<SkImage> SkImage_RasterYUVA::onMakeColorTypeAndColorSpace(SkColorType targetCT,
+                                                                sk_sp<SkColorSpace> targetCS,
+                                                                GrDirectContext*) const {
+    SkBitmap bitmap;
+    if (!this->getROPixels(nullptr, &bitmap, kDisallow_CachingHint)) {
+        return nullptr;
+    }
+    return bitmap.asImage()->makeColorTypeAndColorSpace(nullptr, targetCT, std::move(targetCS));
+}
+
+sk_sp<SkImage> SkImage_RasterYUVA::onReinterpretColorSpace(sk_sp<SkColorSpace> newCS) const {
+    return sk_make_sp<SkImage_RasterYUVA>(fPixmaps, std::move(newCS));
+}
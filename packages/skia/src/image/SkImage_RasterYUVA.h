@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkImage_RasterYUVA_DEFINED
+#define SkImage_RasterYUVA_DEFINED
+
+#include "include/core/SkImage.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "src/image/SkImage_Base.h"
+
+#include <cstddef>
+
+class GrDirectContext;
+class GrRecordingContext;
+class SkBitmap;
+class SkColorSpace;
+class SkPixmap;
+enum SkColorType : int;
+struct SkIRect;
+struct SkImageInfo;
+
+namespace skgpu { namespace graphite { class Recorder; } }
+
+/**
+ *  A CPU-backed image that keeps its Y, U, V (and A) planes. SkImageShader samples the planes
+ *  directly (see SkImageShader::appendYUVAStages()). Anything else that needs the pixels gets them
+ *  converted to RGBA by that same shader, and cached.
+ */
+class SkImage_RasterYUVA final : public SkImage_Base {
+public:
+    SkImage_RasterYUVA(SkYUVAPixmaps pixmaps, sk_sp<SkColorSpace> colorSpace);
+
+    const SkYUVAPixmaps& pixmaps() const { return fPixmaps; }
+
+    // From SkImage.h
+    bool isValid(GrRecordingContext*) const override { return true; }
+
+    // From SkImage_Base.h
+    bool onReadPixels(GrDirectContext*, const SkImageInfo&, void*, size_t, int srcX, int srcY,
+                      CachingHint) const override;
+
+    bool getROPixels(GrDirectContext*, SkBitmap*, CachingHint) const override;
+    sk_sp<SkImage> onMakeSubset(GrDirectContext*, const SkIRect&) const override;
+    sk_sp<SkImage> onMakeSubset(skgpu::graphite::Recorder*,
+                                const SkIRect&,
+                                RequiredProperties) const override;
+
+    sk_sp<SkImage> onMakeColorTypeAndColorSpace(SkColorType, sk_sp<SkColorSpace>,
+                                                GrDirectContext*) const override;
+
+    sk_sp<SkImage> onReinterpretColorSpace(sk_sp<SkColorSpace>) const override;
+
+    bool onHasMipmaps() const override { return false; }
+
+    SkImage_Base::Type type() const override { return SkImage_Base::Type::kRasterYUVA; }
+
+private:
+    // Converts the planes to RGBA, starting at (srcX, srcY), into |dst|, which must be in this
+    // image's color space.
+    bool convertPixels(const SkPixmap& dst, int srcX, int srcY) const;
+
+    SkYUVAPixmaps fPixmaps;
+};
+
+#endif  // SkImage_RasterYUVA_DEFINED
@@ -30,6 +30,9 @@ namespace SkOpts {
         gray_to_RGB1          = SK_OPTS_NS::gray_to_RGB1;
         grayA_to_RGBA         = SK_OPTS_NS::grayA_to_RGBA;
         grayA_to_rgbA         = SK_OPTS_NS::grayA_to_rgbA;
+        alpha_to_000A         = SK_OPTS_NS::alpha_to_000A;
+        F16_to_RGBA           = SK_OPTS_NS::F16_to_RGBA;
+        F16_to_BGRA           = SK_OPTS_NS::F16_to_BGRA;
         inverted_CMYK_to_RGB1 = SK_OPTS_NS::inverted_CMYK_to_RGB1;
         inverted_CMYK_to_BGR1 = SK_OPTS_NS::inverted_CMYK_to_BGR1;
 
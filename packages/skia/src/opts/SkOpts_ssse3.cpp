@@ -26,6 +26,9 @@ namespace SkOpts {
         gray_to_RGB1          = ssse3::gray_to_RGB1;
         grayA_to_RGBA         = ssse3::grayA_to_RGBA;
         grayA_to_rgbA         = ssse3::grayA_to_rgbA;
+        alpha_to_000A         = ssse3::alpha_to_000A;
+        F16_to_RGBA           = ssse3::F16_to_RGBA;
+        F16_to_BGRA           = ssse3::F16_to_BGRA;
         inverted_CMYK_to_RGB1 = ssse3::inverted_CMYK_to_RGB1;
         inverted_CMYK_to_BGR1 = ssse3::inverted_CMYK_to_BGR1;
 
@@ -3286,6 +3286,36 @@ STAGE(mipmap_linear_finish, SkRasterPipeline_MipmapCtx* ctx) {
     a = lerp(sk_unaligned_load<F>(ctx->a), a, ctx->lowerWeight);
 }
 
+STAGE(yuva_init, SkRasterPipeline_YUVACtx* ctx) {
+    sk_unaligned_store(ctx->x, r);
+    sk_unaligned_store(ctx->y, g);
+    sk_unaligned_store(ctx->yuva[3], F(1.0f));  // In case there is no alpha plane.
+}
+
+STAGE(yuva_store, SkRasterPipeline_YUVAPlaneCtx* ctx) {
+    const F sampled[] = {r, g, b, a};
+    for (int i = 0; i < 4; ++i) {
+        if (ctx->channel[i] >= 0) {
+            sk_unaligned_store(ctx->yuva->yuva[ctx->channel[i]], sampled[i]);
+        }
+    }
+
+    // Restore the image coords for the next plane.
+    r = sk_unaligned_load<F>(ctx->yuva->x);
+    g = sk_unaligned_load<F>(ctx->yuva->y);
+}
+
+STAGE(yuva_finish, SkRasterPipeline_YUVACtx* ctx) {
+    F Y = sk_unaligned_load<F>(ctx->yuva[0]),
+      U = sk_unaligned_load<F>(ctx->yuva[1]),
+      V = sk_unaligned_load<F>(ctx->yuva[2]);
+    const float* m = ctx->matrix;
+    r = mad(Y,m[ 0], mad(U,m[ 1], mad(V,m[ 2], m[ 4])));
+    g = mad(Y,m[ 5], mad(U,m[ 6], mad(V,m[ 7], m[ 9])));
+    b = mad(Y,m[10], mad(U,m[11], mad(V,m[12], m[14])));
+    a = sk_unaligned_load<F>(ctx->yuva[3]);
+}
+
 STAGE(callback, SkRasterPipeline_CallbackCtx* c) {
     store4(c->rgba,0, r,g,b,a);
     c->fn(c, tail ? tail : N);
@@ -1103,6 +1103,59 @@ static void RGB_to_BGR1_portable(uint32_t dst[], const uint8_t* src, int count)
     }
 #endif
 
+// These are written with skvx rather than intrinsics: compiled once per SK_OPTS_NS, the same code
+// becomes SSSE3, AVX2 (with F16C) or NEON as the target allows.
+/*not static*/ inline void alpha_to_000A(uint32_t dst[], const uint8_t* src, int count) {
+    using U8 = skvx::Vec<16, uint8_t>;
+    while (count >= 16) {
+        (skvx::cast<uint32_t>(U8::Load(src)) << 24).store(dst);
+        src += 16;
+        dst += 16;
+        count -= 16;
+    }
+    for (int i = 0; i < count; i++) {
+        dst[i] = (uint32_t)src[i] << 24;
+    }
+}
+
+// Clamps to [0,1] and rounds to the nearest byte, matching the raster pipeline's store_8888.
+// (Its round-half-to-even and our +0.5 only differ on ties, and the only half that lands on a tie
+// when scaled by 255 is 0.5, where both round up to 128.)
+template <bool kSwapRB, int N>
+static void F16_to_8888_n(uint32_t* dst, const uint64_t* src) {
+    auto rgba = skvx::from_half(skvx::Vec<4*N, uint16_t>::Load(src));
+    auto unorm = skvx::cast<int32_t>(skvx::min(skvx::max(rgba, 0.0f), 1.0f) * 255 + 0.5f);
+    auto px = skvx::cast<uint8_t>(unorm);
+    if constexpr (kSwapRB) {
+        if constexpr (N == 4) {
+            px = skvx::shuffle<2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15>(px);
+        } else {
+            px = skvx::shuffle<2,1,0,3>(px);
+        }
+    }
+    px.store(dst);
+}
+
+template <bool kSwapRB>
+static void F16_to_8888(uint32_t* dst, const uint64_t* src, int count) {
+    while (count >= 4) {
+        F16_to_8888_n<kSwapRB, 4>(dst, src);
+        src += 4;
+        dst += 4;
+        count -= 4;
+    }
+    for (int i = 0; i < count; i++) {
+        F16_to_8888_n<kSwapRB, 1>(dst + i, src + i);
+    }
+}
+
+/*not static*/ inline void F16_to_RGBA(uint32_t* dst, const uint64_t* src, int count) {
+    F16_to_8888</*kSwapRB=*/false>(dst, src, count);
+}
+/*not static*/ inline void F16_to_BGRA(uint32_t* dst, const uint64_t* src, int count) {
+    F16_to_8888</*kSwapRB=*/true>(dst, src, count);
+}
+
 }  // namespace SK_OPTS_NS
 
 #endif // SkSwizzler_opts_DEFINED
@@ -140,12 +140,14 @@
         SkRegisterMatrixTransformImageFilterFlattenable();
         SkRegisterMergeImageFilterFlattenable();
         SkRegisterMorphologyImageFilterFlattenables();
+        SkRegisterParallelImageFilterFlattenable();
         SkRegisterPictureImageFilterFlattenable();
 #ifdef SK_ENABLE_SKSL
         SkRegisterRuntimeImageFilterFlattenable();
 #endif
         SkRegisterShaderImageFilterFlattenable();
         SkRegisterTileImageFilterFlattenable();
+        SkRegisterTiledImageFilterFlattenable();
         SK_REGISTER_FLATTENABLE(SkLocalMatrixImageFilter);
     }
 
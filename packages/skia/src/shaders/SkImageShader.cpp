@@ -19,12 +19,16 @@
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkVM.h"
 #include "src/core/SkWriteBuffer.h"
+#include "src/core/SkYUVAInfoLocation.h"
 #include "src/core/SkYUVMath.h"
 #include "src/image/SkImage_Base.h"
+#include "src/image/SkImage_RasterYUVA.h"
 #include "src/shaders/SkBitmapProcShader.h"
 #include "src/shaders/SkLocalMatrixShader.h"
 #include "src/shaders/SkTransformShader.h"
 
+#include <algorithm>
+
 #if defined(SK_GRAPHITE)
 #include "src/gpu/Blend.h"
 #include "src/gpu/graphite/ImageUtils.h"
@@ -98,6 +102,17 @@ static SkTileMode optimize(SkTileMode tm, int dimension) {
 #endif
 }
 
+// Whether the raster pipeline samples the planes of a raster YUVA image directly, rather than its
+// RGBA pixels. Only clamping tiles the planes the way it would tile the image (a subsampled plane
+// of an odd-sized image overhangs it, and decal would apply per plane), and the planes have no
+// mipmaps.
+static bool samples_yuva_planes(const SkImage* image, SkTileMode tmx, SkTileMode tmy,
+                                const SkSamplingOptions& sampling) {
+    return as_IB(image)->type() == SkImage_Base::Type::kRasterYUVA &&
+           tmx == SkTileMode::kClamp && tmy == SkTileMode::kClamp &&
+           sampling.mipmap == SkMipmapMode::kNone;
+}
+
 // TODO: currently this only *always* used in asFragmentProcessor(), which is excluded on no-gpu
 // builds. No-gpu builds only use needs_subset() in asserts, so release+no-gpu doesn't use it, which
 // can cause builds to fail if unused warnings are treated as errors.
@@ -247,6 +262,11 @@ SkShaderBase::Context* SkImageShader::onMakeContext(const ContextRec& rec,
         sampling = SkSamplingPriv::AnisoFallback(fImage->hasMipmaps());
     }
 
+    // The raster pipeline samples the planes directly; this would convert them to RGBA.
+    if (samples_yuva_planes(fImage.get(), fTileModeX, fTileModeY, sampling)) {
+        return nullptr;
+    }
+
     auto supported = [](const SkSamplingOptions& sampling) {
         const std::tuple<SkFilterMode,SkMipmapMode> supported[] = {
             {SkFilterMode::kNearest, SkMipmapMode::kNone},    // legacy None
@@ -642,6 +662,167 @@ struct MipLevelHelper {
     }
 };
 
+void append_tiling_and_gather(SkRasterPipeline* p,
+                              const MipLevelHelper* level,
+                              SkTileMode tileModeX,
+                              SkTileMode tileModeY) {
+    const bool decalBothAxes = tileModeX == SkTileMode::kDecal && tileModeY == SkTileMode::kDecal;
+
+    if (decalBothAxes) {
+        p->append(SkRasterPipelineOp::decal_x_and_y,  level->decalCtx);
+    } else {
+        switch (tileModeX) {
+            case SkTileMode::kClamp: /* The gather_xxx stage will clamp for us. */
+                break;
+            case SkTileMode::kMirror:
+                p->append(SkRasterPipelineOp::mirror_x, level->limitX);
+                break;
+            case SkTileMode::kRepeat:
+                p->append(SkRasterPipelineOp::repeat_x, level->limitX);
+                break;
+            case SkTileMode::kDecal:
+                p->append(SkRasterPipelineOp::decal_x, level->decalCtx);
+                break;
+        }
+        switch (tileModeY) {
+            case SkTileMode::kClamp: /* The gather_xxx stage will clamp for us. */
+                break;
+            case SkTileMode::kMirror:
+                p->append(SkRasterPipelineOp::mirror_y, level->limitY);
+                break;
+            case SkTileMode::kRepeat:
+                p->append(SkRasterPipelineOp::repeat_y, level->limitY);
+                break;
+            case SkTileMode::kDecal:
+                p->append(SkRasterPipelineOp::decal_y, level->decalCtx);
+                break;
+        }
+    }
+
+    void* ctx = level->gather;
+    switch (level->pm.colorType()) {
+        case kAlpha_8_SkColorType:      p->append(SkRasterPipelineOp::gather_a8,    ctx); break;
+        case kA16_unorm_SkColorType:    p->append(SkRasterPipelineOp::gather_a16,   ctx); break;
+        case kA16_float_SkColorType:    p->append(SkRasterPipelineOp::gather_af16,  ctx); break;
+        case kRGB_565_SkColorType:      p->append(SkRasterPipelineOp::gather_565,   ctx); break;
+        case kARGB_4444_SkColorType:    p->append(SkRasterPipelineOp::gather_4444,  ctx); break;
+        case kR8G8_unorm_SkColorType:   p->append(SkRasterPipelineOp::gather_rg88,  ctx); break;
+        case kR16G16_unorm_SkColorType: p->append(SkRasterPipelineOp::gather_rg1616,ctx); break;
+        case kR16G16_float_SkColorType: p->append(SkRasterPipelineOp::gather_rgf16, ctx); break;
+        case kRGBA_8888_SkColorType:    p->append(SkRasterPipelineOp::gather_8888,  ctx); break;
+
+        case kRGBA_1010102_SkColorType:
+            p->append(SkRasterPipelineOp::gather_1010102, ctx);
+            break;
+
+        case kR16G16B16A16_unorm_SkColorType:
+            p->append(SkRasterPipelineOp::gather_16161616, ctx);
+            break;
+
+        case kRGBA_F16Norm_SkColorType:
+        case kRGBA_F16_SkColorType:     p->append(SkRasterPipelineOp::gather_f16,   ctx); break;
+        case kRGBA_F32_SkColorType:     p->append(SkRasterPipelineOp::gather_f32,   ctx); break;
+
+        case kGray_8_SkColorType:       p->append(SkRasterPipelineOp::gather_a8,    ctx);
+                                        p->append(SkRasterPipelineOp::alpha_to_gray    ); break;
+
+        case kR8_unorm_SkColorType:     p->append(SkRasterPipelineOp::gather_a8,    ctx);
+                                        p->append(SkRasterPipelineOp::alpha_to_red     ); break;
+
+        case kRGB_888x_SkColorType:     p->append(SkRasterPipelineOp::gather_8888,  ctx);
+                                        p->append(SkRasterPipelineOp::force_opaque     ); break;
+
+        case kBGRA_1010102_SkColorType:
+            p->append(SkRasterPipelineOp::gather_1010102, ctx);
+            p->append(SkRasterPipelineOp::swap_rb);
+            break;
+
+        case kRGB_101010x_SkColorType:
+            p->append(SkRasterPipelineOp::gather_1010102, ctx);
+            p->append(SkRasterPipelineOp::force_opaque);
+            break;
+
+        case kBGR_101010x_XR_SkColorType:
+            SkASSERT(false);
+            break;
+
+        case kBGR_101010x_SkColorType:
+            p->append(SkRasterPipelineOp::gather_1010102, ctx);
+            p->append(SkRasterPipelineOp::force_opaque);
+            p->append(SkRasterPipelineOp::swap_rb);
+            break;
+
+        case kBGRA_8888_SkColorType:
+            p->append(SkRasterPipelineOp::gather_8888, ctx);
+            p->append(SkRasterPipelineOp::swap_rb);
+            break;
+
+        case kSRGBA_8888_SkColorType:
+            p->append(SkRasterPipelineOp::gather_8888, ctx);
+            p->append_transfer_function(*skcms_sRGB_TransferFunction());
+            break;
+
+        case kUnknown_SkColorType: SkASSERT(false);
+    }
+    if (level->decalCtx) {
+        p->append(SkRasterPipelineOp::check_decal_mask, level->decalCtx);
+    }
+}
+
+void append_sample_level(SkRasterPipeline* p,
+                         const MipLevelHelper* level,
+                         const SkSamplingOptions& sampling,
+                         SkTileMode tileModeX,
+                         SkTileMode tileModeY,
+                         SkRasterPipeline_SamplerCtx* sampler) {
+    auto sample = [&](SkRasterPipelineOp setup_x, SkRasterPipelineOp setup_y) {
+        p->append(setup_x, sampler);
+        p->append(setup_y, sampler);
+        append_tiling_and_gather(p, level, tileModeX, tileModeY);
+        p->append(SkRasterPipelineOp::accumulate, sampler);
+    };
+
+    if (sampling.useCubic) {
+        SkImageShader::CubicResamplerMatrix(sampling.cubic.B, sampling.cubic.C)
+                .getColMajor(sampler->weights);
+
+        p->append(SkRasterPipelineOp::bicubic_setup, sampler);
+
+        sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_n3y);
+        sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_n3y);
+        sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_n3y);
+        sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_n3y);
+
+        sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_n1y);
+        sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_n1y);
+        sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_n1y);
+        sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_n1y);
+
+        sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_p1y);
+        sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_p1y);
+        sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_p1y);
+        sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_p1y);
+
+        sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_p3y);
+        sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_p3y);
+        sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_p3y);
+        sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_p3y);
+
+        p->append(SkRasterPipelineOp::move_dst_src);
+    } else if (sampling.filter == SkFilterMode::kLinear) {
+        p->append(SkRasterPipelineOp::bilinear_setup, sampler);
+
+        sample(SkRasterPipelineOp::bilinear_nx, SkRasterPipelineOp::bilinear_ny);
+        sample(SkRasterPipelineOp::bilinear_px, SkRasterPipelineOp::bilinear_ny);
+        sample(SkRasterPipelineOp::bilinear_nx, SkRasterPipelineOp::bilinear_py);
+        sample(SkRasterPipelineOp::bilinear_px, SkRasterPipelineOp::bilinear_py);
+
+        p->append(SkRasterPipelineOp::move_dst_src);
+    } else {
+        append_tiling_and_gather(p, level, tileModeX, tileModeY);
+    }
+}
+
 }  // namespace
 
 static SkSamplingOptions tweak_sampling(SkSamplingOptions sampling, const SkMatrix& matrix) {
@@ -679,6 +860,11 @@ bool SkImageShader::appendStages(const SkStageRec& rec, const MatrixRec& mRec) c
         baseInv.normalizePerspective();
     }
 
+    if (samples_yuva_planes(fImage.get(), fTileModeX, fTileModeY, sampling)) {
+        return this->appendYUVAStages(rec, mRec, sampling,
+                                      mRec.totalMatrixIsValid() ? &baseInv : nullptr);
+    }
+
     SkASSERT(!sampling.useCubic || sampling.mipmap == SkMipmapMode::kNone);
     auto* access = SkMipmapAccessor::Make(alloc, fImage.get(), baseInv, sampling.mipmap);
     if (!access) {
@@ -716,110 +902,6 @@ bool SkImageShader::appendStages(const SkStageRec& rec, const MatrixRec& mRec) c
         p->append(SkRasterPipelineOp::mipmap_linear_init, mipmapCtx);
     }
 
-    const bool decalBothAxes = fTileModeX == SkTileMode::kDecal && fTileModeY == SkTileMode::kDecal;
-
-    auto append_tiling_and_gather = [&](const MipLevelHelper* level) {
-        if (decalBothAxes) {
-            p->append(SkRasterPipelineOp::decal_x_and_y,  level->decalCtx);
-        } else {
-            switch (fTileModeX) {
-                case SkTileMode::kClamp: /* The gather_xxx stage will clamp for us. */
-                    break;
-                case SkTileMode::kMirror:
-                    p->append(SkRasterPipelineOp::mirror_x, level->limitX);
-                    break;
-                case SkTileMode::kRepeat:
-                    p->append(SkRasterPipelineOp::repeat_x, level->limitX);
-                    break;
-                case SkTileMode::kDecal:
-                    p->append(SkRasterPipelineOp::decal_x, level->decalCtx);
-                    break;
-            }
-            switch (fTileModeY) {
-                case SkTileMode::kClamp: /* The gather_xxx stage will clamp for us. */
-                    break;
-                case SkTileMode::kMirror:
-                    p->append(SkRasterPipelineOp::mirror_y, level->limitY);
-                    break;
-                case SkTileMode::kRepeat:
-                    p->append(SkRasterPipelineOp::repeat_y, level->limitY);
-                    break;
-                case SkTileMode::kDecal:
-                    p->append(SkRasterPipelineOp::decal_y, level->decalCtx);
-                    break;
-            }
-        }
-
-        void* ctx = level->gather;
-        switch (level->pm.colorType()) {
-            case kAlpha_8_SkColorType:      p->append(SkRasterPipelineOp::gather_a8,    ctx); break;
-            case kA16_unorm_SkColorType:    p->append(SkRasterPipelineOp::gather_a16,   ctx); break;
-            case kA16_float_SkColorType:    p->append(SkRasterPipelineOp::gather_af16,  ctx); break;
-            case kRGB_565_SkColorType:      p->append(SkRasterPipelineOp::gather_565,   ctx); break;
-            case kARGB_4444_SkColorType:    p->append(SkRasterPipelineOp::gather_4444,  ctx); break;
-            case kR8G8_unorm_SkColorType:   p->append(SkRasterPipelineOp::gather_rg88,  ctx); break;
-            case kR16G16_unorm_SkColorType: p->append(SkRasterPipelineOp::gather_rg1616,ctx); break;
-            case kR16G16_float_SkColorType: p->append(SkRasterPipelineOp::gather_rgf16, ctx); break;
-            case kRGBA_8888_SkColorType:    p->append(SkRasterPipelineOp::gather_8888,  ctx); break;
-
-            case kRGBA_1010102_SkColorType:
-                p->append(SkRasterPipelineOp::gather_1010102, ctx);
-                break;
-
-            case kR16G16B16A16_unorm_SkColorType:
-                p->append(SkRasterPipelineOp::gather_16161616, ctx);
-                break;
-
-            case kRGBA_F16Norm_SkColorType:
-            case kRGBA_F16_SkColorType:     p->append(SkRasterPipelineOp::gather_f16,   ctx); break;
-            case kRGBA_F32_SkColorType:     p->append(SkRasterPipelineOp::gather_f32,   ctx); break;
-
-            case kGray_8_SkColorType:       p->append(SkRasterPipelineOp::gather_a8,    ctx);
-                                            p->append(SkRasterPipelineOp::alpha_to_gray    ); break;
-
-            case kR8_unorm_SkColorType:     p->append(SkRasterPipelineOp::gather_a8,    ctx);
-                                            p->append(SkRasterPipelineOp::alpha_to_red     ); break;
-
-            case kRGB_888x_SkColorType:     p->append(SkRasterPipelineOp::gather_8888,  ctx);
-                                            p->append(SkRasterPipelineOp::force_opaque     ); break;
-
-            case kBGRA_1010102_SkColorType:
-                p->append(SkRasterPipelineOp::gather_1010102, ctx);
-                p->append(SkRasterPipelineOp::swap_rb);
-                break;
-
-            case kRGB_101010x_SkColorType:
-                p->append(SkRasterPipelineOp::gather_1010102, ctx);
-                p->append(SkRasterPipelineOp::force_opaque);
-                break;
-
-            case kBGR_101010x_XR_SkColorType:
-                SkASSERT(false);
-                break;
-
-            case kBGR_101010x_SkColorType:
-                p->append(SkRasterPipelineOp::gather_1010102, ctx);
-                p->append(SkRasterPipelineOp::force_opaque);
-                p->append(SkRasterPipelineOp::swap_rb);
-                break;
-
-            case kBGRA_8888_SkColorType:
-                p->append(SkRasterPipelineOp::gather_8888, ctx);
-                p->append(SkRasterPipelineOp::swap_rb);
-                break;
-
-            case kSRGBA_8888_SkColorType:
-                p->append(SkRasterPipelineOp::gather_8888, ctx);
-                p->append_transfer_function(*skcms_sRGB_TransferFunction());
-                break;
-
-            case kUnknown_SkColorType: SkASSERT(false);
-        }
-        if (level->decalCtx) {
-            p->append(SkRasterPipelineOp::check_decal_mask, level->decalCtx);
-        }
-    };
-
     auto append_misc = [&] {
         SkColorSpace* cs = upper.pm.colorSpace();
         SkAlphaType   at = upper.pm.alphaType();
@@ -877,65 +959,92 @@ bool SkImageShader::appendStages(const SkStageRec& rec, const MatrixRec& mRec) c
     // This context can be shared by both levels when doing linear mipmap filtering
     SkRasterPipeline_SamplerCtx* sampler = alloc->make<SkRasterPipeline_SamplerCtx>();
 
-    auto sample = [&](SkRasterPipelineOp setup_x,
-                      SkRasterPipelineOp setup_y,
-                      const MipLevelHelper* level) {
-        p->append(setup_x, sampler);
-        p->append(setup_y, sampler);
-        append_tiling_and_gather(level);
-        p->append(SkRasterPipelineOp::accumulate, sampler);
-    };
+    append_sample_level(p, &upper, sampling, fTileModeX, fTileModeY, sampler);
 
-    auto sample_level = [&](const MipLevelHelper* level) {
-        if (sampling.useCubic) {
-            CubicResamplerMatrix(sampling.cubic.B, sampling.cubic.C).getColMajor(sampler->weights);
+    if (mipmapCtx) {
+        p->append(SkRasterPipelineOp::mipmap_linear_update, mipmapCtx);
+        append_sample_level(p, &lower, sampling, fTileModeX, fTileModeY, sampler);
+        p->append(SkRasterPipelineOp::mipmap_linear_finish, mipmapCtx);
+    }
 
-            p->append(SkRasterPipelineOp::bicubic_setup, sampler);
+    return append_misc();
+}
 
-            sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_n3y, level);
-            sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_n3y, level);
-            sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_n3y, level);
-            sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_n3y, level);
+bool SkImageShader::appendYUVAStages(const SkStageRec& rec,
+                                     const MatrixRec& mRec,
+                                     const SkSamplingOptions& sampling,
+                                     const SkMatrix* baseInv) const {
+    SkRasterPipeline* p = rec.fPipeline;
+    SkArenaAlloc* alloc = rec.fAlloc;
 
-            sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_n1y, level);
-            sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_n1y, level);
-            sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_n1y, level);
-            sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_n1y, level);
+    const SkYUVAPixmaps& pixmaps = static_cast<const SkImage_RasterYUVA*>(fImage.get())->pixmaps();
+    const SkYUVAInfo& yuvaInfo = pixmaps.yuvaInfo();
 
-            sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_p1y, level);
-            sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_p1y, level);
-            sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_p1y, level);
-            sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_p1y, level);
+    // The planes are stored as encoded, before the image's origin is applied.
+    SkMatrix imageToEncoded;
+    if (!yuvaInfo.originMatrix().invert(&imageToEncoded)) {
+        return false;
+    }
 
-            sample(SkRasterPipelineOp::bicubic_n3x, SkRasterPipelineOp::bicubic_p3y, level);
-            sample(SkRasterPipelineOp::bicubic_n1x, SkRasterPipelineOp::bicubic_p3y, level);
-            sample(SkRasterPipelineOp::bicubic_p1x, SkRasterPipelineOp::bicubic_p3y, level);
-            sample(SkRasterPipelineOp::bicubic_p3x, SkRasterPipelineOp::bicubic_p3y, level);
+    if (!mRec.apply(rec)) {
+        return false;
+    }
 
-            p->append(SkRasterPipelineOp::move_dst_src);
-        } else if (sampling.filter == SkFilterMode::kLinear) {
-            p->append(SkRasterPipelineOp::bilinear_setup, sampler);
+    auto* yuvaCtx = alloc->make<SkRasterPipeline_YUVACtx>();
+    SkColorMatrix_YUV2RGB(yuvaInfo.yuvColorSpace(), yuvaCtx->matrix);
+    p->append(SkRasterPipelineOp::yuva_init, yuvaCtx);
+
+    const SkYUVAInfo::YUVALocations locations = pixmaps.toYUVALocations();
+    auto* sampler = alloc->make<SkRasterPipeline_SamplerCtx>();
+    for (int i = 0; i < pixmaps.numPlanes(); ++i) {
+        MipLevelHelper plane;
+        plane.pm = pixmaps.plane(i);
+        auto [ssx, ssy] = yuvaInfo.planeSubsamplingFactors(i);
+        plane.inv = SkMatrix::Scale(1.f/ssx, 1.f/ssy);
+        plane.inv.preConcat(imageToEncoded);
+
+        // Subsampled planes are upsampled with at least bilinear filtering, rather than each of
+        // their pixels being repeated.
+        SkSamplingOptions planeSampling = sampling.useCubic ? SkSamplingOptions(sampling.cubic)
+                                                            : SkSamplingOptions(sampling.filter);
+        if (!sampling.useCubic) {
+            if (ssx != 1 || ssy != 1) {
+                planeSampling = SkSamplingOptions(SkFilterMode::kLinear);
+            } else if (baseInv) {
+                planeSampling = tweak_sampling(planeSampling,
+                                               SkMatrix::Concat(plane.inv, *baseInv));
+            }
+        }
+        plane.allocAndInit(alloc, planeSampling, fTileModeX, fTileModeY);
 
-            sample(SkRasterPipelineOp::bilinear_nx, SkRasterPipelineOp::bilinear_ny, level);
-            sample(SkRasterPipelineOp::bilinear_px, SkRasterPipelineOp::bilinear_ny, level);
-            sample(SkRasterPipelineOp::bilinear_nx, SkRasterPipelineOp::bilinear_py, level);
-            sample(SkRasterPipelineOp::bilinear_px, SkRasterPipelineOp::bilinear_py, level);
+        p->append_matrix(alloc, plane.inv);
+        append_sample_level(p, &plane, planeSampling, fTileModeX, fTileModeY, sampler);
 
-            p->append(SkRasterPipelineOp::move_dst_src);
-        } else {
-            append_tiling_and_gather(level);
+        auto* planeCtx = alloc->make<SkRasterPipeline_YUVAPlaneCtx>();
+        planeCtx->yuva = yuvaCtx;
+        std::fill_n(planeCtx->channel, 4, -1);
+        for (int c = 0; c < SkYUVAInfo::kYUVAChannelCount; ++c) {
+            if (locations[c].fPlane == i) {
+                planeCtx->channel[static_cast<int>(locations[c].fChannel)] = c;
+            }
         }
-    };
+        p->append(SkRasterPipelineOp::yuva_store, planeCtx);
+    }
+    p->append(SkRasterPipelineOp::yuva_finish, yuvaCtx);
 
-    sample_level(&upper);
+    // The YUV to RGB matrix, like bicubic filtering, can produce values outside [0,1].
+    p->append(SkRasterPipelineOp::clamp_01);
 
-    if (mipmapCtx) {
-        p->append(SkRasterPipelineOp::mipmap_linear_update, mipmapCtx);
-        sample_level(&lower);
-        p->append(SkRasterPipelineOp::mipmap_linear_finish, mipmapCtx);
+    SkAlphaType at = kOpaque_SkAlphaType;
+    if (yuvaInfo.hasAlpha()) {
+        p->append(SkRasterPipelineOp::premul);
+        at = kPremul_SkAlphaType;
     }
-
-    return append_misc();
+    if (!fRaw) {
+        alloc->make<SkColorSpaceXformSteps>(fImage->colorSpace(), at,
+                                            rec.fDstCS, kPremul_SkAlphaType)->apply(p);
+    }
+    return true;
 }
 
 #if defined(SK_ENABLE_SKVM)
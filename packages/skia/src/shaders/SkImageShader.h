@@ -56,6 +56,8 @@ public:
 
     bool isOpaque() const override;
 
+    const SkSamplingOptions& sampling() const { return fSampling; }
+
 #if defined(SK_GANESH)
     std::unique_ptr<GrFragmentProcessor> asFragmentProcessor(const GrFPArgs&,
                                                              const MatrixRec&) const override;
@@ -78,6 +80,12 @@ private:
 
     bool appendStages(const SkStageRec&, const MatrixRec&) const override;
 
+    // Samples each plane of a SkImage_RasterYUVA and converts the result to RGBA.
+    bool appendYUVAStages(const SkStageRec&,
+                          const MatrixRec&,
+                          const SkSamplingOptions&,
+                          const SkMatrix* baseInv) const;
+
 #if defined(SK_ENABLE_SKVM)
     skvm::Color program(skvm::Builder*,
                         skvm::Coord device,
@@ -12,8 +12,8 @@
 #include "include/core/SkShader.h"
 #include "include/core/SkString.h"
 #include "include/core/SkUnPreMultiply.h"
-#include "include/private/base/SkTPin.h"
 #include "src/base/SkArenaAlloc.h"
+#include "src/base/SkVx.h"
 #include "src/core/SkMatrixProvider.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkVM.h"
@@ -296,16 +296,17 @@ public:
         void shadeSpan(int x, int y, SkPMColor[], int count) override;
 
     private:
-        SkPMColor shade(const SkPoint& point, StitchData& stitchData) const;
-        SkScalar calculateTurbulenceValueForPoint(int channel,
-                                                  StitchData& stitchData,
-                                                  const SkPoint& point) const;
-        SkScalar noise2D(int channel,
-                         const StitchData& stitchData,
-                         const SkPoint& noiseVector) const;
+        SkPMColor shade(const SkPoint& point) const;
+        // Returns the turbulence of the four channels, in R, G, B, A order.
+        skvx::float4 calculateTurbulenceValueForPoint(const SkPoint& point) const;
+        skvx::float4 noise2D(const StitchData& stitchData, const SkPoint& noiseVector) const;
 
         SkMatrix     fMatrix;
         PaintingData fPaintingData;
+        // The gradients of fPaintingData transposed, so that the gradients of the four channels
+        // at a lattice point can be loaded together and their noise computed at once.
+        float        fGradientX[kBlockSize][4];
+        float        fGradientY[kBlockSize][4];
 
         using INHERITED = Context;
     };
@@ -428,8 +429,8 @@ void SkPerlinNoiseShaderImpl::flatten(SkWriteBuffer& buffer) const {
     buffer.writeInt(fTileSize.fHeight);
 }
 
-SkScalar SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::noise2D(
-        int channel, const StitchData& stitchData, const SkPoint& noiseVector) const {
+skvx::float4 SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::noise2D(
+        const StitchData& stitchData, const SkPoint& noiseVector) const {
     struct Noise {
         int noisePositionIntegerValue;
         int nextNoisePositionIntegerValue;
@@ -444,7 +445,6 @@ SkScalar SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::noise2D(
     };
     Noise noiseX(noiseVector.x());
     Noise noiseY(noiseVector.y());
-    SkScalar u, v;
     const SkPerlinNoiseShaderImpl& perlinNoiseShader = static_cast<const SkPerlinNoiseShaderImpl&>(fShader);
     // If stitching, adjust lattice points accordingly.
     if (perlinNoiseShader.fStitchTiles) {
@@ -474,35 +474,45 @@ SkScalar SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::noise2D(
         return 0;  // Check for pathological inputs.
     }
 
+    // The lattice points are the same for every channel, only their gradients differ, so the
+    // channels are interpolated side by side.
+    auto dot = [this](int b, SkScalar x, SkScalar y) {
+        return skvx::float4::Load(fGradientX[b]) * x + skvx::float4::Load(fGradientY[b]) * y;
+    };
+    auto interp = [](const skvx::float4& a, const skvx::float4& b, SkScalar t) {
+        return a + (b - a) * t;  // SkScalarInterp()
+    };
+
     // This is taken 1:1 from SVG spec: http://www.w3.org/TR/SVG11/filters.html#feTurbulenceElement
     SkPoint fractionValue = SkPoint::Make(noiseX.noisePositionFractionValue,
                                           noiseY.noisePositionFractionValue); // Offset (0,0)
-    u = fPaintingData.fGradient[channel][b00].dot(fractionValue);
+    skvx::float4 u = dot(b00, fractionValue.fX, fractionValue.fY);
     fractionValue.fX -= SK_Scalar1; // Offset (-1,0)
-    v = fPaintingData.fGradient[channel][b10].dot(fractionValue);
-    SkScalar a = SkScalarInterp(u, v, sx);
+    skvx::float4 v = dot(b10, fractionValue.fX, fractionValue.fY);
+    skvx::float4 a = interp(u, v, sx);
     fractionValue.fY -= SK_Scalar1; // Offset (-1,-1)
-    v = fPaintingData.fGradient[channel][b11].dot(fractionValue);
+    v = dot(b11, fractionValue.fX, fractionValue.fY);
     fractionValue.fX = noiseX.noisePositionFractionValue; // Offset (0,-1)
-    u = fPaintingData.fGradient[channel][b01].dot(fractionValue);
-    SkScalar b = SkScalarInterp(u, v, sx);
-    return SkScalarInterp(a, b, sy);
+    u = dot(b01, fractionValue.fX, fractionValue.fY);
+    skvx::float4 b = interp(u, v, sx);
+    return interp(a, b, sy);
 }
 
-SkScalar SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::calculateTurbulenceValueForPoint(
-        int channel, StitchData& stitchData, const SkPoint& point) const {
+skvx::float4 SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::calculateTurbulenceValueForPoint(
+        const SkPoint& point) const {
     const SkPerlinNoiseShaderImpl& perlinNoiseShader = static_cast<const SkPerlinNoiseShaderImpl&>(fShader);
+    StitchData stitchData;
     if (perlinNoiseShader.fStitchTiles) {
         stitchData = fPaintingData.fStitchDataInit;
     }
-    SkScalar turbulenceFunctionResult = 0;
+    skvx::float4 turbulenceFunctionResult = 0;
     SkPoint noiseVector(SkPoint::Make(point.x() * fPaintingData.fBaseFrequency.fX,
                                       point.y() * fPaintingData.fBaseFrequency.fY));
     SkScalar ratio = SK_Scalar1;
     for (int octave = 0; octave < perlinNoiseShader.fNumOctaves; ++octave) {
-        SkScalar noise = noise2D(channel, stitchData, noiseVector);
-        SkScalar numer = (perlinNoiseShader.fType == kFractalNoise_Type) ?
-                            noise : SkScalarAbs(noise);
+        skvx::float4 noise = noise2D(stitchData, noiseVector);
+        skvx::float4 numer = (perlinNoiseShader.fType == kFractalNoise_Type) ?
+                                noise : abs(noise);
         turbulenceFunctionResult += numer / ratio;
         noiseVector.fX *= 2;
         noiseVector.fY *= 2;
@@ -515,31 +525,28 @@ SkScalar SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::calculateTurbulenceV
 
     if (perlinNoiseShader.fType == kFractalNoise_Type) {
         // For kFractalNoise the result is: noise[-1,1] * 0.5 + 0.5
-        turbulenceFunctionResult = SkScalarHalf(turbulenceFunctionResult + 1);
+        turbulenceFunctionResult = (turbulenceFunctionResult + 1) * SK_ScalarHalf;
     }
 
-    if (channel == 3) { // Scale alpha by paint value
-        turbulenceFunctionResult *= SkIntToScalar(getPaintAlpha()) / 255;
-    }
+    // Scale alpha by paint value
+    turbulenceFunctionResult *= skvx::float4(1, 1, 1, SkIntToScalar(getPaintAlpha()) / 255);
 
     // Clamp result
-    return SkTPin(turbulenceFunctionResult, 0.0f, SK_Scalar1);
+    return max(0.0f, min(turbulenceFunctionResult, SK_Scalar1));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-SkPMColor SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::shade(
-        const SkPoint& point, StitchData& stitchData) const {
+SkPMColor SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::shade(const SkPoint& point) const {
     SkPoint newPoint;
     fMatrix.mapPoints(&newPoint, &point, 1);
     newPoint.fX = SkScalarRoundToScalar(newPoint.fX);
     newPoint.fY = SkScalarRoundToScalar(newPoint.fY);
 
+    const skvx::float4 value = calculateTurbulenceValueForPoint(newPoint);
     U8CPU rgba[4];
-    for (int channel = 3; channel >= 0; --channel) {
-        SkScalar value;
-        value = calculateTurbulenceValueForPoint(channel, stitchData, newPoint);
-        rgba[channel] = SkScalarFloorToInt(255 * value);
+    for (int channel = 0; channel < 4; ++channel) {
+        rgba[channel] = SkScalarFloorToInt(255 * value[channel]);
     }
     return SkPreMultiplyARGB(rgba[3], rgba[0], rgba[1], rgba[2]);
 }
@@ -571,14 +578,20 @@ SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::PerlinNoiseShaderContext(
     // (as opposed to 0 based, usually). The same adjustment is in the setData() function.
     fMatrix.setTranslate(-fMatrix.getTranslateX() + SK_Scalar1,
                          -fMatrix.getTranslateY() + SK_Scalar1);
+
+    for (int channel = 0; channel < 4; ++channel) {
+        for (int i = 0; i < kBlockSize; ++i) {
+            fGradientX[i][channel] = fPaintingData.fGradient[channel][i].fX;
+            fGradientY[i][channel] = fPaintingData.fGradient[channel][i].fY;
+        }
+    }
 }
 
 void SkPerlinNoiseShaderImpl::PerlinNoiseShaderContext::shadeSpan(
         int x, int y, SkPMColor result[], int count) {
     SkPoint point = SkPoint::Make(SkIntToScalar(x), SkIntToScalar(y));
-    StitchData stitchData;
     for (int i = 0; i < count; ++i) {
-        result[i] = shade(point, stitchData);
+        result[i] = shade(point);
         point.fX += SK_Scalar1;
     }
 }
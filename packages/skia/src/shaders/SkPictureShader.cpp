@@ -10,6 +10,8 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkImage.h"
+#include "include/private/base/SkMutex.h"
+#include "include/private/base/SkTArray.h"
 #include "src/base/SkArenaAlloc.h"
 #include "src/core/SkImageInfoPriv.h"
 #include "src/core/SkImagePriv.h"
@@ -25,6 +27,9 @@
 #include "src/shaders/SkImageShader.h"
 #include "src/shaders/SkLocalMatrixShader.h"
 
+#include <atomic>
+#include <cmath>
+
 #if defined(SK_GANESH)
 #include "include/gpu/GrDirectContext.h"
 #include "include/gpu/GrRecordingContext.h"
@@ -122,8 +127,41 @@ struct ImageFromPictureRec : public SkResourceCache::Rec {
     }
 };
 
+// A tile being rasterized. Other threads that need the same tile wait for fDone, which the
+// rasterizing thread holds until the tile is in the cache.
+struct TileInFlight : public SkNVRefCnt<TileInFlight> {
+    explicit TileInFlight(const ImageFromPictureKey& key) : fKey(key) {}
+
+    const ImageFromPictureKey fKey;
+    SkMutex                   fDone;
+};
+
+static SkMutex& tiles_in_flight_mutex() {
+    static SkMutex& mutex = *(new SkMutex);
+    return mutex;
+}
+
+static skia_private::TArray<sk_sp<TileInFlight>>& tiles_in_flight() {
+    static auto& tiles = *(new skia_private::TArray<sk_sp<TileInFlight>>);
+    return tiles;
+}
+
+std::atomic<int> gRasterCacheHits{0};
+std::atomic<int> gRasterCacheLargerTileHits{0};
+std::atomic<int> gRasterCacheMisses{0};
+std::atomic<int> gRasterCacheCoalesced{0};
+
 } // namespace
 
+SkPictureShader::RasterCacheStats SkPictureShader::GetRasterCacheStats() {
+    RasterCacheStats stats;
+    stats.fHits = gRasterCacheHits.load();
+    stats.fLargerTileHits = gRasterCacheLargerTileHits.load();
+    stats.fMisses = gRasterCacheMisses.load();
+    stats.fCoalesced = gRasterCacheCoalesced.load();
+    return stats;
+}
+
 SkPictureShader::SkPictureShader(sk_sp<SkPicture> picture,
                                  SkTileMode tmx,
                                  SkTileMode tmy,
@@ -191,6 +229,48 @@ static sk_sp<SkColorSpace> ref_or_srgb(SkColorSpace* cs) {
     return cs ? sk_ref_sp(cs) : SkColorSpace::MakeSRGB();
 }
 
+// With SK_QUANTIZE_PICTURE_SHADER_TILE_SCALES defined, filtered shaders rasterize their tiles at
+// the draw's scale rounded up to a power of 2^(1/4), i.e. at most about 19% larger than needed, so
+// that draws whose scale drifts (as in an animation) keep hitting the same cached tile.
+static constexpr int kScaleBucketsPerOctave = 4;
+
+static bool quantizes_scale(SkFilterMode filter) {
+#if defined(SK_QUANTIZE_PICTURE_SHADER_TILE_SCALES)
+    // Nearest sampling shows every pixel of the tile, so only filtered tiles are rasterized at a
+    // quantized scale, or sampled from a tile for a larger scale.
+    return filter != SkFilterMode::kNearest;
+#else
+    return false;
+#endif
+}
+
+// Returns |scale| rounded up to its bucket, or to |bucketsUp| buckets above that.
+static SkScalar quantize_scale(SkScalar scale, int bucketsUp) {
+    if (!(scale > 0) || !SkScalarIsFinite(scale)) {
+        return scale;
+    }
+    // Scales a fraction of a percent above a bucket round down to it, so that a 1:1 matrix with
+    // some rounding error still rasterizes the tile at 1:1.
+    const float bucket = std::ceil(std::log2(scale) * kScaleBucketsPerOctave - 1 / 64.f);
+    return std::exp2((bucket + bucketsUp) / kScaleBucketsPerOctave);
+}
+
+// Returns the scale from the tile's bounds to device space.
+static SkSize tile_scale(const SkRect& bounds, const SkMatrix& totalM) {
+    SkSize size;
+    // Use a rotation-invariant scale
+    if (!totalM.decomposeScale(&size, nullptr)) {
+        SkPoint center = {bounds.centerX(), bounds.centerY()};
+        SkScalar area = SkMatrixPriv::DifferentialAreaScale(totalM, center);
+        if (!SkScalarIsFinite(area) || SkScalarNearlyZero(area)) {
+            size = {1, 1}; // ill-conditioned matrix
+        } else {
+            size.fWidth = size.fHeight = SkScalarSqrt(area);
+        }
+    }
+    return size;
+}
+
 struct CachedImageInfo {
     bool           success;
     SkSize         tileScale;      // Additional scale factors to apply when sampling image.
@@ -203,20 +283,16 @@ struct CachedImageInfo {
                                 SkColorType dstColorType,
                                 SkColorSpace* dstColorSpace,
                                 const int maxTextureSize,
-                                const SkSurfaceProps& propsIn) {
+                                const SkSurfaceProps& propsIn,
+                                bool quantizeScale,
+                                int scaleBucketsUp = 0) {
         SkSurfaceProps props = propsIn.cloneWithPixelGeometry(kUnknown_SkPixelGeometry);
 
         const SkSize scaledSize = [&]() {
-            SkSize size;
-            // Use a rotation-invariant scale
-            if (!totalM.decomposeScale(&size, nullptr)) {
-                SkPoint center = {bounds.centerX(), bounds.centerY()};
-                SkScalar area = SkMatrixPriv::DifferentialAreaScale(totalM, center);
-                if (!SkScalarIsFinite(area) || SkScalarNearlyZero(area)) {
-                    size = {1, 1}; // ill-conditioned matrix
-                } else {
-                    size.fWidth = size.fHeight = SkScalarSqrt(area);
-                }
+            SkSize size = tile_scale(bounds, totalM);
+            if (quantizeScale) {
+                size.set(quantize_scale(size.width(), scaleBucketsUp),
+                         quantize_scale(size.height(), scaleBucketsUp));
             }
             size.fWidth  *= bounds.width();
             size.fHeight *= bounds.height();
@@ -273,6 +349,72 @@ struct CachedImageInfo {
     }
 };
 
+// Rasterizes the tile described by |info| and adds it to the cache under |key|, unless another
+// thread is already doing so, in which case this waits for that thread's tile.
+static sk_sp<SkImage> rasterize_tile(const ImageFromPictureKey& key,
+                                     const CachedImageInfo& info,
+                                     SkPicture* picture) {
+    auto rasterize = [&]() -> sk_sp<SkImage> {
+        gRasterCacheMisses++;
+        sk_sp<SkImage> image =
+                info.makeImage(SkSurfaces::Raster(info.imageInfo, &info.props), picture);
+        if (image) {
+            SkResourceCache::Add(new ImageFromPictureRec(key, image));
+            SkPicturePriv::AddedToCache(picture);
+        }
+        return image;
+    };
+
+    sk_sp<TileInFlight> tile;
+    bool rasterizing = false;
+    {
+        SkAutoMutexExclusive lock(tiles_in_flight_mutex());
+        for (const sk_sp<TileInFlight>& inFlight : tiles_in_flight()) {
+            if (inFlight->fKey == key) {
+                tile = inFlight;
+                break;
+            }
+        }
+        if (!tile) {
+            tile = sk_make_sp<TileInFlight>(key);
+            tile->fDone.acquire();
+            tiles_in_flight().push_back(tile);
+            rasterizing = true;
+        }
+    }
+
+    sk_sp<SkImage> image;
+    if (!rasterizing) {
+        tile->fDone.acquire();
+        tile->fDone.release();
+        if (SkResourceCache::Find(key, ImageFromPictureRec::Visitor, &image)) {
+            gRasterCacheCoalesced++;
+            return image;
+        }
+        // The other thread failed, or its tile was purged already.
+        return rasterize();
+    }
+
+    // Another thread may have finished the tile between our miss and registering it.
+    if (SkResourceCache::Find(key, ImageFromPictureRec::Visitor, &image)) {
+        gRasterCacheHits++;
+    } else {
+        image = rasterize();
+    }
+    {
+        SkAutoMutexExclusive lock(tiles_in_flight_mutex());
+        auto& tiles = tiles_in_flight();
+        for (int i = 0; i < tiles.size(); ++i) {
+            if (tiles[i] == tile) {
+                tiles.removeShuffle(i);
+                break;
+            }
+        }
+    }
+    tile->fDone.release();
+    return image;
+}
+
 // Returns a cached image shader, which wraps a single picture tile at the given
 // CTM/local matrix.  Also adjusts the local matrix for tile scaling.
 sk_sp<SkShader> SkPictureShader::rasterShader(const SkMatrix& totalM,
@@ -280,31 +422,59 @@ sk_sp<SkShader> SkPictureShader::rasterShader(const SkMatrix& totalM,
                                               SkColorSpace* dstColorSpace,
                                               const SkSurfaceProps& propsIn) const {
     const int maxTextureSize_NotUsedForCPU = 0;
-    CachedImageInfo info = CachedImageInfo::Make(fTile,
-                                                 totalM,
-                                                 dstColorType, dstColorSpace,
-                                                 maxTextureSize_NotUsedForCPU,
-                                                 propsIn);
+    const bool quantizeScale = quantizes_scale(fFilter);
+    auto makeInfo = [&](int scaleBucketsUp) {
+        return CachedImageInfo::Make(fTile,
+                                     totalM,
+                                     dstColorType, dstColorSpace,
+                                     maxTextureSize_NotUsedForCPU,
+                                     propsIn,
+                                     quantizeScale,
+                                     scaleBucketsUp);
+    };
+    auto makeKey = [&](const CachedImageInfo& info) {
+        return ImageFromPictureKey(info.imageInfo.colorSpace(), info.imageInfo.colorType(),
+                                   fPicture->uniqueID(), fTile, info.tileScale, info.props);
+    };
+
+    CachedImageInfo info = makeInfo(0);
     if (!info.success) {
         return nullptr;
     }
+    ImageFromPictureKey key = makeKey(info);
 
-    ImageFromPictureKey key(info.imageInfo.colorSpace(), info.imageInfo.colorType(),
-                            fPicture->uniqueID(), fTile, info.tileScale, info.props);
-
+    SkSamplingOptions sampling(fFilter);
     sk_sp<SkImage> image;
-    if (!SkResourceCache::Find(key, ImageFromPictureRec::Visitor, &image)) {
-        image = info.makeImage(SkSurfaces::Raster(info.imageInfo, &info.props), fPicture.get());
+    if (SkResourceCache::Find(key, ImageFromPictureRec::Visitor, &image)) {
+        gRasterCacheHits++;
+    } else if (quantizeScale) {
+        // A tile for up to twice the scale is minified with mips rather than rasterizing another,
+        // e.g. for each step of an animation that zooms out.
+        for (int bucketsUp = 1; bucketsUp <= kScaleBucketsPerOctave; ++bucketsUp) {
+            CachedImageInfo largerInfo = makeInfo(bucketsUp);
+            if (!largerInfo.success ||
+                largerInfo.imageInfo.dimensions() == info.imageInfo.dimensions()) {
+                // Clamped to the maximum tile size.
+                break;
+            }
+            if (SkResourceCache::Find(makeKey(largerInfo), ImageFromPictureRec::Visitor,
+                                      &image)) {
+                gRasterCacheLargerTileHits++;
+                info = largerInfo;
+                sampling = SkSamplingOptions(fFilter, SkMipmapMode::kLinear);
+                break;
+            }
+        }
+    }
+    if (!image) {
+        image = rasterize_tile(key, info, fPicture.get());
         if (!image) {
             return nullptr;
         }
-
-        SkResourceCache::Add(new ImageFromPictureRec(key, image));
-        SkPicturePriv::AddedToCache(fPicture.get());
     }
     // Scale the image to the original picture size.
     auto lm = SkMatrix::Scale(1.f/info.tileScale.width(), 1.f/info.tileScale.height());
-    return image->makeShader(fTmx, fTmy, SkSamplingOptions(fFilter), &lm);
+    return image->makeShader(fTmx, fTmy, sampling, &lm);
 }
 
 bool SkPictureShader::appendStages(const SkStageRec& rec, const MatrixRec& mRec) const {
@@ -386,7 +556,8 @@ std::unique_ptr<GrFragmentProcessor> SkPictureShader::asFragmentProcessor(
                                       dstColorType,
                                       dstCS.get(),
                                       ctx->priv().caps()->maxTextureSize(),
-                                      args.fSurfaceProps);
+                                      args.fSurfaceProps,
+                                      quantizes_scale(fFilter));
     if (!info.success) {
         return nullptr;
     }
@@ -475,7 +646,8 @@ void SkPictureShader::addToKey(const skgpu::graphite::KeyContext& keyContext,
                                                  /* dstColorType= */ kRGBA_8888_SkColorType,
                                                  /* dstColorSpace= */ nullptr,
                                                  caps->maxTextureSize(),
-                                                 props);
+                                                 props,
+                                                 /* quantizeScale= */ false);
     if (!info.success) {
         SolidColorShaderBlock::BeginBlock(keyContext, builder, gatherer, {1, 0, 0, 1});
         builder->endBlock();
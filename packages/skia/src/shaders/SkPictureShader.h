@@ -39,6 +39,15 @@ public:
 
     SkPictureShader(sk_sp<SkPicture>, SkTileMode, SkTileMode, SkFilterMode, const SkRect*);
 
+    // Counts of how the raster backend found the tiles it drew, across all picture shaders.
+    struct RasterCacheStats {
+        int fHits = 0;            // The tile for the draw's scale was cached.
+        int fLargerTileHits = 0;  // A tile for a larger scale was cached, and sampled with mips.
+        int fMisses = 0;          // The tile was rasterized.
+        int fCoalesced = 0;       // Another thread was rasterizing the tile, and it waited.
+    };
+    static RasterCacheStats GetRasterCacheStats();
+
 protected:
     SkPictureShader(SkReadBuffer&);
     void flatten(SkWriteBuffer&) const override;
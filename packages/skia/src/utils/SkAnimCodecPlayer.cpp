@@ -13,6 +13,7 @@
 #include "include/core/SkBlendMode.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMatrix.h"
@@ -21,7 +22,9 @@
 #include "include/core/SkSamplingOptions.h"
 #include "include/core/SkSize.h"
 #include "include/core/SkTypes.h"
+#include "include/private/base/SkTo.h"
 #include "src/codec/SkCodecImageGenerator.h"
+#include "src/core/SkTaskGroup.h"
 
 #include <algorithm>
 #include <cstddef>
@@ -33,6 +36,7 @@ SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(st
     fImageInfo = fCodec->getInfo();
     fFrameInfos = fCodec->getFrameInfo();
     fImages.resize(fFrameInfos.size());
+    fLastUse.resize(fFrameInfos.size());
 
     // change the interpretation of fDuration to a end-time for that frame
     size_t dur = 0;
@@ -51,7 +55,65 @@ SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(st
     }
 }
 
-SkAnimCodecPlayer::~SkAnimCodecPlayer() {}
+SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec,
+                                     const PrefetchOptions& options)
+        : SkAnimCodecPlayer(std::move(codec)) {
+    if (!fTotalDuration) {
+        return;
+    }
+    const int frameCount = SkToInt(fFrameInfos.size());
+    fKeepRequiredFrames = true;
+    fFramesAhead = std::clamp(options.fFramesAhead, 0, frameCount - 1);
+
+    if (options.fMemoryBudget) {
+        const SkISize dims = this->dimensions();
+        const size_t frameBytes = std::max<size_t>(
+                fImageInfo.makeDimensions(dims).computeMinByteSize(), 1);
+        // The current frame and those ahead of it are kept whatever the budget.
+        const size_t aheadFrames = fFramesAhead + 1;
+        fMaxFrames = std::max(options.fMemoryBudget / frameBytes, aheadFrames);
+
+        // Spread what is left over the animation, so that a seek has to decode about |interval|
+        // frames at most to rebuild one that depends on those before it. A frame becomes a
+        // checkpoint when another frame depends on it and it takes |interval| decodes to rebuild
+        // from the closest checkpoint or independent frame; those need no checkpoints.
+        const size_t checkpoints = fMaxFrames - aheadFrames;
+        if (checkpoints) {
+            const int interval = SkToInt((frameCount + checkpoints - 1) / checkpoints);
+            std::vector<bool> required(frameCount);
+            for (const SkCodec::FrameInfo& info : fFrameInfos) {
+                if (info.fRequiredFrame != SkCodec::kNoFrame) {
+                    required[info.fRequiredFrame] = true;
+                }
+            }
+            fCheckpoints.resize(frameCount);
+            std::vector<int> decodes(frameCount);
+            for (int i = 0; i < frameCount; ++i) {
+                // A required frame always comes before the frames that require it.
+                const int requiredFrame = fFrameInfos[i].fRequiredFrame;
+                decodes[i] = requiredFrame == SkCodec::kNoFrame || fCheckpoints[requiredFrame]
+                                     ? 1
+                                     : decodes[requiredFrame] + 1;
+                fCheckpoints[i] = required[i] && decodes[i] >= interval &&
+                                  requiredFrame != SkCodec::kNoFrame;
+            }
+        }
+    }
+
+    if (options.fExecutor) {
+        fPrefetchTasks = std::make_unique<SkTaskGroup>(*options.fExecutor);
+    }
+}
+
+SkAnimCodecPlayer::~SkAnimCodecPlayer() {
+    if (fPrefetchTasks) {
+        {
+            SkAutoMutexExclusive lock(fMutex);
+            fPrefetchGeneration++;
+        }
+        fPrefetchTasks->wait();
+    }
+}
 
 SkISize SkAnimCodecPlayer::dimensions() const {
     if (!fCodec) {
@@ -64,13 +126,99 @@ SkISize SkAnimCodecPlayer::dimensions() const {
     return { fImageInfo.width(), fImageInfo.height() };
 }
 
+bool SkAnimCodecPlayer::isAhead(int index) const {
+    const int frameCount = SkToInt(fFrameInfos.size());
+    return (index - fCurrIndex + frameCount) % frameCount <= fFramesAhead;
+}
+
+bool SkAnimCodecPlayer::isCheckpoint(int index) const {
+    return !fCheckpoints.empty() && fCheckpoints[index];
+}
+
+void SkAnimCodecPlayer::cacheFrame(int index, sk_sp<SkImage> image) {
+    if (!fImages[index]) {
+        fCachedFrames++;
+    }
+    fImages[index] = std::move(image);
+    fLastUse[index] = ++fUseCount;
+
+    while (fMaxFrames && fCachedFrames > fMaxFrames) {
+        // Evict the least recently used frame that is not the current one or ahead of it,
+        // sparing checkpoints for as long as there is anything else. |index| is spared too, since
+        // the caller may be about to decode a frame from it.
+        int victim = -1;
+        bool victimIsCheckpoint = false;
+        for (int i = 0; i < SkToInt(fImages.size()); ++i) {
+            if (!fImages[i] || i == index || this->isAhead(i)) {
+                continue;
+            }
+            const bool checkpoint = this->isCheckpoint(i);
+            if (victim < 0 || (victimIsCheckpoint && !checkpoint) ||
+                (victimIsCheckpoint == checkpoint && fLastUse[i] < fLastUse[victim])) {
+                victim = i;
+                victimIsCheckpoint = checkpoint;
+            }
+        }
+        if (victim < 0) {
+            break;
+        }
+        fImages[victim] = nullptr;
+        fCachedFrames--;
+    }
+}
+
 sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
     SkASSERT((unsigned)index < fFrameInfos.size());
 
-    if (fImages[index]) {
-        return fImages[index];
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        if (fImages[index]) {
+            fLastUse[index] = ++fUseCount;
+            return fImages[index];
+        }
     }
 
+    SkAutoMutexExclusive decodeLock(fDecodeMutex);
+
+    // With PrefetchOptions, walk back along the frames this one depends on, to the closest one
+    // that is decoded (or that depends on nothing), then decode forward from there, keeping each
+    // frame on the way. Otherwise only this frame is kept, and the codec decodes the frames it
+    // depends on itself unless the one it requires is decoded already.
+    std::vector<int> chain;
+    sk_sp<SkImage> image;
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        for (int i = index;;) {
+            if (fImages[i]) {
+                // Another thread may have decoded |index| itself while we waited.
+                image = fImages[i];
+                fLastUse[i] = ++fUseCount;
+                break;
+            }
+            chain.push_back(i);
+            const int requiredFrame = fFrameInfos[i].fRequiredFrame;
+            if (requiredFrame == SkCodec::kNoFrame) {
+                break;
+            }
+            if (!fKeepRequiredFrames) {
+                image = fImages[requiredFrame];
+                break;
+            }
+            i = requiredFrame;
+        }
+    }
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        image = this->decodeFrame(*it, std::move(image));
+        if (!image) {
+            return nullptr;
+        }
+        SkAutoMutexExclusive lock(fMutex);
+        this->cacheFrame(*it, image);
+    }
+    return image;
+}
+
+sk_sp<SkImage> SkAnimCodecPlayer::decodeFrame(int index, sk_sp<SkImage> requiredImage) {
     size_t rb = fImageInfo.minRowBytes();
     size_t size = fImageInfo.computeByteSize(rb);
     auto data = SkData::MakeUninitialized(size);
@@ -91,8 +239,7 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
         imageInfo = imageInfo.makeAlphaType(kPremul_SkAlphaType);
     }
     const int requiredFrame = fFrameInfos[index].fRequiredFrame;
-    if (requiredFrame != SkCodec::kNoFrame && fImages[requiredFrame]) {
-        auto requiredImage = fImages[requiredFrame];
+    if (requiredFrame != SkCodec::kNoFrame && requiredImage) {
         auto canvas = SkCanvas::MakeRasterDirect(imageInfo, data->writable_data(), rb);
         if (origin != kDefault_SkEncodedOrigin) {
             // The required frame is stored after applying the origin. Undo that,
@@ -125,15 +272,58 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
         canvas->drawImage(image, 0, 0, SkSamplingOptions(), &paint);
         image = SkImages::RasterFromData(imageInfo, std::move(data), rb);
     }
-    return fImages[index] = image;
+    return image;
+}
+
+void SkAnimCodecPlayer::prefetch() {
+    if (!fPrefetchTasks || !fFramesAhead) {
+        return;
+    }
+
+    // A task queued for an earlier current frame stops as soon as it sees a newer generation.
+    int generation;
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        if (fPrefetchedFrom == fCurrIndex) {
+            return;
+        }
+        fPrefetchedFrom = fCurrIndex;
+        generation = ++fPrefetchGeneration;
+    }
+
+    // The executor may run the task right away, on this thread, so no lock is held here.
+    fPrefetchTasks->add([this, generation] {
+        for (int i = 1; i <= fFramesAhead; ++i) {
+            int index;
+            {
+                SkAutoMutexExclusive lock(fMutex);
+                if (generation != fPrefetchGeneration) {
+                    return;
+                }
+                index = (fCurrIndex + i) % SkToInt(fFrameInfos.size());
+            }
+            if (!this->getFrameAt(index)) {
+                return;
+            }
+        }
+    });
 }
 
 sk_sp<SkImage> SkAnimCodecPlayer::getFrame() {
     SkASSERT(fTotalDuration > 0 || fImages.size() == 1);
 
-    return fTotalDuration > 0
-        ? this->getFrameAt(fCurrIndex)
-        : fImages.front();
+    if (!fTotalDuration) {
+        return fImages.front();
+    }
+
+    int index;
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        index = fCurrIndex;
+    }
+    sk_sp<SkImage> image = this->getFrameAt(index);
+    this->prefetch();
+    return image;
 }
 
 bool SkAnimCodecPlayer::seek(uint32_t msec) {
@@ -147,6 +337,7 @@ bool SkAnimCodecPlayer::seek(uint32_t msec) {
                                   [](const SkCodec::FrameInfo& info, uint32_t msec) {
                                       return (uint32_t)info.fDuration <= msec;
                                   });
+    SkAutoMutexExclusive lock(fMutex);
     int prevIndex = fCurrIndex;
     fCurrIndex = lower - fFrameInfos.begin();
     return fCurrIndex != prevIndex;